@@ -0,0 +1,18 @@
+class ListBench extends AIInfo {
+	function GetAuthor()      { return "OpenTTD NoAI Developers Team"; }
+	function GetName()        { return "ListBench"; }
+	function GetShortName()   { return "LBEN"; }
+	function GetDescription() { return "Benchmarks AIList operations on large tile lists. Run it with a high script max_opcode_till_suspend to measure the list itself."; }
+	function GetVersion()     { return 1; }
+	function GetAPIVersion()  { return "13"; }
+	function GetDate()        { return "2022-06-01"; }
+	function CreateInstance() { return "ListBench"; }
+	function UseAsRandomAI()  { return false; }
+	function GetSettings()
+	{
+		AddSetting({name = "size", description = "Size of the square of tiles to list", min_value = 16, max_value = 1024, easy_value = 256, medium_value = 256, hard_value = 256, custom_value = 256, flags = CONFIG_NONE});
+		AddSetting({name = "rounds", description = "Number of times to run each benchmark", min_value = 1, max_value = 100, easy_value = 3, medium_value = 3, hard_value = 3, custom_value = 3, flags = CONFIG_NONE});
+	}
+}
+
+RegisterAI(ListBench());
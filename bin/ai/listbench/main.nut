@@ -0,0 +1,115 @@
+class ListBench extends AIController {
+	size = 0;
+	rounds = 0;
+
+	constructor()
+	{
+		this.size = AIController.GetSetting("size");
+		this.rounds = AIController.GetSetting("rounds");
+	}
+
+	function Start();
+};
+
+/**
+ * Create a list with all tiles in a square at the centre of the map.
+ */
+function ListBench::CreateTileList()
+{
+	local size = min(this.size, min(AIMap.GetMapSizeX(), AIMap.GetMapSizeY()) - 2);
+	local x = (AIMap.GetMapSizeX() - size) / 2;
+	local y = (AIMap.GetMapSizeY() - size) / 2;
+
+	local list = AITileList();
+	list.AddRectangle(AIMap.GetTileIndex(x, y), AIMap.GetTileIndex(x + size - 1, y + size - 1));
+	return list;
+}
+
+/**
+ * Run a benchmark a number of times and print how long it took.
+ * @param name The name of the benchmark.
+ * @param func The function to run; it gets a fresh tile list.
+ */
+function ListBench::Run(name, func)
+{
+	local ticks = 0;
+	local seconds = 0;
+	local count = 0;
+	for (local i = 0; i < this.rounds; i++) {
+		local list = this.CreateTileList();
+		count = list.Count();
+
+		local start_tick = this.GetTick();
+		local start_time = AIDate.GetSystemTime();
+		func(list);
+		ticks += this.GetTick() - start_tick;
+		seconds += AIDate.GetSystemTime() - start_time;
+	}
+	AILog.Info(name + ": " + count + " items, " + ticks + " ticks, " + seconds + " seconds over " + this.rounds + " rounds");
+}
+
+function ListBench::Start()
+{
+	AILog.Info("ListBench started");
+
+	this.Run("AddItem ascending", function(list) {
+		local count = list.Count();
+		local other = AIList();
+		for (local i = 0; i < count; i++) other.AddItem(i, i);
+	});
+
+	this.Run("AddItem shuffled", function(list) {
+		local count = list.Count();
+		local other = AIList();
+		for (local i = 0; i < count; i++) other.AddItem((i * 7919) % count, i);
+		other.Count();
+	});
+
+	this.Run("Valuate DistanceManhattan", function(list) {
+		list.Valuate(AIMap.DistanceManhattan, AIMap.GetTileIndex(1, 1));
+	});
+
+	this.Run("Valuate and iterate by value", function(list) {
+		list.Valuate(AITile.GetHeight);
+		list.Sort(AIList.SORT_BY_VALUE, AIList.SORT_ASCENDING);
+		for (local i = list.Begin(); !list.IsEnd(); i = list.Next()) {}
+		list.Sort(AIList.SORT_BY_VALUE, AIList.SORT_DESCENDING);
+		for (local i = list.Begin(); !list.IsEnd(); i = list.Next()) {}
+	});
+
+	this.Run("SetValue while iterating", function(list) {
+		list.Sort(AIList.SORT_BY_ITEM, AIList.SORT_ASCENDING);
+		for (local i = list.Begin(); !list.IsEnd(); i = list.Next()) list.SetValue(i, i % 1000);
+		list.Sort(AIList.SORT_BY_VALUE, AIList.SORT_ASCENDING);
+		for (local i = list.Begin(); !list.IsEnd(); i = list.Next()) {}
+	});
+
+	this.Run("KeepAboveValue and KeepTop", function(list) {
+		list.Valuate(AIMap.DistanceManhattan, AIMap.GetTileIndex(1, 1));
+		list.KeepAboveValue(list.Count() / 4);
+		list.KeepTop(list.Count() / 2);
+		list.RemoveBottom(list.Count() / 2);
+	});
+
+	this.Run("RemoveItem while iterating", function(list) {
+		list.Valuate(AITile.IsWaterTile);
+		for (local i = list.Begin(); !list.IsEnd(); i = list.Next()) {
+			if (i % 3 == 0) list.RemoveItem(i);
+		}
+	});
+
+	this.Run("KeepList and RemoveList", function(list) {
+		local other = AIList();
+		foreach (tile, value in list) {
+			if (tile % 2 == 0) other.AddItem(tile, value);
+		}
+		local copy = AIList();
+		copy.AddList(list);
+		copy.KeepList(other);
+		list.RemoveList(other);
+		list.AddList(copy);
+	});
+
+	AILog.Info("ListBench done");
+	while (true) this.Sleep(1000);
+}
@@ -64,6 +64,7 @@ function(set_options)
     else()
         option(OPTION_USE_THREADS "Use threads" ON)
     endif()
+    option(OPTION_MAP_LAYOUT_BLOCKS "Allow storing the tiles of the map in blocks; makes every access of the map a bit slower" OFF)
     option(OPTION_USE_NSIS "Use NSIS to create windows installer; enable only for stable releases" OFF)
     option(OPTION_TOOLS_ONLY "Build only tools target" OFF)
     option(OPTION_DOCS_ONLY "Build only docs target" OFF)
@@ -83,6 +84,7 @@ function(show_options)
     message(STATUS "Option Install FHS - ${OPTION_INSTALL_FHS}")
     message(STATUS "Option Use assert - ${OPTION_USE_ASSERTS}")
     message(STATUS "Option Use threads - ${OPTION_USE_THREADS}")
+    message(STATUS "Option Map layout blocks - ${OPTION_MAP_LAYOUT_BLOCKS}")
     message(STATUS "Option Use NSIS - ${OPTION_USE_NSIS}")
 endfunction()
 
@@ -99,6 +101,10 @@ function(add_definitions_based_on_options)
         add_definitions(-DNO_THREADS)
     endif()
 
+    if(OPTION_MAP_LAYOUT_BLOCKS)
+        add_definitions(-DWITH_MAP_LAYOUT_BLOCKS)
+    endif()
+
     if(OPTION_USE_ASSERTS)
         add_definitions(-DWITH_ASSERT)
     else()
@@ -15,6 +15,7 @@
 #include "../network/network.h"
 #include "../window_func.h"
 #include "../framerate_type.h"
+#include "../script/script_thread.hpp"
 #include "ai_scanner.hpp"
 #include "ai_instance.hpp"
 #include "ai_config.hpp"
@@ -76,9 +77,20 @@
 	assert(_settings_game.difficulty.competitor_speed <= 4);
 	if ((AI::frame_counter & ((1 << (4 - _settings_game.difficulty.competitor_speed)) - 1)) != 0) return;
 
+	/* Run the AIs that run any code this tick on threads of their own; it is not worth it for only one. */
+	CompanyMask threaded = 0;
+	if (_settings_game.ai.ai_threads) {
+		for (const Company *c : Company::Iterate()) {
+			if (c->is_ai && c->ai_instance->WillRunScript()) SetBit(threaded, c->index);
+		}
+		if (CountBits(threaded) < 2) threaded = 0;
+	}
+
 	Backup<CompanyID> cur_company(_current_company, FILE_LINE);
 	for (const Company *c : Company::Iterate()) {
 		if (c->is_ai) {
+			if (HasBit(threaded, c->index)) continue;
+
 			PerformanceMeasurer framerate((PerformanceElement)(PFE_AI0 + c->index));
 			cur_company.Change(c->index);
 			c->ai_instance->GameLoop();
@@ -86,6 +98,12 @@
 			PerformanceMeasurer::SetInactive((PerformanceElement)(PFE_AI0 + c->index));
 		}
 	}
+	if (threaded != 0) {
+		RunScriptsOnThreads(threaded, [](CompanyID company) {
+			PerformanceMeasurer framerate((PerformanceElement)(PFE_AI0 + company));
+			Company::Get(company)->ai_instance->GameLoop();
+		});
+	}
 	cur_company.Restore();
 
 	/* Occasionally collect garbage; every 255 ticks do one company.
@@ -109,7 +127,7 @@
 	Backup<CompanyID> cur_company(_current_company, company, FILE_LINE);
 	Company *c = Company::Get(company);
 
-	delete c->ai_instance;
+	DeleteScriptInstance(c->ai_instance);
 	c->ai_instance = nullptr;
 	c->ai_info = nullptr;
 
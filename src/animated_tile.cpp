@@ -14,10 +14,16 @@
 #include "viewport_func.h"
 #include "framerate_type.h"
 
+#include <unordered_map>
+
 #include "safeguards.h"
 
-/** The table/list with animated tiles. */
+/** The table/list with animated tiles. Deleted tiles leave an #INVALID_TILE hole until the next compaction. */
 std::vector<TileIndex> _animated_tiles;
+/** Slot of every animated tile in #_animated_tiles, for constant time lookup and removal. */
+static std::unordered_map<uint32, size_t> _animated_tile_index;
+/** Number of #INVALID_TILE holes in #_animated_tiles. */
+static size_t _animated_tile_holes = 0;
 
 /**
  * Removes the given tile from the animated tile table.
@@ -25,10 +31,13 @@ std::vector<TileIndex> _animated_tiles;
  */
 void DeleteAnimatedTile(TileIndex tile)
 {
-	auto to_remove = std::find(_animated_tiles.begin(), _animated_tiles.end(), tile);
-	if (to_remove != _animated_tiles.end()) {
-		/* The order of the remaining elements must stay the same, otherwise the animation loop may miss a tile. */
-		_animated_tiles.erase(to_remove);
+	auto to_remove = _animated_tile_index.find(tile);
+	if (to_remove != _animated_tile_index.end()) {
+		/* The order of the remaining elements must stay the same, otherwise the animation
+		 * loop may miss a tile. Only mark the slot as free, it gets removed on compaction. */
+		_animated_tiles[to_remove->second] = INVALID_TILE;
+		_animated_tile_index.erase(to_remove);
+		_animated_tile_holes++;
 		MarkTileDirtyByTile(tile);
 	}
 }
@@ -41,7 +50,45 @@ void DeleteAnimatedTile(TileIndex tile)
 void AddAnimatedTile(TileIndex tile)
 {
 	MarkTileDirtyByTile(tile);
-	include(_animated_tiles, tile);
+	if (_animated_tile_index.emplace(tile, _animated_tiles.size()).second) _animated_tiles.push_back(tile);
+}
+
+/**
+ * Remove the holes left by #DeleteAnimatedTile from the animated tile table,
+ * keeping the order of the remaining tiles intact.
+ */
+void CompactAnimatedTiles()
+{
+	if (_animated_tile_holes == 0) return;
+
+	auto first_hole = std::find(_animated_tiles.begin(), _animated_tiles.end(), INVALID_TILE);
+	size_t dest = first_hole - _animated_tiles.begin();
+	for (size_t src = dest + 1; src < _animated_tiles.size(); src++) {
+		TileIndex tile = _animated_tiles[src];
+		if (tile == INVALID_TILE) continue;
+		_animated_tiles[dest] = tile;
+		_animated_tile_index[tile] = dest;
+		dest++;
+	}
+	_animated_tiles.resize(dest);
+	_animated_tile_holes = 0;
+}
+
+/**
+ * Rebuild the lookup index of the animated tile table, e.g.\ after loading
+ * a savegame. Duplicate entries are dropped.
+ */
+void RebuildAnimatedTileIndex()
+{
+	_animated_tile_index.clear();
+	_animated_tile_holes = 0;
+
+	size_t dest = 0;
+	for (TileIndex tile : _animated_tiles) {
+		if (tile == INVALID_TILE || !_animated_tile_index.emplace(tile, dest).second) continue;
+		_animated_tiles[dest++] = tile;
+	}
+	_animated_tiles.resize(dest);
 }
 
 /**
@@ -51,21 +98,15 @@ void AnimateAnimatedTiles()
 {
 	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
 
-	const TileIndex *ti = _animated_tiles.data();
-	while (ti < _animated_tiles.data() + _animated_tiles.size()) {
-		const TileIndex curr = *ti;
-		AnimateTile(curr);
-		/* During the AnimateTile call, DeleteAnimatedTile could have been called,
-		 * deleting an element we've already processed and pushing the rest one
-		 * slot to the left. We can detect this by checking whether the index
-		 * in the current slot has changed - if it has, an element has been deleted,
-		 * and we should process the current slot again instead of going forward.
-		 * NOTE: this will still break if more than one animated tile is being
-		 *       deleted during the same AnimateTile call, but no code seems to
-		 *       be doing this anyway.
-		 */
-		if (*ti == curr) ++ti;
+	/* During the AnimateTile call tiles may be added to the end of the table,
+	 * which are then animated in the same tick, or deleted, which only leaves
+	 * a hole behind. So the slots of the table never move during the loop. */
+	for (size_t i = 0; i < _animated_tiles.size(); i++) {
+		const TileIndex curr = _animated_tiles[i];
+		if (curr != INVALID_TILE) AnimateTile(curr);
 	}
+
+	CompactAnimatedTiles();
 }
 
 /**
@@ -74,4 +115,6 @@ void AnimateAnimatedTiles()
 void InitializeAnimatedTiles()
 {
 	_animated_tiles.clear();
+	_animated_tile_index.clear();
+	_animated_tile_holes = 0;
 }
@@ -16,5 +16,7 @@ void AddAnimatedTile(TileIndex tile);
 void DeleteAnimatedTile(TileIndex tile);
 void AnimateAnimatedTiles();
 void InitializeAnimatedTiles();
+void CompactAnimatedTiles();
+void RebuildAnimatedTileIndex();
 
 #endif /* ANIMATED_TILE_FUNC_H */
@@ -45,6 +45,7 @@
 #include "walltime_func.h"
 #include "company_cmd.h"
 #include "misc_cmd.h"
+#include "pathfinder/yapf/yapf.h"
 
 #include <sstream>
 
@@ -1499,13 +1500,15 @@ DEF_CONSOLE_CMD(ConAlias)
 DEF_CONSOLE_CMD(ConScreenShot)
 {
 	if (argc == 0) {
-		IConsolePrint(CC_HELP, "Create a screenshot of the game. Usage: 'screenshot [viewport | normal | big | giant | heightmap | minimap] [no_con] [size <width> <height>] [<filename>]'.");
+		IConsolePrint(CC_HELP, "Create a screenshot of the game. Usage: 'screenshot [viewport | normal | big | giant | tiles | heightmap | minimap | minimap_tiles] [no_con] [size <width> <height>] [<filename>]'.");
 		IConsolePrint(CC_HELP, "  'viewport' (default) makes a screenshot of the current viewport (including menus, windows).");
 		IConsolePrint(CC_HELP, "  'normal' makes a screenshot of the visible area.");
 		IConsolePrint(CC_HELP, "  'big' makes a zoomed-in screenshot of the visible area.");
 		IConsolePrint(CC_HELP, "  'giant' makes a screenshot of the whole map.");
+		IConsolePrint(CC_HELP, "  'tiles' makes a screenshot of the whole map as a directory of tiles at several zoom levels, for web map viewers.");
 		IConsolePrint(CC_HELP, "  'heightmap' makes a heightmap screenshot of the map that can be loaded in as heightmap.");
 		IConsolePrint(CC_HELP, "  'minimap' makes a top-viewed minimap screenshot of the whole world which represents one tile by one pixel.");
+		IConsolePrint(CC_HELP, "  'minimap_tiles' makes a minimap screenshot as a directory of tiles at several zoom levels, for web map viewers. When the previous one was made in the same directory, only the tiles of which the map changed are written again.");
 		IConsolePrint(CC_HELP, "  'no_con' hides the console to create the screenshot (only useful in combination with 'viewport').");
 		IConsolePrint(CC_HELP, "  'size' sets the width and height of the viewport to make a screenshot of (only useful in combination with 'normal' or 'big').");
 		IConsolePrint(CC_HELP, "  A filename ending in # will prevent overwriting existing files and will number files counting upwards.");
@@ -1533,12 +1536,18 @@ DEF_CONSOLE_CMD(ConScreenShot)
 		} else if (strcmp(argv[arg_index], "giant") == 0) {
 			type = SC_WORLD;
 			arg_index += 1;
+		} else if (strcmp(argv[arg_index], "tiles") == 0) {
+			type = SC_WORLD_TILES;
+			arg_index += 1;
 		} else if (strcmp(argv[arg_index], "heightmap") == 0) {
 			type = SC_HEIGHTMAP;
 			arg_index += 1;
 		} else if (strcmp(argv[arg_index], "minimap") == 0) {
 			type = SC_MINIMAP;
 			arg_index += 1;
+		} else if (strcmp(argv[arg_index], "minimap_tiles") == 0) {
+			type = SC_MINIMAP_TILES;
+			arg_index += 1;
 		}
 	}
 
@@ -2361,6 +2370,132 @@ DEF_CONSOLE_CMD(ConFramerate)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConPathfinderBenchmark)
+{
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Run the pathfinders for all vehicles of the current game and show how fast they are. Usage: 'pf_benchmark [<rounds>]'.");
+		return true;
+	}
+
+	uint32 rounds = 10;
+	if (argc > 1 && !GetArgumentInteger(&rounds, argv[1])) return false;
+
+	YapfBenchmark(rounds);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConIndustryBenchmark)
+{
+	extern void IndustryBenchmark(uint ticks); // industry_cmd.cpp
+
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Run the industry production of a number of ticks and show how long it takes. Usage: 'industry_benchmark [<ticks>]'.");
+		IConsolePrint(CC_HELP, "The industries produce, so this changes the game as if time passed. The number of ticks defaults to {}.", INDUSTRY_PRODUCE_TICKS * 4);
+		return true;
+	}
+
+	uint32 ticks = INDUSTRY_PRODUCE_TICKS * 4;
+	if (argc > 1 && !GetArgumentInteger(&ticks, argv[1])) return false;
+
+	if (_game_mode != GM_NORMAL) {
+		IConsolePrint(CC_ERROR, "Can only run the benchmark in a game.");
+		return true;
+	}
+
+	IndustryBenchmark(ticks);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConTgpBenchmark)
+{
+	extern void TgpBenchmark(uint max_size); // tgp.cpp
+
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Generate height maps with the current settings and show how long every stage of the generation takes. Usage: 'tgp_benchmark [<max size>]'.");
+		IConsolePrint(CC_HELP, "The maps are square; their sizes go up from {} by a factor four till the maximum size, which defaults to {}.", 1 << MIN_MAP_SIZE_BITS, 1 << 12);
+		return true;
+	}
+
+	uint32 max_size = 1 << 12;
+	if (argc > 1 && (!GetArgumentInteger(&max_size, argv[1]) || max_size > (1U << MAX_MAP_SIZE_BITS))) return false;
+
+	if (_generating_world) {
+		IConsolePrint(CC_ERROR, "Can not run the benchmark while generating a world.");
+		return true;
+	}
+
+	TgpBenchmark(max_size);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConHeightmapBenchmark)
+{
+	extern void HeightmapBenchmark(uint max_size); // heightmap.cpp
+
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Convert synthetic heightmaps with the current settings and show how long the scaling and the limiting of the slopes take. Usage: 'heightmap_benchmark [<max size>]'.");
+		IConsolePrint(CC_HELP, "The maps are square; their sizes go up from {} by a factor four till the maximum size, which defaults to {}. The images are twice the size of the maps.", 1 << MIN_MAP_SIZE_BITS, 1 << 12);
+		return true;
+	}
+
+	uint32 max_size = 1 << 12;
+	if (argc > 1 && (!GetArgumentInteger(&max_size, argv[1]) || max_size > (1U << MAX_MAP_SIZE_BITS))) return false;
+
+	if (_generating_world) {
+		IConsolePrint(CC_ERROR, "Can not run the benchmark while generating a world.");
+		return true;
+	}
+
+	HeightmapBenchmark(max_size);
+	return true;
+}
+
+#ifdef WITH_MAP_LAYOUT_BLOCKS
+DEF_CONSOLE_CMD(ConMapLayout)
+{
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Show or change the order the tiles of the map are stored in memory. Usage: 'map_layout [rows|blocks]'.");
+		IConsolePrint(CC_HELP, "In blocks, tiles next to each other along the Y axis are near each other in memory too. The game itself does not change.");
+		return true;
+	}
+
+	if (argc > 1) {
+		if (strcmp(argv[1], "rows") == 0) {
+			SetMapLayoutBlocked(false);
+		} else if (strcmp(argv[1], "blocks") == 0) {
+			SetMapLayoutBlocked(true);
+		} else {
+			return false;
+		}
+	}
+
+	IConsolePrint(CC_INFO, "The tiles of the map are stored {}.", IsMapLayoutBlocked() ? "in blocks" : "row by row");
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConMapLayoutBenchmark)
+{
+	extern void MapLayoutBenchmark(uint rounds); // landscape.cpp
+
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Run the pathfinders, reading the whole map and the drawing of the main viewport with the tiles of the map stored row by row and in blocks, and show how long they take. Usage: 'map_layout_benchmark [<rounds>]'.");
+		IConsolePrint(CC_HELP, "Every round queries the pathfinders for every vehicle, reads every tile of the map and draws the viewport. The game does not change.");
+		return true;
+	}
+
+	uint32 rounds = 5;
+	if (argc > 1 && !GetArgumentInteger(&rounds, argv[1])) return false;
+
+	if (_generating_world) {
+		IConsolePrint(CC_ERROR, "Can not run the benchmark while generating a world.");
+		return true;
+	}
+
+	MapLayoutBenchmark(rounds);
+	return true;
+}
+#endif /* WITH_MAP_LAYOUT_BLOCKS */
+
 DEF_CONSOLE_CMD(ConFramerateWindow)
 {
 	extern void ShowFramerateWindow();
@@ -2667,6 +2802,14 @@ void IConsoleStdLibRegister()
 #endif
 	IConsole::CmdRegister("fps",                     ConFramerate);
 	IConsole::CmdRegister("fps_wnd",                 ConFramerateWindow);
+	IConsole::CmdRegister("pf_benchmark",            ConPathfinderBenchmark, ConHookNoNetwork);
+	IConsole::CmdRegister("industry_benchmark",      ConIndustryBenchmark, ConHookNoNetwork);
+	IConsole::CmdRegister("tgp_benchmark",           ConTgpBenchmark, ConHookNoNetwork);
+	IConsole::CmdRegister("heightmap_benchmark",     ConHeightmapBenchmark, ConHookNoNetwork);
+#ifdef WITH_MAP_LAYOUT_BLOCKS
+	IConsole::CmdRegister("map_layout",              ConMapLayout);
+	IConsole::CmdRegister("map_layout_benchmark",    ConMapLayoutBenchmark, ConHookNoNetwork);
+#endif /* WITH_MAP_LAYOUT_BLOCKS */
 
 	/* NewGRF development stuff */
 	IConsole::CmdRegister("reload_newgrfs",          ConNewGRFReload,     ConHookNewGRFDeveloperTool);
@@ -113,7 +113,13 @@ uint64 ottd_rdtsc() {return 0;}
 #if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
 void ottd_cpuid(int info[4], int type)
 {
-	__cpuid(info, type);
+	__cpuidex(info, type, 0);
+}
+
+/** Get the lower half of the extended control register 0; it tells which register states the OS saves. */
+static uint32 ottd_xgetbv()
+{
+	return (uint32)_xgetbv(0);
 }
 #elif defined(__x86_64__) || defined(__i386)
 void ottd_cpuid(int info[4], int type)
@@ -133,16 +139,24 @@ void ottd_cpuid(int info[4], int type)
 			/* It is safe to write "=r" for (info[1]) as in case that PIC is enabled for i386,
 			 * the compiler will not choose EBX as target register (but something else).
 			 */
-			: "a" (type)
+			: "a" (type), "c" (0)
 	);
 #else
 	__asm__ __volatile__ (
 			"cpuid           \n\t"
 			: "=a" (info[0]), "=b" (info[1]), "=c" (info[2]), "=d" (info[3])
-			: "a" (type)
+			: "a" (type), "c" (0)
 	);
 #endif /* i386 PIC */
 }
+
+/** Get the lower half of the extended control register 0; it tells which register states the OS saves. */
+static uint32 ottd_xgetbv()
+{
+	uint32 low, high;
+	__asm__ __volatile__ ("xgetbv" : "=a" (low), "=d" (high) : "c" (0));
+	return low;
+}
 #elif defined(__e2k__) /* MCST Elbrus 2000*/
 void ottd_cpuid(int info[4], int type)
 {
@@ -161,11 +175,21 @@ void ottd_cpuid(int info[4], int type)
 #endif
 	}
 }
+
+static uint32 ottd_xgetbv()
+{
+	return 0;
+}
 #else
 void ottd_cpuid(int info[4], int type)
 {
 	info[0] = info[1] = info[2] = info[3] = 0;
 }
+
+static uint32 ottd_xgetbv()
+{
+	return 0;
+}
 #endif
 
 bool HasCPUIDFlag(uint type, uint index, uint bit)
@@ -178,3 +202,10 @@ bool HasCPUIDFlag(uint type, uint index, uint bit)
 	ottd_cpuid(cpu_info, type);
 	return HasBit(cpu_info[index], bit);
 }
+
+bool HasAVX2Support()
+{
+	/* Besides the CPU supporting AVX2, the OS has to save the SSE and AVX registers (bits 1 and 2 of XCR0). */
+	if (!HasCPUIDFlag(7, 1, 5) || !HasCPUIDFlag(1, 2, 27) || !HasCPUIDFlag(1, 2, 28)) return false;
+	return (ottd_xgetbv() & 0x6) == 0x6;
+}
@@ -32,4 +32,10 @@ void ottd_cpuid(int info[4], int type);
  */
 bool HasCPUIDFlag(uint type, uint index, uint bit);
 
+/**
+ * Check whether AVX2 instructions can be used, i.e. whether both the CPU and the OS support them.
+ * @return True when AVX2 can be used.
+ */
+bool HasAVX2Support();
+
 #endif /* CPU_H */
@@ -261,6 +261,89 @@ void HandleGeneratingWorldAbortion()
 	throw AbortGenerateWorldSignal();
 }
 
+/** Number of tries of TryRandomTiles that are checked together at first; it doubles for every next batch. */
+static const uint RANDOM_TILE_FIRST_BATCH = 16;
+/** Maximum number of tries of TryRandomTiles that are checked together. */
+static const uint RANDOM_TILE_MAX_BATCH = 1024;
+/** Minimum number of tries of a batch to check them on several threads; for fewer tries starting the threads costs more than checking. */
+static const uint RANDOM_TILE_MIN_PARALLEL_BATCH = 256;
+
+/**
+ * Try to do something at random tiles until it succeeds, like
+ * <tt>for (; tries > 0; tries--) if (try_tile(RandomTile())) return true;</tt>
+ * but with the cheap part of checking the tiles done for a batch of tiles in parallel.
+ * The random numbers of a batch are drawn up front, exactly as the tries would draw
+ * them, so the result is the same as without the batches: tries that are sure to fail
+ * are skipped by only drawing their random numbers, the other tries are done in order.
+ * When a try draws another number of random numbers than expected, the tiles drawn
+ * after it are not valid anymore and a new batch is started; the same happens after
+ * every failed try when failed tries may change the game state.
+ * @param tries The maximum number of tries.
+ * @param draws The number of random numbers a failing try draws after its tile.
+ * @param may_succeed Check whether a try may succeed. When it returns false, the try
+ *                    must fail without changing anything but drawing \a draws random numbers.
+ * @param try_tile Do a try; it is called with the random number generator as it would be without the batches.
+ * @param recheck_after_failure Whether a failed try may change the game state, so the tiles after it have to be checked again.
+ * @return True when a try succeeded.
+ */
+bool TryRandomTiles(uint tries, uint draws, const RandomTileCheck &may_succeed, const RandomTileTry &try_tile, bool recheck_after_failure)
+{
+#ifdef RANDOM_DEBUG
+	/* Every random number has to be drawn, and logged, by the tries themselves. */
+	for (; tries > 0; tries--) {
+		if (try_tile(RandomTile())) return true;
+	}
+	return false;
+#else
+	/** A try of a batch. */
+	struct Probe {
+		Randomizer before; ///< The random number generator before drawing the tile.
+		Randomizer after;  ///< The random number generator after drawing the tile.
+		TileIndex tile;    ///< The drawn tile.
+		bool may_succeed;  ///< Whether the try may succeed.
+	};
+	std::vector<Probe> probes;
+
+	uint batch_size = RANDOM_TILE_FIRST_BATCH;
+	while (tries > 0) {
+		probes.resize(std::min(tries, batch_size));
+		batch_size = std::min(batch_size * 2, RANDOM_TILE_MAX_BATCH);
+
+		Randomizer random = _random;
+		for (Probe &probe : probes) {
+			probe.before = random;
+			probe.tile = RandomTileSeed(random.Next());
+			probe.after = random;
+			for (uint i = 0; i < draws; i++) random.Next();
+		}
+
+		if (probes.size() < RANDOM_TILE_MIN_PARALLEL_BATCH) {
+			for (Probe &probe : probes) probe.may_succeed = may_succeed(probe.tile, probe.after);
+		} else {
+			ParallelFor("ottd:genprobe", probes.size(), [&](size_t i) {
+				probes[i].may_succeed = may_succeed(probes[i].tile, probes[i].after);
+			});
+		}
+
+		uint done = 0;
+		for (const Probe &probe : probes) {
+			done++;
+			if (!probe.may_succeed) continue;
+
+			_random = probe.after;
+			if (try_tile(probe.tile)) return true;
+			if (recheck_after_failure) break;
+
+			const Randomizer &expected = done < probes.size() ? probes[done].before : random;
+			if (_random.state[0] != expected.state[0] || _random.state[1] != expected.state[1]) break;
+		}
+		if (done == probes.size() && !probes.back().may_succeed) _random = random;
+		tries -= done;
+	}
+	return false;
+#endif /* RANDOM_DEBUG */
+}
+
 /**
  * Generate a world.
  * @param mode The mode of world generation (see GenWorldMode).
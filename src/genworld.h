@@ -11,6 +11,9 @@
 #define GENWORLD_H
 
 #include "company_type.h"
+#include "tile_type.h"
+#include "core/random_func.hpp"
+#include <functional>
 #include <thread>
 
 /** Constants related to world generation */
@@ -90,6 +93,21 @@ void AbortGeneratingWorld();
 bool IsGeneratingWorldAborted();
 void HandleGeneratingWorldAbortion();
 
+/**
+ * Check whether a try at a random tile may succeed. Checks are run in parallel, so they must only read the game state.
+ * @param tile The random tile.
+ * @param random The random number generator as the try finds it.
+ * @return False when the try is sure to fail.
+ */
+typedef std::function<bool(TileIndex tile, Randomizer random)> RandomTileCheck;
+/**
+ * Try to do something at a random tile.
+ * @param tile The random tile.
+ * @return True when it succeeded.
+ */
+typedef std::function<bool(TileIndex tile)> RandomTileTry;
+bool TryRandomTiles(uint tries, uint draws, const RandomTileCheck &may_succeed, const RandomTileTry &try_tile, bool recheck_after_failure = false);
+
 /* genworld_gui.cpp */
 void SetNewLandscapeType(byte landscape);
 void SetGeneratingWorldProgress(GenWorldProgress cls, uint total);
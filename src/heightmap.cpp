@@ -17,9 +17,14 @@
 #include "gfx_func.h"
 #include "fios.h"
 #include "fileio_func.h"
+#include "console_func.h"
+#include "thread.h"
+#include "core/random_func.hpp"
 
 #include "table/strings.h"
 
+#include <chrono>
+
 #include "safeguards.h"
 
 /**
@@ -74,14 +79,23 @@ static inline byte RGBToGrayscale(byte red, byte green, byte blue)
 
 /**
  * The PNG Heightmap loader.
+ * The image is decoded a row at a time, so only one row of the decoded image
+ * is in memory at once. Interlaced images are combined over several passes,
+ * so for those the whole decoded image is needed.
+ * @param map The grayscale map to fill.
+ * @param png_ptr The PNG being read.
+ * @param info_ptr The information of the PNG.
+ * @param rows Buffer for the decoded rows; one row, or all rows for interlaced images.
+ * @param passes The number of passes needed to read the image.
  */
-static void ReadHeightmapPNGImageData(byte *map, png_structp png_ptr, png_infop info_ptr)
+static void ReadHeightmapPNGImageData(byte *map, png_structp png_ptr, png_infop info_ptr, png_bytep rows, uint passes)
 {
-	uint x, y;
 	byte gray_palette[256];
-	png_bytep *row_pointers = nullptr;
 	bool has_palette = png_get_color_type(png_ptr, info_ptr) == PNG_COLOR_TYPE_PALETTE;
 	uint channels = png_get_channels(png_ptr, info_ptr);
+	uint width = png_get_image_width(png_ptr, info_ptr);
+	uint height = png_get_image_height(png_ptr, info_ptr);
+	size_t row_bytes = png_get_rowbytes(png_ptr, info_ptr);
 
 	/* Get palette and convert it to grayscale */
 	if (has_palette) {
@@ -109,24 +123,30 @@ static void ReadHeightmapPNGImageData(byte *map, png_structp png_ptr, png_infop
 		}
 	}
 
-	row_pointers = png_get_rows(png_ptr, info_ptr);
+	/* Convert a decoded row in 8-bit grayscale */
+	auto convert_row = [&](const png_byte *row, byte *pixel) {
+		if (has_palette) {
+			for (uint x = 0; x < width; x++) pixel[x] = gray_palette[row[x]];
+		} else if (channels == 3) {
+			for (uint x = 0; x < width; x++, row += 3) pixel[x] = RGBToGrayscale(row[0], row[1], row[2]);
+		} else {
+			for (uint x = 0; x < width; x++) pixel[x] = row[x * channels];
+		}
+	};
 
-	/* Read the raw image data and convert in 8-bit grayscale */
-	for (x = 0; x < png_get_image_width(png_ptr, info_ptr); x++) {
-		for (y = 0; y < png_get_image_height(png_ptr, info_ptr); y++) {
-			byte *pixel = &map[y * png_get_image_width(png_ptr, info_ptr) + x];
-			uint x_offset = x * channels;
-
-			if (has_palette) {
-				*pixel = gray_palette[row_pointers[y][x_offset]];
-			} else if (channels == 3) {
-				*pixel = RGBToGrayscale(row_pointers[y][x_offset + 0],
-						row_pointers[y][x_offset + 1], row_pointers[y][x_offset + 2]);
-			} else {
-				*pixel = row_pointers[y][x_offset];
-			}
+	if (passes == 1) {
+		for (uint y = 0; y < height; y++) {
+			png_read_row(png_ptr, rows, nullptr);
+			convert_row(rows, &map[y * width]);
+		}
+	} else {
+		for (uint pass = 0; pass < passes; pass++) {
+			for (uint y = 0; y < height; y++) png_read_row(png_ptr, &rows[y * row_bytes], nullptr);
 		}
+		for (uint y = 0; y < height; y++) convert_row(&rows[y * row_bytes], &map[y * width]);
 	}
+
+	png_read_end(png_ptr, nullptr);
 }
 
 /**
@@ -139,6 +159,8 @@ static bool ReadHeightmapPNG(const char *filename, uint *x, uint *y, byte **map)
 	FILE *fp;
 	png_structp png_ptr = nullptr;
 	png_infop info_ptr  = nullptr;
+	/* Allocated after the setjmp, so it must be volatile to be freed after a longjmp. */
+	png_bytep volatile rows = nullptr;
 
 	fp = FioFOpenFile(filename, "rb", HEIGHTMAP_DIR);
 	if (fp == nullptr) {
@@ -157,16 +179,21 @@ static bool ReadHeightmapPNG(const char *filename, uint *x, uint *y, byte **map)
 	if (info_ptr == nullptr || setjmp(png_jmpbuf(png_ptr))) {
 		ShowErrorMessage(STR_ERROR_PNGMAP, STR_ERROR_PNGMAP_MISC, WL_ERROR);
 		fclose(fp);
+		free(rows);
 		png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
 		return false;
 	}
 
 	png_init_io(png_ptr, fp);
 
-	/* Allocate memory and read image, without alpha or 16-bit samples
+	/* Read the image information, and decode without alpha or 16-bit samples
 	 * (result is either 8-bit indexed/grayscale or 24-bit RGB) */
+	png_read_info(png_ptr, info_ptr);
 	png_set_packing(png_ptr);
-	png_read_png(png_ptr, info_ptr, PNG_TRANSFORM_PACKING | PNG_TRANSFORM_STRIP_ALPHA | PNG_TRANSFORM_STRIP_16, nullptr);
+	png_set_strip_alpha(png_ptr);
+	png_set_strip_16(png_ptr);
+	uint passes = png_set_interlace_handling(png_ptr);
+	png_read_update_info(png_ptr, info_ptr);
 
 	/* Maps of wrong colour-depth are not used.
 	 * (this should have been taken care of by stripping alpha and 16-bit samples on load) */
@@ -188,8 +215,10 @@ static bool ReadHeightmapPNG(const char *filename, uint *x, uint *y, byte **map)
 	}
 
 	if (map != nullptr) {
+		rows = MallocT<png_byte>(png_get_rowbytes(png_ptr, info_ptr) * (passes == 1 ? 1 : height));
 		*map = MallocT<byte>(width * height);
-		ReadHeightmapPNGImageData(*map, png_ptr, info_ptr);
+		ReadHeightmapPNGImageData(*map, png_ptr, info_ptr, rows, passes);
+		free(rows);
 	}
 
 	*x = width;
@@ -316,165 +345,288 @@ static bool ReadHeightmapBMP(const char *filename, uint *x, uint *y, byte **map)
 	return true;
 }
 
+/** Number of rows, or columns, of a map that one thread handles at a time. */
+static const uint HEIGHTMAP_LINES_PER_CHUNK = 64;
+
+/**
+ * Call a function for ranges of lines of a map, on multiple threads.
+ * @param count Number of lines.
+ * @param fn Function to call with the first line and the end of each range.
+ */
+template <class TFn>
+static void HeightmapParallelLines(uint count, TFn &&fn)
+{
+	ParallelFor("ottd:heightmap", CeilDiv(count, HEIGHTMAP_LINES_PER_CHUNK), [&](size_t chunk) {
+		uint begin = (uint)chunk * HEIGHTMAP_LINES_PER_CHUNK;
+		fn(begin, std::min(begin + HEIGHTMAP_LINES_PER_CHUNK, count));
+	});
+}
+
+/** Defines the detail of the aspect ratio (to avoid doubles) */
+static const uint HEIGHTMAP_NUM_DIV = 16384;
+/* Ensure multiplication with HEIGHTMAP_NUM_DIV does not cause overflows. */
+static_assert(HEIGHTMAP_NUM_DIV <= std::numeric_limits<uint>::max() / MAX_HEIGHTMAP_SIDE_LENGTH_IN_PIXELS);
+
+/** The pixels of the heightmap image a row or a column of the map is made of. */
+struct HeightmapSample {
+	uint pos;    ///< The pixel nearest to the row or column, or UINT_MAX when it is not part of the image.
+	uint next;   ///< The next pixel, to interpolate with.
+	uint weight; ///< Weight of the next pixel, in 256ths.
+};
+
+/**
+ * Get the pixels the rows, or the columns, of the map are made of.
+ * @param length The number of rows or columns of the map.
+ * @param pad The number of rows or columns on both sides that are not part of the image.
+ * @param mirror Whether the image is mirrored along this direction.
+ * @param img_length The number of pixels of the image along this direction.
+ * @param img_scale The scale of the image, times HEIGHTMAP_NUM_DIV.
+ * @param freeform_edges Whether the map has freeform edges.
+ * @param interpolate Whether to interpolate between pixels.
+ * @return The pixels of every row or column.
+ */
+static std::vector<HeightmapSample> GetHeightmapSamples(uint length, uint pad, bool mirror, uint img_length, uint img_scale, bool freeform_edges, bool interpolate)
+{
+	std::vector<HeightmapSample> samples(length, { UINT_MAX, UINT_MAX, 0 });
+
+	/* Leave the padding and, without freeform edges, the 1-pixel map edge at height 0. */
+	uint begin = std::max(pad, freeform_edges ? 0U : 2U);
+	uint end = std::min(length - pad - (freeform_edges ? 0 : 1), length - (freeform_edges ? 0 : 2));
+	for (uint i = begin; i < end; i++) {
+		/* We rotate the map 45 degrees (counter)clockwise, which mirrors the columns for counter clockwise. */
+		uint offset = mirror ? length - 1 - i - pad : i - pad;
+		HeightmapSample &sample = samples[i];
+
+		if (!interpolate) {
+			/* Use nearest neighbour resizing to scale map data. */
+			sample.pos = sample.next = (offset * HEIGHTMAP_NUM_DIV) / img_scale;
+		} else {
+			/* Sample at the centre of the tile, in 256ths of pixels from the centre of the first pixel. */
+			int64 centre = ((2 * (int64)offset + 1) * HEIGHTMAP_NUM_DIV * 128) / img_scale - 128;
+			centre = Clamp<int64>(centre, 0, ((int64)img_length - 1) * 256);
+			sample.pos = (uint)(centre >> 8);
+			sample.next = std::min(sample.pos + 1, img_length - 1);
+			sample.weight = (uint)(centre & 0xFF);
+		}
+
+		assert(sample.pos < img_length);
+	}
+
+	return samples;
+}
+
 /**
- * Converts a given grayscale map to something that fits in OTTD map system
- * and create a map of that data.
+ * Converts a given grayscale map to the heights of the tiles of a map.
  * @param img_width  the with of the image in pixels/tiles
  * @param img_height the height of the image in pixels/tiles
  * @param map        the input map
+ * @param size_x     the size of the map along the x axis
+ * @param size_y     the size of the map along the y axis
+ * @param interpolate whether to interpolate between pixels, instead of using the nearest pixel
+ * @param[out] heights the heights of the tiles, indexed like TileXY
  */
-static void GrayscaleToMapHeights(uint img_width, uint img_height, byte *map)
+static void GrayscaleToHeights(uint img_width, uint img_height, const byte *map, uint size_x, uint size_y, bool interpolate, byte *heights)
 {
-	/* Defines the detail of the aspect ratio (to avoid doubles) */
-	const uint num_div = 16384;
-	/* Ensure multiplication with num_div does not cause overflows. */
-	static_assert(num_div <= std::numeric_limits<uint>::max() / MAX_HEIGHTMAP_SIDE_LENGTH_IN_PIXELS);
-
 	uint width, height;
-	uint row, col;
 	uint row_pad = 0, col_pad = 0;
 	uint img_scale;
-	uint img_row, img_col;
-	TileIndex tile;
+	bool clockwise;
 
 	/* Get map size and calculate scale and padding values */
 	switch (_settings_game.game_creation.heightmap_rotation) {
 		default: NOT_REACHED();
 		case HM_COUNTER_CLOCKWISE:
-			width   = MapSizeX();
-			height  = MapSizeY();
+			width   = size_x;
+			height  = size_y;
+			clockwise = false;
 			break;
 		case HM_CLOCKWISE:
-			width   = MapSizeY();
-			height  = MapSizeX();
+			width   = size_y;
+			height  = size_x;
+			clockwise = true;
 			break;
 	}
 
-	if ((img_width * num_div) / img_height > ((width * num_div) / height)) {
+	if ((img_width * HEIGHTMAP_NUM_DIV) / img_height > ((width * HEIGHTMAP_NUM_DIV) / height)) {
 		/* Image is wider than map - center vertically */
-		img_scale = (width * num_div) / img_width;
-		row_pad = (1 + height - ((img_height * img_scale) / num_div)) / 2;
+		img_scale = (width * HEIGHTMAP_NUM_DIV) / img_width;
+		row_pad = (1 + height - ((img_height * img_scale) / HEIGHTMAP_NUM_DIV)) / 2;
 	} else {
 		/* Image is taller than map - center horizontally */
-		img_scale = (height * num_div) / img_height;
-		col_pad = (1 + width - ((img_width * img_scale) / num_div)) / 2;
+		img_scale = (height * HEIGHTMAP_NUM_DIV) / img_height;
+		col_pad = (1 + width - ((img_width * img_scale) / HEIGHTMAP_NUM_DIV)) / 2;
 	}
 
-	if (_settings_game.construction.freeform_edges) {
-		for (uint x = 0; x < MapSizeX(); x++) MakeVoid(TileXY(x, 0));
-		for (uint y = 0; y < MapSizeY(); y++) MakeVoid(TileXY(0, y));
+	bool freeform_edges = _settings_game.construction.freeform_edges;
+	std::vector<HeightmapSample> rows = GetHeightmapSamples(height, row_pad, false, img_height, img_scale, freeform_edges, interpolate);
+	std::vector<HeightmapSample> cols = GetHeightmapSamples(width, col_pad, !clockwise, img_width, img_scale, freeform_edges, interpolate);
+
+	/* 0 is sea level.
+	 * Other grey scales are scaled evenly to the available height levels > 0.
+	 * (The coastline is independent from the number of height levels) */
+	byte levels[256];
+	levels[0] = 0;
+	for (uint grey = 1; grey < lengthof(levels); grey++) {
+		levels[grey] = 1 + (grey - 1) * _settings_game.game_creation.heightmap_height / 255;
 	}
 
-	/* Form the landscape */
-	for (row = 0; row < height; row++) {
-		for (col = 0; col < width; col++) {
-			switch (_settings_game.game_creation.heightmap_rotation) {
-				default: NOT_REACHED();
-				case HM_COUNTER_CLOCKWISE: tile = TileXY(col, row); break;
-				case HM_CLOCKWISE:         tile = TileXY(row, col); break;
-			}
+	/* Counter clockwise the rows of the image go along the y axis of the map, clockwise along the x axis.
+	 * So a row of tiles has one sample of the image along one direction, and a sample for every tile along the other. */
+	const std::vector<HeightmapSample> &along = clockwise ? rows : cols;
+	const uint along_stride = clockwise ? img_width : 1;
+	const uint across_stride = clockwise ? 1 : img_width;
 
-			/* Check if current tile is within the 1-pixel map edge or padding regions */
-			if ((!_settings_game.construction.freeform_edges && DistanceFromEdge(tile) <= 1) ||
-					(row < row_pad) || (row >= (height - row_pad - (_settings_game.construction.freeform_edges ? 0 : 1))) ||
-					(col < col_pad) || (col >= (width  - col_pad - (_settings_game.construction.freeform_edges ? 0 : 1)))) {
-				SetTileHeight(tile, 0);
-			} else {
-				/* Use nearest neighbour resizing to scale map data.
-				 *  We rotate the map 45 degrees (counter)clockwise */
-				img_row = (((row - row_pad) * num_div) / img_scale);
-				switch (_settings_game.game_creation.heightmap_rotation) {
-					default: NOT_REACHED();
-					case HM_COUNTER_CLOCKWISE:
-						img_col = (((width - 1 - col - col_pad) * num_div) / img_scale);
-						break;
-					case HM_CLOCKWISE:
-						img_col = (((col - col_pad) * num_div) / img_scale);
-						break;
-				}
+	HeightmapParallelLines(size_y, [&](uint begin, uint end) {
+		for (uint y = begin; y < end; y++) {
+			const HeightmapSample &across = clockwise ? cols[y] : rows[y];
+			byte *out = &heights[y * size_x];
 
-				assert(img_row < img_height);
-				assert(img_col < img_width);
+			if (across.pos == UINT_MAX) {
+				memset(out, 0, size_x);
+				continue;
+			}
 
-				uint heightmap_height = map[img_row * img_width + img_col];
+			const byte *first = &map[across.pos * across_stride];
+			if (!interpolate) {
+				for (uint x = 0; x < size_x; x++) {
+					out[x] = along[x].pos == UINT_MAX ? 0 : levels[first[along[x].pos * along_stride]];
+				}
+				continue;
+			}
 
-				if (heightmap_height > 0) {
-					/* 0 is sea level.
-					 * Other grey scales are scaled evenly to the available height levels > 0.
-					 * (The coastline is independent from the number of height levels) */
-					heightmap_height = 1 + (heightmap_height - 1) * _settings_game.game_creation.heightmap_height / 255;
+			const byte *second = &map[across.next * across_stride];
+			for (uint x = 0; x < size_x; x++) {
+				const HeightmapSample &sample = along[x];
+				if (sample.pos == UINT_MAX) {
+					out[x] = 0;
+					continue;
 				}
 
-				SetTileHeight(tile, heightmap_height);
-			}
-			/* Only clear the tiles within the map area. */
-			if (IsInnerTile(tile)) {
-				MakeClear(tile, CLEAR_GRASS, 3);
+				uint pos = sample.pos * along_stride;
+				uint next = sample.next * along_stride;
+				uint grey_first = first[pos] * (256 - sample.weight) + first[next] * sample.weight;
+				uint grey_second = second[pos] * (256 - sample.weight) + second[next] * sample.weight;
+				uint grey = grey_first * (256 - across.weight) + grey_second * across.weight;
+				out[x] = levels[(grey + (1 << 15)) >> 16];
 			}
 		}
-	}
+	});
 }
 
 /**
- * This function takes care of the fact that land in OpenTTD can never differ
- * more than 1 in height
+ * Make the tiles of the map clear land of the given heights.
+ * @param heights the heights of the tiles, indexed like TileXY
  */
-void FixSlopes()
+static void SetMapHeights(const byte *heights)
 {
-	uint width, height;
-	int row, col;
-	byte current_tile;
-
-	/* Adjust height difference to maximum one horizontal/vertical change. */
-	width   = MapSizeX();
-	height  = MapSizeY();
-
-	/* Top and left edge */
-	for (row = 0; (uint)row < height; row++) {
-		for (col = 0; (uint)col < width; col++) {
-			current_tile = MAX_TILE_HEIGHT;
-			if (col != 0) {
-				/* Find lowest tile; either the top or left one */
-				current_tile = TileHeight(TileXY(col - 1, row)); // top edge
-			}
-			if (row != 0) {
-				if (TileHeight(TileXY(col, row - 1)) < current_tile) {
-					current_tile = TileHeight(TileXY(col, row - 1)); // left edge
-				}
-			}
+	if (_settings_game.construction.freeform_edges) {
+		for (uint x = 0; x < MapSizeX(); x++) MakeVoid(TileXY(x, 0));
+		for (uint y = 0; y < MapSizeY(); y++) MakeVoid(TileXY(0, y));
+	}
 
-			/* Does the height differ more than one? */
-			if (TileHeight(TileXY(col, row)) >= (uint)current_tile + 2) {
-				/* Then change the height to be no more than one */
-				SetTileHeight(TileXY(col, row), current_tile + 1);
-			}
+	HeightmapParallelLines(MapSizeY(), [&](uint begin, uint end) {
+		for (TileIndex tile = TileXY(0, begin); tile < TileXY(0, end); tile++) SetTileHeight(tile, heights[tile]);
+	});
+
+	/* Changing the type of a tile tells the journal of changed tiles, which is not thread safe. */
+	for (TileIndex tile = 0; tile < MapSize(); tile++) {
+		/* Only clear the tiles within the map area. */
+		if (IsInnerTile(tile)) {
+			MakeClear(tile, CLEAR_GRASS, 3);
 		}
 	}
+}
 
-	/* Bottom and right edge */
-	for (row = height - 1; row >= 0; row--) {
-		for (col = width - 1; col >= 0; col--) {
-			current_tile = MAX_TILE_HEIGHT;
-			if ((uint)col != width - 1) {
-				/* Find lowest tile; either the bottom and right one */
-				current_tile = TileHeight(TileXY(col + 1, row)); // bottom edge
-			}
+/**
+ * Limit the heights so they differ no more than one from the heights next to them.
+ * Limiting every height to its north-east and north-west neighbour plus one, going
+ * from the north corner, limits it to every height north of it plus its distance.
+ * That is the same as first limiting along the rows and then along the columns,
+ * which can be done for many rows, respectively columns, at the same time.
+ * The same goes for the limiting from the south corner.
+ * @param heights the heights of the tiles, indexed like TileXY
+ * @param size_x  the size of the map along the x axis
+ * @param size_y  the size of the map along the y axis
+ */
+static void FixSlopes(byte *heights, uint size_x, uint size_y)
+{
+	HeightmapParallelLines(size_y, [&](uint begin, uint end) {
+		for (uint y = begin; y < end; y++) {
+			byte *row = &heights[y * size_x];
+			for (uint x = 1; x < size_x; x++) row[x] = std::min<uint>(row[x], row[x - 1] + 1);
+		}
+	});
+	HeightmapParallelLines(size_x, [&](uint begin, uint end) {
+		for (uint y = 1; y < size_y; y++) {
+			byte *row = &heights[y * size_x];
+			const byte *prev = row - size_x;
+			for (uint x = begin; x < end; x++) row[x] = std::min<uint>(row[x], prev[x] + 1);
+		}
+	});
+	HeightmapParallelLines(size_y, [&](uint begin, uint end) {
+		for (uint y = begin; y < end; y++) {
+			byte *row = &heights[y * size_x];
+			for (uint x = size_x - 1; x-- > 0;) row[x] = std::min<uint>(row[x], row[x + 1] + 1);
+		}
+	});
+	HeightmapParallelLines(size_x, [&](uint begin, uint end) {
+		for (uint y = size_y - 1; y-- > 0;) {
+			byte *row = &heights[y * size_x];
+			const byte *next = row + size_x;
+			for (uint x = begin; x < end; x++) row[x] = std::min<uint>(row[x], next[x] + 1);
+		}
+	});
+}
 
-			if ((uint)row != height - 1) {
-				if (TileHeight(TileXY(col, row + 1)) < current_tile) {
-					current_tile = TileHeight(TileXY(col, row + 1)); // right edge
-				}
-			}
+/**
+ * Limit the heights one tile at a time, from the north and then from the south corner.
+ * This gives the same heights as FixSlopes; it is only used to check that in the benchmark.
+ * @param heights the heights of the tiles, indexed like TileXY
+ * @param size_x  the size of the map along the x axis
+ * @param size_y  the size of the map along the y axis
+ */
+static void FixSlopesSequential(byte *heights, uint size_x, uint size_y)
+{
+	for (uint y = 0; y < size_y; y++) {
+		for (uint x = 0; x < size_x; x++) {
+			uint limit = MAX_TILE_HEIGHT;
+			if (x != 0) limit = heights[y * size_x + x - 1];
+			if (y != 0) limit = std::min<uint>(limit, heights[(y - 1) * size_x + x]);
+			if (heights[y * size_x + x] >= limit + 2) heights[y * size_x + x] = limit + 1;
+		}
+	}
 
-			/* Does the height differ more than one? */
-			if (TileHeight(TileXY(col, row)) >= (uint)current_tile + 2) {
-				/* Then change the height to be no more than one */
-				SetTileHeight(TileXY(col, row), current_tile + 1);
-			}
+	for (uint y = size_y; y-- > 0;) {
+		for (uint x = size_x; x-- > 0;) {
+			uint limit = MAX_TILE_HEIGHT;
+			if (x != size_x - 1) limit = heights[y * size_x + x + 1];
+			if (y != size_y - 1) limit = std::min<uint>(limit, heights[(y + 1) * size_x + x]);
+			if (heights[y * size_x + x] >= limit + 2) heights[y * size_x + x] = limit + 1;
 		}
 	}
 }
 
+/**
+ * This function takes care of the fact that land in OpenTTD can never differ
+ * more than 1 in height
+ */
+void FixSlopes()
+{
+	std::vector<byte> heights(MapSize());
+
+	HeightmapParallelLines(MapSizeY(), [&](uint begin, uint end) {
+		for (TileIndex tile = TileXY(0, begin); tile < TileXY(0, end); tile++) heights[tile] = TileHeight(tile);
+	});
+
+	FixSlopes(heights.data(), MapSizeX(), MapSizeY());
+
+	HeightmapParallelLines(MapSizeY(), [&](uint begin, uint end) {
+		for (TileIndex tile = TileXY(0, begin); tile < TileXY(0, end); tile++) {
+			if (TileHeight(tile) != heights[tile]) SetTileHeight(tile, heights[tile]);
+		}
+	});
+}
+
 /**
  * Reads the heightmap with the correct file reader.
  * @param dft Type of image file.
@@ -530,10 +682,12 @@ void LoadHeightmap(DetailedFileType dft, const char *filename)
 		return;
 	}
 
-	GrayscaleToMapHeights(x, y, map);
+	std::vector<byte> heights(MapSize());
+	GrayscaleToHeights(x, y, map, MapSizeX(), MapSizeY(), _settings_game.game_creation.heightmap_interpolation, heights.data());
 	free(map);
 
-	FixSlopes();
+	FixSlopes(heights.data(), MapSizeX(), MapSizeY());
+	SetMapHeights(heights.data());
 	MarkWholeScreenDirty();
 }
 
@@ -553,3 +707,48 @@ void FlatEmptyWorld(byte tile_height)
 	FixSlopes();
 	MarkWholeScreenDirty();
 }
+
+/**
+ * Convert synthetic heightmap images to the heights of maps of several sizes
+ * and show how long the scaling and the limiting of the slopes take.
+ * The current map is not changed; its heightmap settings are used.
+ * @param max_size Size of the largest map.
+ */
+void HeightmapBenchmark(uint max_size)
+{
+	auto measure = [](auto &&fn) -> uint64 {
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	for (uint size = 1 << MIN_MAP_SIZE_BITS; size <= max_size; size <<= 2) {
+		/* An image of twice the size of the map, rising from the north to the south corner
+		 * with a lot of noise on it, so there are many slopes to limit. */
+		uint img_size = 2 * size;
+		std::vector<byte> image((size_t)img_size * img_size);
+		Randomizer random;
+		random.SetSeed(size);
+		for (uint y = 0; y < img_size; y++) {
+			for (uint x = 0; x < img_size; x++) {
+				int grey = (x + y) * 255 / (2 * img_size) + GB(random.Next(), 0, 6) - 32;
+				image[y * img_size + x] = grey < 16 ? 0 : std::min(grey, 255);
+			}
+		}
+
+		std::vector<byte> heights((size_t)size * size);
+		uint64 nearest = measure([&]() { GrayscaleToHeights(img_size, img_size, image.data(), size, size, false, heights.data()); });
+		uint64 interpolated = measure([&]() { GrayscaleToHeights(img_size, img_size, image.data(), size, size, true, heights.data()); });
+
+		std::vector<byte> sequential = heights;
+		uint64 slopes = measure([&]() { FixSlopes(heights.data(), size, size); });
+		uint64 sequential_slopes = measure([&]() { FixSlopesSequential(sequential.data(), size, size); });
+
+		IConsolePrint(CC_INFO, "{}x{} from {}x{} pixels: nearest {} ms, interpolated {} ms, slopes {} ms, sequential slopes {} ms",
+				size, size, img_size, img_size, nearest / 1000, interpolated / 1000, slopes / 1000, sequential_slopes / 1000);
+
+		if (heights != sequential) {
+			IConsolePrint(CC_ERROR, "{}x{}: limiting the slopes by rows and columns gave different heights than limiting them a tile at a time.", size, size);
+		}
+	}
+}
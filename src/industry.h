@@ -78,7 +78,8 @@ struct Industry : IndustryPool::PoolItem<&_industry_pool> {
 	byte last_month_pct_transported[INDUSTRY_NUM_OUTPUTS]; ///< percentage transported per cargo in the last full month
 	uint16 last_month_production[INDUSTRY_NUM_OUTPUTS];    ///< total units produced per cargo in the last full month
 	uint16 last_month_transported[INDUSTRY_NUM_OUTPUTS];   ///< total units transported per cargo in the last full month
-	uint16 counter;                                        ///< used for animation and/or production (if available cargo)
+	uint16 counter;                                        ///< used for animation and/or production (if available cargo); counted down lazily, see #counter_tick
+	uint64 counter_tick;                                   ///< NOSAVE: Tick of the industry production schedule at which #counter was last brought up to date.
 
 	IndustryType type;             ///< type of industry.
 	Owner owner;                   ///< owner of the industry.  Which SHOULD always be (imho) OWNER_NONE
@@ -104,7 +105,7 @@ struct Industry : IndustryPool::PoolItem<&_industry_pool> {
 
 	PersistentStorage *psa;        ///< Persistent storage for NewGRF industries.
 
-	Industry(TileIndex tile = INVALID_TILE) : location(tile, 0, 0) {}
+	Industry(TileIndex tile = INVALID_TILE) : location(tile, 0, 0), counter_tick(0) {}
 	~Industry();
 
 	void RecomputeProductionMultipliers();
@@ -202,6 +203,8 @@ protected:
 };
 
 void ClearAllIndustryCachedNames();
+void SyncIndustryCounter(Industry *i);
+void RebuildIndustrySchedule();
 
 void PlantRandomFarmField(const Industry *i);
 
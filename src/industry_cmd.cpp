@@ -44,6 +44,8 @@
 #include "industry_cmd.h"
 #include "landscape_cmd.h"
 #include "terraform_cmd.h"
+#include "console_func.h"
+#include <chrono>
 
 #include "table/strings.h"
 #include "table/industry_land.h"
@@ -66,6 +68,74 @@ IndustrySpec _industry_specs[NUM_INDUSTRYTYPES];
 IndustryTileSpec _industry_tile_specs[NUM_INDUSTRYTILES];
 IndustryBuildData _industry_builder; ///< In-game manager of industries.
 
+/** Interval in ticks of the ambient sound check of an industry, see #ProduceIndustryGoods. */
+static const uint INDUSTRY_SOUND_TICKS = 0x40;
+
+/** Number of ticks #OnTick_Industry has handled, the time base of the industry production schedule. */
+static uint64 _industry_tick = 0;
+static uint64 _industry_visits = 0; ///< Number of times #OnTick_Industry has visited an industry so far.
+
+/**
+ * Industry production schedule. Industries are put into the slot of the tick (modulo
+ * #INDUSTRY_PRODUCE_TICKS) in which they produce; each slot is sorted by industry index.
+ * The industry counters of all other ticks are counted down lazily.
+ */
+static std::vector<IndustryID> _industry_schedule[INDUSTRY_PRODUCE_TICKS];
+
+/**
+ * Get the slot of an industry in the industry production schedule.
+ * @param i The industry.
+ * @return The slot, which does not change when the counter is brought up to date.
+ */
+static inline uint GetIndustryScheduleSlot(const Industry *i)
+{
+	return (i->counter + i->counter_tick) % INDUSTRY_PRODUCE_TICKS;
+}
+
+/**
+ * Bring the counter of an industry up to date with the industry production schedule.
+ * @param i The industry.
+ */
+void SyncIndustryCounter(Industry *i)
+{
+	i->counter -= (uint16)(_industry_tick - i->counter_tick);
+	i->counter_tick = _industry_tick;
+}
+
+/**
+ * Add an industry with a freshly set counter to the industry production schedule.
+ * @param i The industry.
+ */
+static void ScheduleIndustry(Industry *i)
+{
+	i->counter_tick = _industry_tick;
+	std::vector<IndustryID> &slot = _industry_schedule[GetIndustryScheduleSlot(i)];
+	slot.insert(std::lower_bound(slot.begin(), slot.end(), i->index), i->index);
+}
+
+/**
+ * Remove an industry from the industry production schedule.
+ * @param i The industry.
+ */
+static void UnscheduleIndustry(const Industry *i)
+{
+	std::vector<IndustryID> &slot = _industry_schedule[GetIndustryScheduleSlot(i)];
+	auto it = std::lower_bound(slot.begin(), slot.end(), i->index);
+	if (it != slot.end() && *it == i->index) slot.erase(it);
+}
+
+/**
+ * Rebuild the industry production schedule from the counters of all industries.
+ */
+void RebuildIndustrySchedule()
+{
+	for (std::vector<IndustryID> &slot : _industry_schedule) slot.clear();
+	for (Industry *i : Industry::Iterate()) {
+		i->counter_tick = _industry_tick;
+		_industry_schedule[GetIndustryScheduleSlot(i)].push_back(i->index);
+	}
+}
+
 /**
  * This function initialize the spec arrays of both
  * industry and industry tiles.
@@ -144,6 +214,8 @@ Industry::~Industry()
 {
 	if (CleaningPool()) return;
 
+	UnscheduleIndustry(this);
+
 	/* Industry can also be destroyed when not fully initialized.
 	 * This means that we do not have to clear tiles either.
 	 * Also we must not decrement industry counts in that case. */
@@ -1211,11 +1283,47 @@ void OnTick_Industry()
 
 	if (_game_mode == GM_EDITOR) return;
 
-	for (Industry *i : Industry::Iterate()) {
+	_industry_tick++;
+
+	/* Only industries that check for their ambient sound or produce in this tick
+	 * have to do something other than counting down. Gather them in index order. */
+	static std::vector<IndustryID> due;
+	due.clear();
+	const std::vector<IndustryID> &produce = _industry_schedule[_industry_tick % INDUSTRY_PRODUCE_TICKS];
+	due.insert(due.end(), produce.begin(), produce.end());
+	for (uint slot = (_industry_tick - 1) % INDUSTRY_SOUND_TICKS; slot < INDUSTRY_PRODUCE_TICKS; slot += INDUSTRY_SOUND_TICKS) {
+		due.insert(due.end(), _industry_schedule[slot].begin(), _industry_schedule[slot].end());
+	}
+	std::sort(due.begin(), due.end());
+	_industry_visits += due.size();
+
+	for (IndustryID index : due) {
+		Industry *i = Industry::Get(index);
+		/* Bring the counter to its value before this tick, ProduceIndustryGoods counts it down. */
+		i->counter -= (uint16)(_industry_tick - 1 - i->counter_tick);
+		i->counter_tick = _industry_tick;
 		ProduceIndustryGoods(i);
 	}
 }
 
+/**
+ * Run the industry production of a number of ticks and show how long it takes,
+ * and how many industries were visited compared to visiting every industry each tick.
+ * The industries produce, so this changes the game as if time passed.
+ * @param ticks The number of ticks to run.
+ */
+void IndustryBenchmark(uint ticks)
+{
+	uint64 visits = _industry_visits;
+	auto start = std::chrono::steady_clock::now();
+	for (uint i = 0; i < ticks; i++) OnTick_Industry();
+	uint64 us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	visits = _industry_visits - visits;
+
+	IConsolePrint(CC_INFO, "Industries: {} ticks with {} industries in {} ms, {} us per tick", ticks, Industry::GetNumItems(), us / 1000, ticks == 0 ? 0 : us / ticks);
+	IConsolePrint(CC_INFO, "Visited {} industries, instead of {} when visiting every industry each tick", visits, (uint64)ticks * Industry::GetNumItems());
+}
+
 /**
  * Check the conditions of #CHECK_NOTHING (Always succeeds).
  * @param tile %Tile to perform the checking.
@@ -1778,6 +1886,7 @@ static void DoCreateNewIndustry(Industry *i, TileIndex tile, IndustryType type,
 	uint16 r = Random();
 	i->random_colour = GB(r, 0, 4);
 	i->counter = GB(r, 4, 12);
+	ScheduleIndustry(i);
 	i->random = initial_random_bits;
 	i->was_cargo_delivered = false;
 	i->last_prod_year = _cur_year;
@@ -2170,6 +2279,48 @@ static Industry *CreateNewIndustry(TileIndex tile, IndustryType type, IndustryAv
 	return i;
 }
 
+/**
+ * Check whether #CreateNewIndustry may succeed, without changing the game state.
+ * Only the built-in checks that do not need commands or NewGRF callbacks are done.
+ * @param tile The location to build the industry.
+ * @param type The industry type to build.
+ * @param random The random number generator #CreateNewIndustry draws its random numbers from.
+ * @return False when #CreateNewIndustry is sure to fail.
+ */
+static bool MayCreateNewIndustry(TileIndex tile, IndustryType type, Randomizer random)
+{
+	const IndustrySpec *indspec = GetIndustrySpec(type);
+
+	random.Next(); // seed
+	random.Next(); // seed2
+	const IndustryTileLayout &layout = indspec->layouts[random.Next((uint32)indspec->layouts.size())];
+
+	if (CheckIfFarEnoughFromConflictingIndustry(tile, type).Failed()) return false;
+
+	for (const IndustryTileLayoutTile &it : layout) {
+		IndustryGfx gfx = GetTranslatedIndustryTileID(it.gfx);
+		TileIndex cur_tile = TileAddWrap(tile, it.ti.x, it.ti.y);
+
+		/* The same checks as in CheckIfIndustryTilesAreFree, up to the clearing of the tile. */
+		if (!IsValidTile(cur_tile)) return false;
+
+		if (gfx == GFX_WATERTILE_SPECIALCHECK) {
+			if (!IsWaterTile(cur_tile) || !IsTileFlat(cur_tile)) return false;
+			continue;
+		}
+
+		if (IsBridgeAbove(cur_tile)) return false;
+
+		const IndustryTileSpec *its = GetIndustryTileSpec(gfx);
+		if (!HasBit(its->slopes_refused, 5) && ((HasTileWaterClass(cur_tile) && IsTileOnWater(cur_tile)) == !(indspec->behaviour & INDUSTRYBEH_BUILT_ONWATER))) return false;
+		if ((indspec->behaviour & (INDUSTRYBEH_ONLY_INTOWN | INDUSTRYBEH_TOWN1200_MORE)) && !IsTileType(cur_tile, MP_HOUSE)) return false;
+	}
+
+	if (!HasBit(indspec->callback_mask, CBM_IND_LOCATION) && _check_new_industry_procs[indspec->check_proc](tile).Failed()) return false;
+
+	return true;
+}
+
 /**
  * Compute the appearance probability for an industry during map creation.
  * @param it Industry type to compute.
@@ -2253,12 +2404,16 @@ static uint GetNumberOfIndustries()
  */
 static Industry *PlaceIndustry(IndustryType type, IndustryAvailabilityCallType creation_type, bool try_hard)
 {
-	uint tries = try_hard ? 10000u : 2000u;
-	for (; tries > 0; tries--) {
-		Industry *ind = CreateNewIndustry(RandomTile(), type, creation_type);
-		if (ind != nullptr) return ind;
-	}
-	return nullptr;
+	Industry *ind = nullptr;
+	TryRandomTiles(try_hard ? 10000u : 2000u, 3,
+		[type](TileIndex tile, Randomizer random) {
+			return MayCreateNewIndustry(tile, type, random);
+		},
+		[&ind, type, creation_type](TileIndex tile) {
+			ind = CreateNewIndustry(tile, type, creation_type);
+			return ind != nullptr;
+		});
+	return ind;
 }
 
 /**
@@ -2975,6 +3130,7 @@ void InitializeIndustries()
 {
 	Industry::ResetIndustryCounts();
 	_industry_sound_tile = 0;
+	RebuildIndustrySchedule();
 
 	_industry_builder.Reset();
 }
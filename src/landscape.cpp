@@ -34,7 +34,11 @@
 #include "landscape_cmd.h"
 #include "terraform_cmd.h"
 #include "station_func.h"
+#include "road_map.h"
+#include "console_func.h"
+#include "pathfinder/yapf/yapf.h"
 #include <array>
+#include <chrono>
 #include <list>
 #include <set>
 
@@ -583,6 +587,7 @@ void DoClearSquare(TileIndex tile)
 	if (_tile_type_procs[GetTileType(tile)]->animate_tile_proc != nullptr) DeleteAnimatedTile(tile);
 
 	bool remove = IsDockingTile(tile);
+	if (MayHaveRoad(tile)) YapfNotifyRoadLayoutChange();
 	MakeClear(tile, CLEAR_GRASS, _generating_world ? 3 : 0);
 	MarkTileDirtyByTile(tile);
 	if (remove) RemoveDockingTile(tile);
@@ -843,6 +848,58 @@ void RunTileLoop()
 	_cur_tileloop_tile = tile;
 }
 
+#ifdef WITH_MAP_LAYOUT_BLOCKS
+/**
+ * Read every tile of the map together with its neighbours, like the queries of the pathfinders and drawing do.
+ * @return A sum of what was read.
+ */
+static uint ReadWholeMap()
+{
+	uint sum = 0;
+	for (TileIndex tile = 0; tile < MapSize(); tile++) {
+		int z;
+		sum += GetTileSlope(tile, &z) + z;
+		sum += GetTileTrackStatus(tile, TRANSPORT_RAIL, 0) + GetTileTrackStatus(tile, TRANSPORT_WATER, 0);
+	}
+	return sum;
+}
+
+/**
+ * Run the pathfinders, reading the whole map and the drawing of the main viewport with the
+ * tiles stored row by row and in blocks, and show how long they take.
+ * None of these change the game, so both layouts run the same work.
+ * @param rounds The number of queries of every vehicle, passes over the map and drawings of the viewport.
+ */
+void MapLayoutBenchmark(uint rounds)
+{
+	extern uint64 ViewportDrawingBenchmark(uint rounds); // screenshot.cpp
+
+	/* Load the sprites before anything is timed. */
+	ViewportDrawingBenchmark(1);
+
+	const bool blocked = IsMapLayoutBlocked();
+	for (bool layout_blocked : { false, true }) {
+		SetMapLayoutBlocked(layout_blocked);
+		IConsolePrint(CC_INFO, "Tiles stored {}:", layout_blocked ? "in blocks" : "row by row");
+
+		/* Both layouts start without the cached costs of the rail segments. */
+		YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+		YapfBenchmark(rounds);
+
+		auto start = std::chrono::steady_clock::now();
+		volatile uint sum = 0;
+		for (uint i = 0; i < rounds; i++) sum = sum + ReadWholeMap();
+		uint64 us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		IConsolePrint(CC_INFO, "Map: {} passes over the map in {} ms", rounds, us / 1000);
+
+		us = ViewportDrawingBenchmark(rounds);
+		if (us != 0) IConsolePrint(CC_INFO, "Viewport: {} drawings in {} ms", rounds, us / 1000);
+	}
+
+	SetMapLayoutBlocked(blocked);
+}
+#endif /* WITH_MAP_LAYOUT_BLOCKS */
+
 void InitializeLandscape()
 {
 	for (uint y = _settings_game.construction.freeform_edges ? 1 : 0; y < MapMaxY(); y++) {
@@ -1292,40 +1349,53 @@ static void River_GetNeighbours(AyStar *aystar, OpenListNode *current)
 	}
 }
 
+/**
+ * Make a tile of the path of a river a river tile, unless it is water already.
+ * @param tile The tile of the river.
+ */
+static void MakeRiverPathTile(TileIndex tile)
+{
+	if (IsWaterTile(tile)) return;
+
+	MakeRiver(tile, Random());
+	MarkTileDirtyByTile(tile);
+	/* Remove desert directly around the river tile. */
+	CircularTileSearch(&tile, RIVER_OFFSET_DESERT_DISTANCE, RiverModifyDesertZone, nullptr);
+}
+
+/**
+ * Widen a main river around a tile of its path, depending on how far the tile is away from the source.
+ * @param tile The tile of the river.
+ * @param spring The springing point of the river.
+ */
+static void WidenRiverPathTile(TileIndex tile, TileIndex spring)
+{
+	const uint long_river_length = _settings_game.game_creation.min_river_length * 4;
+
+	/* Check if we should widen river depending on how far we are away from the source. */
+	uint current_river_length = DistanceManhattan(spring, tile);
+	uint radius = std::min(3u, (current_river_length / (long_river_length / 3u)) + 1u);
+
+	TileIndex center = tile;
+	if (radius > 1) CircularTileSearch(&center, radius, RiverMakeWider, (void *)&tile);
+}
+
 /* AyStar callback when an route has been found. */
 static void River_FoundEndNode(AyStar *aystar, OpenListNode *current)
 {
 	River_UserData *data = (River_UserData *)aystar->user_data;
 
 	/* First, build the river without worrying about its width. */
-	uint cur_pos = 0;
-	for (PathNode *path = &current->path; path != nullptr; path = path->parent, cur_pos++) {
-		TileIndex tile = path->node.tile;
-		if (!IsWaterTile(tile)) {
-			MakeRiver(tile, Random());
-			MarkTileDirtyByTile(tile);
-			/* Remove desert directly around the river tile. */
-			CircularTileSearch(&tile, RIVER_OFFSET_DESERT_DISTANCE, RiverModifyDesertZone, nullptr);
-		}
+	for (PathNode *path = &current->path; path != nullptr; path = path->parent) {
+		MakeRiverPathTile(path->node.tile);
 	}
 
 	/* If the river is a main river, go back along the path to widen it.
 	 * Don't make wide rivers if we're using the original landscape generator.
 	 */
 	if (_settings_game.game_creation.land_generator != LG_ORIGINAL && data->main_river) {
-		const uint long_river_length = _settings_game.game_creation.min_river_length * 4;
-		uint current_river_length;
-		uint radius;
-
-		cur_pos = 0;
-		for (PathNode *path = &current->path; path != nullptr; path = path->parent, cur_pos++) {
-			TileIndex tile = path->node.tile;
-
-			/* Check if we should widen river depending on how far we are away from the source. */
-			current_river_length = DistanceManhattan(data->spring, tile);
-			radius = std::min(3u, (current_river_length / (long_river_length / 3u)) + 1u);
-
-			if (radius > 1) CircularTileSearch(&tile, radius, RiverMakeWider, (void *)&path->node.tile);
+		for (PathNode *path = &current->path; path != nullptr; path = path->parent) {
+			WidenRiverPathTile(path->node.tile, data->spring);
 		}
 	}
 }
@@ -1464,6 +1534,91 @@ static std::tuple<bool, bool> FlowRiver(TileIndex spring, TileIndex begin, uint
 	return { found, main_river };
 }
 
+static const uint8 RIVER_FLOW_WATER = DIAGDIR_END; ///< Flow field value of a water tile.
+static const uint8 RIVER_FLOW_NONE = 0xFF;        ///< Flow field value of a tile that can not flow down to water.
+
+/**
+ * Calculate for every tile in which direction a river from it has to flow to reach water.
+ * Starting at all water, the field is extended upstream over the tiles that flow down into
+ * already reached tiles, the cheapest way first. Like for the river pathfinder, passing a
+ * tile costs one plus a random part, so the rivers meander. As the costs are that small,
+ * every cost gets its own bucket of tiles instead of using a priority queue, which makes
+ * this linear in the number of tiles.
+ * @return For every tile the DiagDirection to flow to, RIVER_FLOW_WATER or RIVER_FLOW_NONE.
+ */
+static std::vector<uint8> CalculateRiverFlowField()
+{
+	const uint route_random = _settings_game.game_creation.river_route_random;
+	std::vector<uint8> flow(MapSize(), RIVER_FLOW_NONE);
+
+	/* The costs of tiles are 1 to route_random, so the buckets of route_random + 1 successive costs can be reused round robin. */
+	std::vector<std::vector<TileIndex>> buckets(route_random + 2);
+	size_t pending = 0;
+
+	for (TileIndex tile = 0; tile < MapSize(); tile++) {
+		if (!IsValidTile(tile) || !IsWaterTile(tile)) continue;
+		flow[tile] = RIVER_FLOW_WATER;
+		buckets[0].push_back(tile);
+		pending++;
+	}
+
+	for (uint cost = 0; pending > 0; cost++) {
+		std::vector<TileIndex> &bucket = buckets[cost % buckets.size()];
+		for (TileIndex tile : bucket) {
+			for (DiagDirection d = DIAGDIR_BEGIN; d < DIAGDIR_END; d++) {
+				TileIndex upstream = tile + TileOffsByDiagDir(d);
+				if (!IsValidTile(upstream) || flow[upstream] != RIVER_FLOW_NONE || !FlowsDown(upstream, tile)) continue;
+
+				/* All tiles with a lower cost have been done, so this is the cheapest way for the upstream tile. */
+				flow[upstream] = ReverseDiagDir(d);
+				buckets[(cost + 1 + RandomRange(route_random)) % buckets.size()].push_back(upstream);
+				pending++;
+			}
+		}
+		pending -= bucket.size();
+		bucket.clear();
+	}
+
+	return flow;
+}
+
+/**
+ * Try to flow a river down from its spring by following the flow field.
+ * When there is no way to water in the field, or terraforming for earlier rivers
+ * changed the way, the river is searched for like without the flow field.
+ * @param flow The flow field, see CalculateRiverFlowField.
+ * @param spring The springing point of the river.
+ * @param min_river_length The minimum length for the river.
+ * @return First element: True iff a river could/has been built, otherwise false; second element: River ends at sea.
+ */
+static std::tuple<bool, bool> FlowRiverAlongField(const std::vector<uint8> &flow, TileIndex spring, uint min_river_length)
+{
+	std::vector<TileIndex> path;
+	TileIndex end = spring;
+	while (!IsWaterTile(end)) {
+		uint8 dir = flow[end];
+		if (dir >= DIAGDIR_END) return FlowRiver(spring, spring, min_river_length);
+
+		TileIndex next = end + TileOffsByDiagDir((DiagDirection)dir);
+		if (!FlowsDown(end, next)) return FlowRiver(spring, spring, min_river_length);
+
+		path.push_back(end);
+		end = next;
+	}
+
+	if (DistanceManhattan(spring, end) <= min_river_length) return { false, false };
+
+	bool main_river = GetTileZ(end) == 0;
+	for (TileIndex tile : path) MakeRiverPathTile(tile);
+
+	/* Don't make wide rivers if we're using the original landscape generator. */
+	if (_settings_game.game_creation.land_generator != LG_ORIGINAL && main_river) {
+		for (auto it = path.rbegin(); it != path.rend(); ++it) WidenRiverPathTile(*it, spring);
+	}
+
+	return { true, main_river };
+}
+
 /**
  * Actually (try to) create some rivers.
  */
@@ -1476,13 +1631,16 @@ static void CreateRivers()
 	const uint num_short_rivers = wells - std::max(1u, wells / 10);
 	SetGeneratingWorldProgress(GWP_RIVER, wells + 256 / 64); // Include the tile loop calls below.
 
+	/* The way down to water of all springs at once. */
+	const std::vector<uint8> flow = CalculateRiverFlowField();
+
 	/* Try to create long rivers. */
 	for (; wells > num_short_rivers; wells--) {
 		IncreaseGeneratingWorldProgress(GWP_RIVER);
 		for (int tries = 0; tries < 512; tries++) {
 			TileIndex t = RandomTile();
 			if (!CircularTileSearch(&t, 8, FindSpring, nullptr)) continue;
-			if (std::get<0>(FlowRiver(t, t, _settings_game.game_creation.min_river_length * 4))) break;
+			if (std::get<0>(FlowRiverAlongField(flow, t, _settings_game.game_creation.min_river_length * 4))) break;
 		}
 	}
 
@@ -1492,7 +1650,7 @@ static void CreateRivers()
 		for (int tries = 0; tries < 128; tries++) {
 			TileIndex t = RandomTile();
 			if (!CircularTileSearch(&t, 8, FindSpring, nullptr)) continue;
-			if (std::get<0>(FlowRiver(t, t, _settings_game.game_creation.min_river_length))) break;
+			if (std::get<0>(FlowRiverAlongField(flow, t, _settings_game.game_creation.min_river_length))) break;
 		}
 	}
 
@@ -12,6 +12,8 @@
 #include "core/alloc_func.hpp"
 #include "water_map.h"
 #include "string_func.h"
+#include "pathfinder/water_regions.h"
+#include "tile_journal.h"
 
 #include "safeguards.h"
 
@@ -27,8 +29,31 @@ uint _map_size_y;    ///< Size of the map along the Y
 uint _map_size;      ///< The number of tiles on the map
 uint _map_tile_mask; ///< _map_size - 1 (to mask the mapsize)
 
-Tile *_m = nullptr;          ///< Tiles of the map
-TileExtended *_me = nullptr; ///< Extended Tiles of the map
+TileArray<Tile> _m;          ///< Tiles of the map
+TileArray<TileExtended> _me; ///< Extended Tiles of the map
+
+#ifdef WITH_MAP_LAYOUT_BLOCKS
+MapLayout _map_layout = { UINT32_MAX, 0, 0, 0 }; ///< The order the tiles of the map are stored in.
+static bool _map_layout_blocked = false;        ///< Whether the tiles are stored in blocks, see #MapLayout.
+
+/**
+ * Get the masks and shifts of the map layout for the current map size.
+ * @param blocked Whether the tiles are stored in blocks.
+ * @return The layout.
+ */
+static MapLayout GetMapLayout(bool blocked)
+{
+	if (!blocked) return { UINT32_MAX, 0, 0, 0 };
+
+	const uint32 block_mask = (1U << MAP_BLOCK_BITS) - 1;
+	MapLayout layout;
+	layout.x_mask = MapMaxX() & ~block_mask;
+	layout.y_mask = block_mask << MapLogX();
+	layout.keep_mask = ~(layout.x_mask | layout.y_mask);
+	layout.y_shift = MapLogX() - MAP_BLOCK_BITS;
+	return layout;
+}
+#endif /* WITH_MAP_LAYOUT_BLOCKS */
 
 
 /**
@@ -56,12 +81,54 @@ void AllocateMap(uint size_x, uint size_y)
 	_map_size = size_x * size_y;
 	_map_tile_mask = _map_size - 1;
 
-	free(_m);
-	free(_me);
+	free(_m.data);
+	free(_me.data);
+
+	_m.data = CallocT<Tile>(_map_size);
+	_me.data = CallocT<TileExtended>(_map_size);
+#ifdef WITH_MAP_LAYOUT_BLOCKS
+	_map_layout = GetMapLayout(_map_layout_blocked);
+#endif /* WITH_MAP_LAYOUT_BLOCKS */
 
-	_m = CallocT<Tile>(_map_size);
-	_me = CallocT<TileExtended>(_map_size);
+	AllocateWaterRegions();
+	ResetTileJournal();
+}
+
+#ifdef WITH_MAP_LAYOUT_BLOCKS
+/**
+ * Change the order the tiles of the map are stored in, also for the maps allocated after this.
+ * @param blocked Whether to store the tiles in blocks, see #MapLayout.
+ */
+void SetMapLayoutBlocked(bool blocked)
+{
+	if (blocked == _map_layout_blocked) return;
+	_map_layout_blocked = blocked;
+	if (_m.data == nullptr) return;
+
+	const MapLayout layout = GetMapLayout(blocked);
+	Tile *m = MallocT<Tile>(_map_size);
+	TileExtended *me = MallocT<TileExtended>(_map_size);
+	for (TileIndex tile = 0; tile < _map_size; tile++) {
+		m[GetTileStorageIndex(tile, layout)] = _m[tile];
+		me[GetTileStorageIndex(tile, layout)] = _me[tile];
+	}
+
+	free(_m.data);
+	free(_me.data);
+	_m.data = m;
+	_me.data = me;
+	_map_layout = layout;
+}
+
+/**
+ * Whether the tiles of the map are stored in blocks.
+ * @return True when they are stored in blocks, false when they are stored row by row.
+ */
+bool IsMapLayoutBlocked()
+{
+	return _map_layout_blocked;
 }
+#endif /* WITH_MAP_LAYOUT_BLOCKS */
 
 
 #ifdef _DEBUG
@@ -25,23 +25,82 @@ extern uint _map_tile_mask;
 
 #define TILE_MASK(x) ((x) & _map_tile_mask)
 
+#ifdef WITH_MAP_LAYOUT_BLOCKS
+static const uint MAP_BLOCK_BITS = 4; ///< 2^MAP_BLOCK_BITS is the number of tiles along the edge of a block of tiles in the blocked map layout.
+
+/**
+ * The order the tiles of the map are stored in. Either row by row, or in
+ * blocks of tiles, so tiles next to each other along the Y axis are near
+ * each other in memory too. Within a block the tiles are stored row by row,
+ * and the blocks themselves row by row too.
+ * The order only changes where the tiles are stored, not the tile indices.
+ * Only builds with OPTION_MAP_LAYOUT_BLOCKS can store the tiles in blocks,
+ * as looking up the layout costs time on every access of the map.
+ */
+struct MapLayout {
+	uint32 keep_mask; ///< Bits of the tile index that stay in place.
+	uint32 x_mask;    ///< Bits of the X coordinate above those within a block; they move up by #MAP_BLOCK_BITS.
+	uint32 y_mask;    ///< Bits of the Y coordinate within a block; they move down next to the X coordinate within the block.
+	uint y_shift;     ///< Number of bits the bits of #y_mask move down.
+};
+
+extern MapLayout _map_layout;
+
+/**
+ * Get where a tile is stored in the arrays of the map.
+ * @param tile The tile.
+ * @param layout The order the tiles are stored in.
+ * @return The index in the arrays of the map.
+ */
+static inline uint GetTileStorageIndex(TileIndex tile, const MapLayout &layout = _map_layout)
+{
+	return (tile & layout.keep_mask) | ((tile & layout.x_mask) << MAP_BLOCK_BITS) | ((tile & layout.y_mask) >> layout.y_shift);
+}
+#else
+/**
+ * Get where a tile is stored in the arrays of the map.
+ * @param tile The tile.
+ * @return The index in the arrays of the map; the tiles are stored row by row.
+ */
+static inline uint GetTileStorageIndex(TileIndex tile)
+{
+	return tile;
+}
+#endif /* WITH_MAP_LAYOUT_BLOCKS */
+
+/**
+ * One of the arrays of the map, indexed by tile.
+ * @tparam T The data of a tile in this array.
+ */
+template <class T>
+struct TileArray {
+	T *data = nullptr; ///< The data of the tiles, in the order of the map layout.
+
+	inline T &operator[](TileIndex tile) const
+	{
+		return this->data[GetTileStorageIndex(tile)];
+	}
+};
+
 /**
- * Pointer to the tile-array.
+ * The tile-array.
  *
- * This variable points to the tile-array which contains the tiles of
- * the map.
+ * This variable contains the tiles of the map.
  */
-extern Tile *_m;
+extern TileArray<Tile> _m;
 
 /**
- * Pointer to the extended tile-array.
+ * The extended tile-array.
  *
- * This variable points to the extended tile-array which contains the tiles
- * of the map.
+ * This variable contains the extended tiles of the map.
  */
-extern TileExtended *_me;
+extern TileArray<TileExtended> _me;
 
 void AllocateMap(uint size_x, uint size_y);
+#ifdef WITH_MAP_LAYOUT_BLOCKS
+void SetMapLayoutBlocked(bool blocked);
+bool IsMapLayoutBlocked();
+#endif /* WITH_MAP_LAYOUT_BLOCKS */
 
 /**
  * Logarithm of the map size along the X side.
@@ -81,7 +81,9 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	PoolBase::Clean(PT_NORMAL);
 
 	RebuildStationKdtree();
+	ResetStationCatchmentIndex();
 	RebuildTownKdtree();
+	RebuildTownGrowthSchedule();
 	RebuildViewportKdtree();
 
 	ResetPersistentNewGRFData();
@@ -0,0 +1,212 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file dary_heap.hpp D-ary heap implementation. */
+
+#ifndef DARY_HEAP_HPP
+#define DARY_HEAP_HPP
+
+#include <vector>
+
+/**
+ * D-ary Heap as C++ template.
+ *  A carrier which keeps its items automatically holds the smallest item at
+ *  the first position. The order of items is maintained by using a tree in
+ *  which every node has Tarity children. Compared to a binary heap, the tree
+ *  is less deep and the children of a node are next to each other in memory,
+ *  which makes inserting and removing cheaper.
+ *
+ * @par Usage information:
+ * Item of the heap should support the 'lower-than' operator '<'.
+ * It is used for comparing items before moving them to their position.
+ * Items should also support the methods GetHeapIndex() and SetHeapIndex(uint);
+ * the heap stores the position of an item in the item itself, so items can be
+ * removed from the heap, or have their key decreased, without searching them.
+ *
+ * @par
+ * This heap allocates just the space for item pointers. The items
+ * are allocated elsewhere.
+ *
+ * @tparam T Type of the items stored in the heap.
+ * @tparam Tarity Number of children of every node of the tree.
+ */
+template <class T, uint Tarity = 4>
+class CDaryHeapT {
+private:
+	std::vector<T *> data; ///< The item pointers, in heap order.
+
+	/**
+	 * Put an item at a position of the heap.
+	 * @param index The position.
+	 * @param item The item.
+	 */
+	inline void Place(uint index, T *item)
+	{
+		this->data[index] = item;
+		item->SetHeapIndex(index);
+	}
+
+	/**
+	 * Get position for fixing a gap (upwards).
+	 *  The gap is moved upwards in the tree until it is in order again.
+	 *
+	 * @param gap The position of the gap
+	 * @param item The proposed item for filling the gap
+	 * @return The (gap)position where the item fits
+	 */
+	inline uint HeapifyUp(uint gap, T *item)
+	{
+		while (gap > 0) {
+			uint parent = (gap - 1) / Tarity;
+			if (!(*item < *this->data[parent])) break;
+			this->Place(gap, this->data[parent]);
+			gap = parent;
+		}
+		return gap;
+	}
+
+	/**
+	 * Get position for fixing a gap (downwards).
+	 *  The gap is moved downwards in the tree until it is in order again.
+	 *
+	 * @param gap The position of the gap
+	 * @param item The proposed item for filling the gap
+	 * @return The (gap)position where the item fits
+	 */
+	inline uint HeapifyDown(uint gap, T *item)
+	{
+		uint count = (uint)this->data.size();
+		for (;;) {
+			uint first = gap * Tarity + 1;
+			if (first >= count) break;
+
+			/* choose the smallest child */
+			uint last = std::min(first + Tarity, count);
+			uint child = first;
+			for (uint i = first + 1; i < last; i++) {
+				if (*this->data[i] < *this->data[child]) child = i;
+			}
+			/* the smallest child is still bigger or same as the item => we are done */
+			if (!(*this->data[child] < *item)) break;
+
+			this->Place(gap, this->data[child]);
+			gap = child;
+		}
+		return gap;
+	}
+
+public:
+	/**
+	 * Create a heap.
+	 * @param initial_capacity The number of items to reserve space for.
+	 */
+	explicit CDaryHeapT(uint initial_capacity)
+	{
+		this->data.reserve(initial_capacity);
+	}
+
+	/**
+	 * Get the number of items stored in the priority queue.
+	 *
+	 *  @return The number of items in the queue
+	 */
+	inline uint Length() const
+	{
+		return (uint)this->data.size();
+	}
+
+	/**
+	 * Test if the priority queue is empty.
+	 *
+	 * @return True if empty
+	 */
+	inline bool IsEmpty() const
+	{
+		return this->data.empty();
+	}
+
+	/**
+	 * Get the smallest item in the heap.
+	 *
+	 * @return The smallest item, or throw assert if empty.
+	 */
+	inline T *Begin()
+	{
+		assert(!this->IsEmpty());
+		return this->data[0];
+	}
+
+	/**
+	 * Insert new item into the priority queue, maintaining heap order.
+	 *
+	 * @param new_item The pointer to the new item
+	 */
+	inline void Include(T *new_item)
+	{
+		this->data.push_back(new_item);
+		uint gap = this->HeapifyUp((uint)this->data.size() - 1, new_item);
+		this->Place(gap, new_item);
+	}
+
+	/**
+	 * Remove an item from the priority queue.
+	 *
+	 * @param item The item to remove; it must be in the queue.
+	 */
+	inline void Remove(T &item)
+	{
+		uint index = item.GetHeapIndex();
+		assert(index < this->data.size() && this->data[index] == &item);
+
+		T *last = this->data.back();
+		this->data.pop_back();
+		if (index == this->data.size()) return;
+
+		/* at position index we have a gap now; fix the tree up and downwards */
+		uint gap = this->HeapifyUp(index, last);
+		if (gap == index) gap = this->HeapifyDown(index, last);
+		this->Place(gap, last);
+	}
+
+	/**
+	 * Remove and return the smallest (and also first) item
+	 *  from the priority queue.
+	 *
+	 * @return The pointer to the removed item
+	 */
+	inline T *Shift()
+	{
+		T *first = this->Begin();
+		this->Remove(*first);
+		return first;
+	}
+
+	/**
+	 * Restore the heap order after the key of an item decreased.
+	 *
+	 * @param item The item whose key decreased; it must be in the queue.
+	 */
+	inline void DecreaseKey(T &item)
+	{
+		uint index = item.GetHeapIndex();
+		assert(index < this->data.size() && this->data[index] == &item);
+
+		uint gap = this->HeapifyUp(index, &item);
+		this->Place(gap, &item);
+	}
+
+	/**
+	 * Make the priority queue empty.
+	 * All remaining items will remain untouched.
+	 */
+	inline void Clear()
+	{
+		this->data.clear();
+	}
+};
+
+#endif /* DARY_HEAP_HPP */
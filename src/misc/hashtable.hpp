@@ -11,6 +11,7 @@
 #define HASHTABLE_HPP
 
 #include "../core/math_func.hpp"
+#include <vector>
 
 template <class Titem_>
 struct CHashTableSlotT
@@ -254,4 +255,169 @@ public:
 	}
 };
 
+/**
+ * class COpenHashTableT<Titem, Thash_bits> - hash table of pointers allocated
+ *  elsewhere, using open addressing with linear probing.
+ *
+ *  Supports: Add/Find/Remove of Titems.
+ *
+ *  It has the same interface and requirements as CHashTableT, except that the
+ *  items do not need to link to each other. The slots hold the pointer to the
+ *  item together with the hash of its key, so searching mostly stays within a
+ *  single cache line instead of following the chain of items. The table starts
+ *  with 2^Thash_bits slots and doubles in size when it becomes half full.
+ */
+template <class Titem_, int Thash_bits_>
+class COpenHashTableT {
+public:
+	typedef Titem_ Titem;                         // make Titem_ visible from outside of class
+	typedef typename Titem_::Key Tkey;            // make Titem_::Key a property of HashTable
+	static const int Thash_bits = Thash_bits_;    // publish initial num of hash bits
+
+protected:
+	/** A slot of the table; empty when it has no item. */
+	struct Slot {
+		Titem_ *m_item; // the item in this slot
+		uint32  m_hash; // hash of the key of the item
+	};
+
+	std::vector<Slot> m_slots; // the slots, 2^m_hash_bits of them
+	int   m_hash_bits;         // current num of hash bits
+	int   m_num_items;         // item counter
+
+public:
+	/* default constructor */
+	inline COpenHashTableT() : m_slots(1 << Thash_bits_), m_hash_bits(Thash_bits_), m_num_items(0)
+	{
+	}
+
+protected:
+	/** static helper - return the slot where the search for the given hash starts */
+	inline uint CalcSlot(uint32 hash) const
+	{
+		/* Fibonacci hashing; the keys' hashes tend to have most of their entropy in the low bits */
+		return (hash * 0x9E3779B9U) >> (32 - m_hash_bits);
+	}
+
+	/** find the slot index of the item with the given key, or of the empty slot where it would be */
+	inline uint FindSlot(const Tkey &key, uint32 hash) const
+	{
+		uint mask = (uint)m_slots.size() - 1;
+		uint index = CalcSlot(hash);
+		for (;;) {
+			const Slot &slot = m_slots[index];
+			if (slot.m_item == nullptr) return index;
+			if (slot.m_hash == hash && slot.m_item->GetKey() == key) return index;
+			index = (index + 1) & mask;
+		}
+	}
+
+	/** remove the item from the given slot, moving the items after it so they can still be found */
+	void RemoveSlot(uint index)
+	{
+		uint mask = (uint)m_slots.size() - 1;
+		uint gap = index;
+		for (uint next = (gap + 1) & mask; m_slots[next].m_item != nullptr; next = (next + 1) & mask) {
+			/* the item can move to the gap if its search starts at or before the gap */
+			uint home = CalcSlot(m_slots[next].m_hash);
+			if (((next - home) & mask) >= ((next - gap) & mask)) {
+				m_slots[gap] = m_slots[next];
+				gap = next;
+			}
+		}
+		m_slots[gap].m_item = nullptr;
+		m_num_items--;
+	}
+
+	/** double the number of slots */
+	void Grow()
+	{
+		std::vector<Slot> old_slots(m_slots.size() * 2);
+		old_slots.swap(m_slots);
+		m_hash_bits++;
+
+		uint mask = (uint)m_slots.size() - 1;
+		for (const Slot &slot : old_slots) {
+			if (slot.m_item == nullptr) continue;
+			uint index = CalcSlot(slot.m_hash);
+			while (m_slots[index].m_item != nullptr) index = (index + 1) & mask;
+			m_slots[index] = slot;
+		}
+	}
+
+public:
+	/** item count */
+	inline int Count() const
+	{
+		return m_num_items;
+	}
+
+	/** simple clear - forget all items */
+	inline void Clear()
+	{
+		for (Slot &slot : m_slots) slot.m_item = nullptr;
+		m_num_items = 0;
+	}
+
+	/** const item search */
+	const Titem_ *Find(const Tkey &key) const
+	{
+		return m_slots[FindSlot(key, key.CalcHash())].m_item;
+	}
+
+	/** non-const item search */
+	Titem_ *Find(const Tkey &key)
+	{
+		return m_slots[FindSlot(key, key.CalcHash())].m_item;
+	}
+
+	/** non-const item search & optional removal (if found) */
+	Titem_ *TryPop(const Tkey &key)
+	{
+		uint index = FindSlot(key, key.CalcHash());
+		Titem_ *item = m_slots[index].m_item;
+		if (item != nullptr) RemoveSlot(index);
+		return item;
+	}
+
+	/** non-const item search & removal */
+	Titem_& Pop(const Tkey &key)
+	{
+		Titem_ *item = TryPop(key);
+		assert(item != nullptr);
+		return *item;
+	}
+
+	/** non-const item search & optional removal (if found) */
+	bool TryPop(Titem_ &item)
+	{
+		const Tkey &key = item.GetKey();
+		uint index = FindSlot(key, key.CalcHash());
+		if (m_slots[index].m_item != &item) return false;
+		RemoveSlot(index);
+		return true;
+	}
+
+	/** non-const item search & removal */
+	void Pop(Titem_ &item)
+	{
+		[[maybe_unused]] bool ret = TryPop(item);
+		assert(ret);
+	}
+
+	/** add one item */
+	void Push(Titem_ &new_item)
+	{
+		if ((m_num_items + 1) * 2 > (int)m_slots.size()) Grow();
+
+		const Tkey &key = new_item.GetKey();
+		uint32 hash = key.CalcHash();
+		uint index = FindSlot(key, hash);
+		assert(m_slots[index].m_item == nullptr);
+		m_slots[index].m_item = &new_item;
+		m_slots[index].m_hash = hash;
+		m_num_items++;
+	}
+};
+
 #endif /* HASHTABLE_HPP */
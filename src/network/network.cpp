@@ -77,6 +77,8 @@ uint32 _sync_seed_1;                  ///< Seed to compare during sync checks.
 uint32 _sync_seed_2;                  ///< Second part of the seed.
 #endif
 uint32 _sync_frame;                   ///< The frame to perform the sync check.
+StateHash _sync_state_hash;           ///< Hash of the game state to compare during sync checks.
+bool _sync_state_hash_valid;          ///< Whether #_sync_state_hash is set for the current sync check.
 bool _network_first_time;             ///< Whether we have finished joining or not.
 CompanyMask _network_company_passworded; ///< Bitmask of the password status of all companies.
 
@@ -604,6 +606,7 @@ void NetworkClose(bool close_admins)
 
 	_networking = false;
 	_network_server = false;
+	StopStateHash();
 
 	NetworkFreeLocalCommandQueue();
 
@@ -619,6 +622,7 @@ static void NetworkInitialize(bool close_admins = true)
 	InitializeNetworkPools(close_admins);
 
 	_sync_frame = 0;
+	_sync_state_hash_valid = false;
 	_network_first_time = true;
 
 	_network_reconnect = 0;
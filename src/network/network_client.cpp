@@ -271,10 +271,25 @@ void ClientNetworkGameSocketHandler::ClientError(NetworkRecvStatus res)
 	if (_sync_frame != 0) {
 		if (_sync_frame == _frame_counter) {
 #ifdef NETWORK_SEND_DOUBLE_SEED
-			if (_sync_seed_1 != _random.state[0] || _sync_seed_2 != _random.state[1]) {
+			bool in_sync = _sync_seed_1 == _random.state[0] && _sync_seed_2 == _random.state[1];
 #else
-			if (_sync_seed_1 != _random.state[0]) {
+			bool in_sync = _sync_seed_1 == _random.state[0];
 #endif
+
+			if (_sync_state_hash_valid) {
+				/* Tell which parts of the game state differ, to find the cause of the desync. */
+				StateHash state_hash;
+				state_hash.Compute();
+				for (StateHashPart part = SHP_BEGIN; part < SHP_END; part++) {
+					if (state_hash.part[part] == _sync_state_hash.part[part]) continue;
+
+					Debug(desync, 1, "sync_err_state: {:08x}; {:02x}; {}", _date, _date_fract, GetStateHashPartName(part));
+					Debug(net, 0, "Game state differs in the {} at frame {}", GetStateHashPartName(part), _frame_counter);
+					in_sync = false;
+				}
+			}
+
+			if (!in_sync) {
 				ShowNetworkError(STR_NETWORK_ERROR_DESYNC);
 				Debug(desync, 1, "sync_err: {:08x}; {:02x}", _date, _date_fract);
 				Debug(net, 0, "Sync error detected");
@@ -865,6 +880,7 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_FRAME(Packet *p
 	if (p->CanReadFromPacket(sizeof(uint32))) {
 #endif
 		_sync_frame = _frame_counter_server;
+		_sync_state_hash_valid = false;
 		_sync_seed_1 = p->Recv_uint32();
 #ifdef NETWORK_SEND_DOUBLE_SEED
 		_sync_seed_2 = p->Recv_uint32();
@@ -896,6 +912,13 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_SYNC(Packet *p)
 #ifdef NETWORK_SEND_DOUBLE_SEED
 	_sync_seed_2 = p->Recv_uint32();
 #endif
+	/* The server may send the hashes of its game state too. */
+	_sync_state_hash_valid = p->CanReadFromPacket(sizeof(uint32) * SHP_END);
+	if (_sync_state_hash_valid) {
+		for (StateHashPart part = SHP_BEGIN; part < SHP_END; part++) {
+			_sync_state_hash.part[part] = p->Recv_uint32();
+		}
+	}
 
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -16,6 +16,7 @@
 
 #include "../command_type.h"
 #include "../command_func.h"
+#include "../state_hash.h"
 #include "../misc/endian_buffer.hpp"
 
 #ifdef RANDOM_DEBUG
@@ -79,6 +80,8 @@ extern uint32 _sync_seed_1;
 extern uint32 _sync_seed_2;
 #endif
 extern uint32 _sync_frame;
+extern StateHash _sync_state_hash;
+extern bool _sync_state_hash_valid;
 extern bool _network_first_time;
 /* Vars needed for the join-GUI */
 extern NetworkJoinStatus _network_join_status;
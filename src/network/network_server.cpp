@@ -618,6 +618,13 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame()
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/** Recompute the hash of the game state sent along with the sync packets, if enabled. */
+static void UpdateSyncStateHash()
+{
+	_sync_state_hash_valid = _settings_client.network.sync_state_hash;
+	if (_sync_state_hash_valid) _sync_state_hash.Compute();
+}
+
 /** Request the client to sync. */
 NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync()
 {
@@ -628,6 +635,12 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync()
 #ifdef NETWORK_SEND_DOUBLE_SEED
 	p->Send_uint32(_sync_seed_2);
 #endif
+	/* Optionally the hashes of the game state, which clients not knowing about them just ignore. */
+	if (_sync_state_hash_valid) {
+		for (StateHashPart part = SHP_BEGIN; part < SHP_END; part++) {
+			p->Send_uint32(_sync_state_hash.part[part]);
+		}
+	}
 	this->SendPacket(p);
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -979,6 +992,7 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_MAP_OK(Packet *
 		this->status = STATUS_PRE_ACTIVE;
 		NetworkHandleCommandQueue(this);
 		this->SendFrame();
+		UpdateSyncStateHash();
 		this->SendSync();
 
 		/* This is the frame the client receives
@@ -1688,6 +1702,7 @@ void NetworkServer_Tick(bool send_frame)
 	if (_frame_counter >= _last_sync_frame + _settings_client.network.sync_freq) {
 		_last_sync_frame = _frame_counter;
 		send_sync = true;
+		UpdateSyncStateHash();
 	}
 #endif
 
@@ -5153,6 +5153,7 @@ static void NewSpriteGroup(ByteReader *buf)
 				}
 			}
 
+			group->Compile();
 			break;
 		}
 
@@ -8697,6 +8698,7 @@ void ResetNewGRFData()
 	_grf_id_overrides.clear();
 
 	InitializeSoundPool();
+	ClearResolverCache();
 	_spritegroup_pool.CleanPool();
 }
 
@@ -9833,6 +9835,8 @@ void LoadNewGRF(uint load_index, uint num_baseset)
 	uint64 tick_counter  = _tick_counter;
 	byte display_opt     = _display_opt;
 
+	auto start_time = std::chrono::steady_clock::now();
+
 	if (_networking) {
 		_cur_year     = _settings_game.game_creation.starting_year;
 		_date         = ConvertYMDToDate(_cur_year, 0, 1);
@@ -9879,6 +9883,12 @@ void LoadNewGRF(uint load_index, uint num_baseset)
 			}
 		}
 
+		if (stage == GLS_INIT) {
+			/* The label scan opened all files. Their sprite sections are needed from
+			 * now on, and indexing them does not depend on the other NewGRFs. */
+			ReadAllGRFSpriteOffsets();
+		}
+
 		uint num_grfs = 0;
 		uint num_non_static = 0;
 
@@ -9930,6 +9940,8 @@ void LoadNewGRF(uint load_index, uint num_baseset)
 	/* Call any functions that should be run after GRFs have been loaded. */
 	AfterLoadGRFs();
 
+	Debug(grf, 1, "Loaded NewGRFs in {} ms", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count());
+
 	/* Now revert back to the original situation */
 	_cur_year     = year;
 	_date         = date;
@@ -359,13 +359,13 @@ static bool CalcGRFMD5Sum(GRFConfig *config, Subdirectory subdir)
 
 
 /**
- * Find the GRFID of a given grf, and calculate its md5sum.
+ * Find the GRFID of a given grf, without calculating its md5sum.
  * @param config    grf to fill.
  * @param is_static grf is static.
  * @param subdir    the subdirectory to search in.
  * @return Operation was successfully completed.
  */
-bool FillGRFDetails(GRFConfig *config, bool is_static, Subdirectory subdir)
+static bool ReadGRFDetails(GRFConfig *config, bool is_static, Subdirectory subdir)
 {
 	if (!FioCheckFileExists(config->filename, subdir)) {
 		config->status = GCS_NOT_FOUND;
@@ -388,7 +388,19 @@ bool FillGRFDetails(GRFConfig *config, bool is_static, Subdirectory subdir)
 		if (HasBit(config->flags, GCF_UNSAFE)) return false;
 	}
 
-	return CalcGRFMD5Sum(config, subdir);
+	return true;
+}
+
+/**
+ * Find the GRFID of a given grf, and calculate its md5sum.
+ * @param config    grf to fill.
+ * @param is_static grf is static.
+ * @param subdir    the subdirectory to search in.
+ * @return Operation was successfully completed.
+ */
+bool FillGRFDetails(GRFConfig *config, bool is_static, Subdirectory subdir)
+{
+	return ReadGRFDetails(config, is_static, subdir) && CalcGRFMD5Sum(config, subdir);
 }
 
 
@@ -583,6 +595,9 @@ int _skip_all_newgrf_scanning = 0;
 class GRFFileScanner : FileScanner {
 	std::chrono::steady_clock::time_point next_update; ///< The next moment we do update the screen.
 	uint num_scanned; ///< The number of GRFs we have scanned.
+	std::vector<GRFConfig *> found; ///< The NewGRFs found by the scan, in order of scanning; their md5sum is not calculated yet.
+
+	uint AddFoundGRFs();
 
 public:
 	GRFFileScanner() : num_scanned(0)
@@ -600,11 +615,16 @@ public:
 			return 0;
 		}
 
+		auto start_time = std::chrono::steady_clock::now();
+
 		GRFFileScanner fs;
-		int ret = fs.Scan(".grf", NEWGRF_DIR);
+		fs.Scan(".grf", NEWGRF_DIR);
+		uint ret = fs.AddFoundGRFs();
 		/* The number scanned and the number returned may not be the same;
 		 * duplicate NewGRFs and base sets are ignored in the return value. */
 		_settings_client.gui.last_newgrf_count = fs.num_scanned;
+
+		Debug(grf, 1, "Scanned {} NewGRFs in {} ms", fs.num_scanned, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count());
 		return ret;
 	}
 };
@@ -616,34 +636,8 @@ bool GRFFileScanner::AddFile(const std::string &filename, size_t basepath_length
 
 	GRFConfig *c = new GRFConfig(filename.c_str() + basepath_length);
 
-	bool added = true;
-	if (FillGRFDetails(c, false)) {
-		if (_all_grfs == nullptr) {
-			_all_grfs = c;
-		} else {
-			/* Insert file into list at a position determined by its
-			 * name, so the list is sorted as we go along */
-			GRFConfig **pd, *d;
-			bool stop = false;
-			for (pd = &_all_grfs; (d = *pd) != nullptr; pd = &d->next) {
-				if (c->ident.grfid == d->ident.grfid && memcmp(c->ident.md5sum, d->ident.md5sum, sizeof(c->ident.md5sum)) == 0) added = false;
-				/* Because there can be multiple grfs with the same name, make sure we checked all grfs with the same name,
-				 *  before inserting the entry. So insert a new grf at the end of all grfs with the same name, instead of
-				 *  just after the first with the same name. Avoids doubles in the list. */
-				if (strcasecmp(c->GetName(), d->GetName()) <= 0) {
-					stop = true;
-				} else if (stop) {
-					break;
-				}
-			}
-			if (added) {
-				c->next = d;
-				*pd = c;
-			}
-		}
-	} else {
-		added = false;
-	}
+	bool added = ReadGRFDetails(c, false, NEWGRF_DIR);
+	if (added) this->found.push_back(c);
 
 	this->num_scanned++;
 
@@ -655,13 +649,69 @@ bool GRFFileScanner::AddFile(const std::string &filename, size_t basepath_length
 
 	if (!added) {
 		/* File couldn't be opened, or is either not a NewGRF or is a
-		 * 'system' NewGRF or it's already known, so forget about it. */
+		 * 'system' NewGRF, so forget about it. */
 		delete c;
 	}
 
 	return added;
 }
 
+/**
+ * Calculate the md5sums of the found NewGRFs and add them to the list of all NewGRFs.
+ * Calculating an md5sum only needs the file itself, so that is done in parallel.
+ * @return The number of NewGRFs added to the list.
+ */
+uint GRFFileScanner::AddFoundGRFs()
+{
+	std::vector<byte> md5_ok(this->found.size());
+	ParallelFor("ottd:grfmd5", this->found.size(), [this, &md5_ok](size_t i) {
+		md5_ok[i] = CalcGRFMD5Sum(this->found[i], NEWGRF_DIR);
+	});
+
+	uint num_added = 0;
+	for (size_t i = 0; i < this->found.size(); i++) {
+		GRFConfig *c = this->found[i];
+
+		bool added = md5_ok[i] != 0;
+		if (added && _exit_game) added = false;
+		if (added) {
+			if (_all_grfs == nullptr) {
+				_all_grfs = c;
+			} else {
+				/* Insert file into list at a position determined by its
+				 * name, so the list is sorted as we go along */
+				GRFConfig **pd, *d;
+				bool stop = false;
+				for (pd = &_all_grfs; (d = *pd) != nullptr; pd = &d->next) {
+					if (c->ident.grfid == d->ident.grfid && memcmp(c->ident.md5sum, d->ident.md5sum, sizeof(c->ident.md5sum)) == 0) added = false;
+					/* Because there can be multiple grfs with the same name, make sure we checked all grfs with the same name,
+					 *  before inserting the entry. So insert a new grf at the end of all grfs with the same name, instead of
+					 *  just after the first with the same name. Avoids doubles in the list. */
+					if (strcasecmp(c->GetName(), d->GetName()) <= 0) {
+						stop = true;
+					} else if (stop) {
+						break;
+					}
+				}
+				if (added) {
+					c->next = d;
+					*pd = c;
+				}
+			}
+		}
+
+		if (added) {
+			num_added++;
+		} else {
+			/* The md5sum couldn't be calculated or the NewGRF is already known, so forget about it. */
+			delete c;
+		}
+	}
+	this->found.clear();
+
+	return num_added;
+}
+
 /**
  * Simple sorter for GRFS
  * @param c1 the first GRFConfig *
@@ -313,6 +313,11 @@ static byte MapAircraftMovementAction(const Aircraft *v)
 	return this->v == nullptr ? 0 : this->v->waiting_triggers;
 }
 
+/* virtual */ uint64 VehicleScopeResolver::GetCacheKey() const
+{
+	return this->v == nullptr ? 0 : (uint64)this->v->index + 1;
+}
+
 
 /* virtual */ ScopeResolver *VehicleResolverObject::GetScope(VarSpriteGroupScope scope, byte relative)
 {
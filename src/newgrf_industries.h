@@ -33,6 +33,7 @@ struct IndustriesScopeResolver : public ScopeResolver {
 	}
 
 	uint32 GetRandomBits() const override;
+	uint64 GetCacheKey() const override { return (uint64)this->tile + 1; }
 	uint32 GetVariable(byte variable, uint32 parameter, bool *available) const override;
 	uint32 GetTriggers() const override;
 	void StorePSA(uint pos, int32 value) override;
@@ -118,6 +118,7 @@ struct ObjectScopeResolver : public ScopeResolver {
 	}
 
 	uint32 GetRandomBits() const override;
+	uint64 GetCacheKey() const override { return (uint64)this->tile + 1; }
 	uint32 GetVariable(byte variable, uint32 parameter, bool *available) const override;
 };
 
@@ -47,6 +47,7 @@ void NewGRFProfiler::BeginResolve(const ResolverObject &resolver)
 	using namespace std::chrono;
 	this->cur_call.root_sprite = resolver.root_spritegroup->nfo_line;
 	this->cur_call.subs = 0;
+	this->cur_call.cached = false;
 	this->cur_call.time = (uint32)time_point_cast<microseconds>(high_resolution_clock::now()).time_since_epoch().count();
 	this->cur_call.tick = _tick_counter;
 	this->cur_call.cb = resolver.callback;
@@ -83,6 +84,14 @@ void NewGRFProfiler::RecursiveResolve()
 	this->cur_call.subs += 1;
 }
 
+/**
+ * Capture that the result of a sprite group resolution was taken from the resolver cache.
+ */
+void NewGRFProfiler::CachedResolve()
+{
+	this->cur_call.cached = true;
+}
+
 void NewGRFProfiler::Start()
 {
 	this->Abort();
@@ -106,13 +115,17 @@ uint32 NewGRFProfiler::Finish()
 	FileCloser fcloser(f);
 
 	uint32 total_microseconds = 0;
+	size_t cached_calls = 0;
 
-	fputs("Tick,Sprite,Feature,Item,CallbackID,Microseconds,Depth,Result\n", f);
+	fputs("Tick,Sprite,Feature,Item,CallbackID,Microseconds,Depth,Result,Cached\n", f);
 	for (const Call &c : this->calls) {
-		fprintf(f, OTTD_PRINTF64U ",%u,0x%X,%u,0x%X,%u,%u,%u\n", c.tick, c.root_sprite, c.feat, c.item, (uint)c.cb, c.time, c.subs, c.result);
+		fprintf(f, OTTD_PRINTF64U ",%u,0x%X,%u,0x%X,%u,%u,%u,%u\n", c.tick, c.root_sprite, c.feat, c.item, (uint)c.cb, c.time, c.subs, c.result, c.cached ? 1 : 0);
 		total_microseconds += c.time;
+		if (c.cached) cached_calls++;
 	}
 
+	IConsolePrint(CC_DEBUG, "Resolver cache hit rate of NewGRF [{:08X}]: {} of {} events ({}%).", BSWAP32(this->grffile->grfid), cached_calls, this->calls.size(), cached_calls * 100 / this->calls.size());
+
 	this->Abort();
 
 	return total_microseconds;
@@ -30,6 +30,7 @@ struct NewGRFProfiler {
 	void BeginResolve(const ResolverObject &resolver);
 	void EndResolve(const SpriteGroup *result);
 	void RecursiveResolve();
+	void CachedResolve();
 
 	void Start();
 	uint32 Finish();
@@ -44,6 +45,7 @@ struct NewGRFProfiler {
 		uint32 item;         ///< Local ID of item being resolved for
 		uint32 result;       ///< Result of callback
 		uint32 subs;         ///< Sub-calls to other sprite groups
+		bool cached;         ///< Result was taken from the resolver cache
 		uint32 time;         ///< Time taken for resolution (microseconds)
 		uint64 tick;         ///< Game tick
 		CallbackID cb;       ///< Callback ID
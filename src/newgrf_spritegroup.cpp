@@ -12,6 +12,10 @@
 #include "newgrf_spritegroup.h"
 #include "newgrf_profiling.h"
 #include "core/pool_func.hpp"
+#include "date_func.h"
+#include "settings_type.h"
+
+#include <unordered_map>
 
 #include "safeguards.h"
 
@@ -20,6 +24,85 @@ INSTANTIATE_POOL_METHODS(SpriteGroup)
 
 TemporaryStorageArray<int32, 0x110> _temp_store;
 
+/** A variable read while resolving, to validate a cached result against. */
+struct ResolverCacheRead {
+	VarSpriteGroupScope scope; ///< Scope the variable was read from.
+	byte relative;             ///< Parameter of the relative scope.
+	bool random_bits;          ///< The random bits of the scope were read instead of a variable.
+	byte variable;             ///< Variable that was read.
+	uint32 parameter;          ///< Parameter of the variable.
+	uint32 value;              ///< Value that was read.
+	bool available;            ///< Whether the variable was available.
+
+	/**
+	 * Whether this read is of the same variable as another read.
+	 * @param other The other read.
+	 * @return True if both read the same variable of the same scope.
+	 */
+	bool IsSameVariable(const ResolverCacheRead &other) const
+	{
+		return this->scope == other.scope && this->relative == other.relative && this->random_bits == other.random_bits &&
+				this->variable == other.variable && this->parameter == other.parameter;
+	}
+};
+
+/** Result of resolving a sprite group chain, together with everything it depended on. */
+struct ResolverCacheEntry {
+	std::vector<ResolverCacheRead> reads;       ///< Distinct variables read, in the order they were first read.
+	uint evaluated;                             ///< Number of variables the chain evaluated, including repeated reads of the same variable.
+	std::vector<std::pair<uint, int32>> stores; ///< Values stored into the temporary storage, in the order they were stored.
+	const SpriteGroup *result;                  ///< Resolved group.
+	uint16 calculated_result;                   ///< Callback result, if #result is the calculated result group.
+	uint32 last_value;                          ///< ResolverObject::last_value after resolving.
+	bool cacheable;                             ///< Resolving had no other side effects, so the result can be reused.
+};
+
+/** Everything the result of resolving depends on, except for the variables read. */
+struct ResolverCacheKey {
+	const SpriteGroup *group; ///< Root group.
+	uint64 object;            ///< Identifier of the object, see #ScopeResolver::GetCacheKey.
+	CallbackID callback;      ///< Callback being resolved.
+	uint32 callback_param1;   ///< First parameter of the callback.
+	uint32 callback_param2;   ///< Second parameter of the callback.
+	uint32 last_value;        ///< ResolverObject::last_value before resolving.
+
+	bool operator ==(const ResolverCacheKey &other) const
+	{
+		return this->group == other.group && this->object == other.object && this->callback == other.callback &&
+				this->callback_param1 == other.callback_param1 && this->callback_param2 == other.callback_param2 && this->last_value == other.last_value;
+	}
+};
+
+/** Hash function for #ResolverCacheKey. */
+struct ResolverCacheKeyHash {
+	size_t operator ()(const ResolverCacheKey &key) const
+	{
+		size_t hash = std::hash<const SpriteGroup *>()(key.group);
+		hash = hash * 31 + std::hash<uint64>()(key.object);
+		hash = hash * 31 + key.callback;
+		hash = hash * 31 + key.callback_param1;
+		hash = hash * 31 + key.callback_param2;
+		hash = hash * 31 + key.last_value;
+		return hash;
+	}
+};
+
+static const size_t RESOLVER_CACHE_MAX_SIZE = 1 << 16; ///< Maximum number of results in the resolver cache, before it is flushed.
+
+static std::unordered_map<ResolverCacheKey, ResolverCacheEntry, ResolverCacheKeyHash> _resolver_cache; ///< Results of resolving during the current tick.
+static uint64 _resolver_cache_tick;                                    ///< Tick the results in #_resolver_cache belong to.
+static std::vector<ResolverCacheEntry *> _resolver_cache_recordings; ///< Results currently being resolved and recorded.
+static CallbackResultSpriteGroup _calculated_result_group(0, true);    ///< Result of deterministic groups with a calculated result.
+
+/**
+ * Forget all cached results of resolving.
+ * Must be called when the sprite groups are freed.
+ */
+void ClearResolverCache()
+{
+	_resolver_cache.clear();
+}
+
 
 /**
  * ResolverObject (re)entry point.
@@ -39,12 +122,17 @@ TemporaryStorageArray<int32, 0x110> _temp_store;
 	auto profiler = std::find_if(_newgrf_profilers.begin(), _newgrf_profilers.end(), [&](const NewGRFProfiler &pr) { return pr.grffile == grf; });
 
 	if (profiler == _newgrf_profilers.end() || !profiler->active) {
-		if (top_level) _temp_store.ClearChanges();
-		return group->Resolve(object);
+		if (!top_level) return group->Resolve(object);
+
+		_temp_store.ClearChanges();
+		bool cached;
+		return ResolveTopLevel(group, object, &cached);
 	} else if (top_level) {
 		profiler->BeginResolve(object);
 		_temp_store.ClearChanges();
-		const SpriteGroup *result = group->Resolve(object);
+		bool cached;
+		const SpriteGroup *result = ResolveTopLevel(group, object, &cached);
+		if (cached) profiler->CachedResolve();
 		profiler->EndResolve(result);
 		return result;
 	} else {
@@ -78,6 +166,129 @@ static inline uint32 GetVariable(const ResolverObject &object, ScopeResolver *sc
 	}
 }
 
+/**
+ * Add a read to a result being recorded for the resolver cache.
+ * Variables are only validated once, no matter how often the chain reads them;
+ * during resolving they can not change.
+ * @param entry The result being recorded.
+ * @param read The read.
+ */
+static void AddResolverCacheRead(ResolverCacheEntry *entry, const ResolverCacheRead &read)
+{
+	entry->evaluated++;
+	for (const ResolverCacheRead &other : entry->reads) {
+		if (other.IsSameVariable(read)) return;
+	}
+	entry->reads.push_back(read);
+}
+
+/**
+ * Record a variable read while resolving, if the result is being recorded for the resolver cache.
+ * @param object Resolver object.
+ * @param scope Scope the variable was read from.
+ * @param relative Parameter of the relative scope.
+ * @param variable Variable that was read.
+ * @param parameter Parameter of the variable.
+ * @param value Value that was read.
+ * @param available Whether the variable was available.
+ */
+static inline void RecordResolverCacheRead(const ResolverObject &object, VarSpriteGroupScope scope, byte relative, byte variable, uint32 parameter, uint32 value, bool available)
+{
+	if (object.cache_entry == nullptr) return;
+
+	switch (variable) {
+		/* These only depend on the cache key, or on the resolving itself. */
+		case 0x0C: case 0x10: case 0x18: case 0x1A: case 0x1C: case 0x7D: case 0x7F:
+			return;
+
+		default:
+			AddResolverCacheRead(object.cache_entry, {scope, relative, false, variable, parameter, value, available});
+			return;
+	}
+}
+
+/**
+ * Check whether all variables a cached result depends on still have the same value.
+ * @param entry Cached result.
+ * @param object Resolver object.
+ * @return True if the cached result is still valid.
+ */
+static bool ValidateResolverCacheEntry(const ResolverCacheEntry &entry, ResolverObject &object)
+{
+	for (const ResolverCacheRead &read : entry.reads) {
+		ScopeResolver *scope = object.GetScope(read.scope, read.relative);
+		if (read.random_bits) {
+			if (scope->GetRandomBits() != read.value) return false;
+		} else {
+			bool available = true;
+			uint32 value = GetVariable(object, scope, read.variable, read.parameter, &available);
+			if (available != read.available || (available && value != read.value)) return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Resolve a top-level group, reusing the result of an earlier identical resolving during the same tick if possible.
+ * The result of resolving depends on the root group, the resolver object and the variables read;
+ * a cached result is reused when all variables it read still have the same value.
+ * Results with side effects on persistent storage or triggers, or that depend on the
+ * real sprite groups of the resolver object, are not cached. Neither are results of
+ * chains that read every variable only once, as validating those costs as much as resolving.
+ * As a cached result is exactly the result of resolving again, whether results are
+ * cached does not have to be the same for all clients.
+ * @param group Group to resolve.
+ * @param object Resolver object.
+ * @param[out] cached Set to whether the result came from the cache.
+ * @return The resolved group.
+ */
+/* static */ const SpriteGroup *SpriteGroup::ResolveTopLevel(const SpriteGroup *group, ResolverObject &object, bool *cached)
+{
+	*cached = false;
+
+	/* Resolving another chain in the middle of resolving clears the temporary storage. */
+	for (ResolverCacheEntry *recording : _resolver_cache_recordings) recording->cacheable = false;
+
+	if (!_settings_client.gui.newgrf_resolver_cache || object.callback == CBID_RANDOM_TRIGGER || object.cache_entry != nullptr) return group->Resolve(object);
+
+	uint64 id = object.GetScope(VSG_SCOPE_SELF)->GetCacheKey();
+	if (id == 0) return group->Resolve(object);
+
+	if (_resolver_cache_tick != _tick_counter || _resolver_cache.size() >= RESOLVER_CACHE_MAX_SIZE) {
+		_resolver_cache.clear();
+		_resolver_cache_tick = _tick_counter;
+	}
+
+	ResolverCacheKey key = { group, id, object.callback, object.callback_param1, object.callback_param2, object.last_value };
+	auto it = _resolver_cache.find(key);
+	if (it != _resolver_cache.end() && ValidateResolverCacheEntry(it->second, object)) {
+		const ResolverCacheEntry &entry = it->second;
+		for (const auto &store : entry.stores) _temp_store.StoreValue(store.first, store.second);
+		object.last_value = entry.last_value;
+		if (entry.result == &_calculated_result_group) _calculated_result_group.result = entry.calculated_result;
+		*cached = true;
+		return entry.result;
+	}
+
+	ResolverCacheEntry entry;
+	entry.evaluated = 0;
+	entry.cacheable = true;
+	object.cache_entry = &entry;
+	_resolver_cache_recordings.push_back(&entry);
+	const SpriteGroup *result = group->Resolve(object);
+	_resolver_cache_recordings.pop_back();
+	object.cache_entry = nullptr;
+
+	if (entry.cacheable && entry.reads.size() < entry.evaluated) {
+		entry.result = result;
+		entry.calculated_result = _calculated_result_group.result;
+		entry.last_value = object.last_value;
+		_resolver_cache[key] = std::move(entry);
+	}
+
+	return result;
+}
+
 /**
  * Get a few random bits. Default implementation has no random bits.
  * @return Random bits.
@@ -96,6 +307,16 @@ static inline uint32 GetVariable(const ResolverObject &object, ScopeResolver *sc
 	return 0;
 }
 
+/**
+ * Get an identifier of the object this scope resolves for, to look up earlier results of resolving.
+ * Default implementation does not allow caching of results.
+ * @return Identifier of the object, or \c 0 if results may not be cached.
+ */
+/* virtual */ uint64 ScopeResolver::GetCacheKey() const
+{
+	return 0;
+}
+
 /**
  * Get a variable value. Default implementation has no available variables.
  * @param variable Variable to read
@@ -141,10 +362,10 @@ static inline uint32 GetVariable(const ResolverObject &object, ScopeResolver *sc
 	return &this->default_scope;
 }
 
-/* Evaluate an adjustment for a variable of the given size.
+/* Shift, mask and optionally divide or take the modulo of a variable of the given size.
  * U is the unsigned type and S is the signed type to use. */
 template <typename U, typename S>
-static U EvalAdjustT(const DeterministicSpriteGroupAdjust &adjust, ScopeResolver *scope, U last_value, uint32 value)
+static inline uint32 AdjustVariableT(const DeterministicSpriteGroupAdjust &adjust, uint32 value)
 {
 	value >>= adjust.shift_num;
 	value  &= adjust.and_mask;
@@ -155,6 +376,14 @@ static U EvalAdjustT(const DeterministicSpriteGroupAdjust &adjust, ScopeResolver
 		case DSGA_TYPE_NONE: break;
 	}
 
+	return value;
+}
+
+/* Evaluate the operation of an adjustment with an already adjusted variable of the given size.
+ * U is the unsigned type and S is the signed type to use. */
+template <typename U, typename S>
+static inline U EvalAdjustT(const DeterministicSpriteGroupAdjust &adjust, ScopeResolver *scope, U last_value, uint32 value)
+{
 	switch (adjust.operation) {
 		case DSGA_OP_ADD:  return last_value + value;
 		case DSGA_OP_SUB:  return last_value - value;
@@ -183,6 +412,103 @@ static U EvalAdjustT(const DeterministicSpriteGroupAdjust &adjust, ScopeResolver
 	}
 }
 
+/* Evaluate all adjustments of a group of the given size.
+ * U is the unsigned type and S is the signed type to use.
+ * Returns false when a variable is not available. */
+template <typename U, typename S>
+static bool EvalAdjustsT(const std::vector<DeterministicSpriteGroupAdjust> &adjusts, ResolverObject &object, VarSpriteGroupScope var_scope, ScopeResolver *scope, uint32 &last_value, uint32 &value)
+{
+	for (const auto &adjust : adjusts) {
+		if (adjust.is_constant) {
+			value = adjust.constant_value;
+		} else {
+			/* Try to get the variable. We shall assume it is available, unless told otherwise. */
+			bool available = true;
+			if (adjust.variable == 0x7E) {
+				const SpriteGroup *subgroup = SpriteGroup::Resolve(adjust.subroutine, object, false);
+				if (subgroup == nullptr) {
+					value = CALLBACK_FAILED;
+				} else {
+					value = subgroup->GetCallbackResult();
+				}
+
+				/* Note: 'last_value' and 'reseed' are shared between the main chain and the procedure */
+			} else if (adjust.variable == 0x7B) {
+				value = GetVariable(object, scope, adjust.parameter, last_value, &available);
+				RecordResolverCacheRead(object, var_scope, 0, adjust.parameter, last_value, value, available);
+			} else {
+				value = GetVariable(object, scope, adjust.variable, adjust.parameter, &available);
+				RecordResolverCacheRead(object, var_scope, 0, adjust.variable, adjust.parameter, value, available);
+			}
+
+			if (!available) return false;
+
+			value = AdjustVariableT<U, S>(adjust, value);
+		}
+
+		if (object.cache_entry != nullptr) {
+			if (adjust.operation == DSGA_OP_STO) object.cache_entry->stores.emplace_back((U)value, (S)(U)last_value);
+			if (adjust.operation == DSGA_OP_STOP) object.cache_entry->cacheable = false;
+		}
+
+		value = EvalAdjustT<U, S>(adjust, scope, last_value, value);
+		last_value = value;
+	}
+
+	return true;
+}
+
+/* Precompute the constant adjustments of a group of the given size.
+ * U is the unsigned type and S is the signed type to use. */
+template <typename U, typename S>
+static void CompileAdjustsT(std::vector<DeterministicSpriteGroupAdjust> &adjusts)
+{
+	for (auto &adjust : adjusts) {
+		/* Variable 1A is always -1; the adjustment can only be precomputed without division by zero. */
+		adjust.is_constant = adjust.variable == 0x1A && (adjust.type == DSGA_TYPE_NONE || (S)adjust.divmod_val != 0);
+		if (adjust.is_constant) adjust.constant_value = AdjustVariableT<U, S>(adjust, UINT_MAX);
+	}
+
+	/* Fold a leading chain of constant adjustments without side effects into a single one. */
+	uint32 last_value = 0;
+	size_t folded = 0;
+	while (folded < adjusts.size() && adjusts[folded].is_constant && adjusts[folded].operation != DSGA_OP_STO && adjusts[folded].operation != DSGA_OP_STOP) {
+		last_value = EvalAdjustT<U, S>(adjusts[folded], nullptr, last_value, adjusts[folded].constant_value);
+		folded++;
+	}
+	if (folded < 2) return;
+
+	adjusts.erase(adjusts.begin() + 1, adjusts.begin() + folded);
+	adjusts[0].operation = DSGA_OP_RST;
+	adjusts[0].constant_value = last_value;
+}
+
+/**
+ * Prepare the group for fast resolving, after it has been completely read:
+ * precompute constant adjustments and build a lookup table for dense ranges.
+ */
+void DeterministicSpriteGroup::Compile()
+{
+	switch (this->size) {
+		case DSG_SIZE_BYTE:  CompileAdjustsT<uint8,  int8> (this->adjusts); break;
+		case DSG_SIZE_WORD:  CompileAdjustsT<uint16, int16>(this->adjusts); break;
+		case DSG_SIZE_DWORD: CompileAdjustsT<uint32, int32>(this->adjusts); break;
+		default: NOT_REACHED();
+	}
+
+	/* The ranges are sorted and do not overlap. Only use a table when it would replace a binary search and is not too sparse. */
+	this->range_table.clear();
+	if (this->ranges.size() <= 4) return;
+
+	uint32 span = this->ranges.back().high - this->ranges.front().low;
+	if (span >= std::min<size_t>(16 * this->ranges.size(), 256)) return;
+
+	this->range_table_base = this->ranges.front().low;
+	this->range_table.resize(span + 1, this->default_group);
+	for (const auto &range : this->ranges) {
+		std::fill(this->range_table.begin() + (range.low - this->range_table_base), this->range_table.begin() + (range.high - this->range_table_base + 1), range.group);
+	}
+}
 
 static bool RangeHighComparator(const DeterministicSpriteGroupRange& range, uint32 value)
 {
@@ -196,37 +522,18 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) con
 
 	ScopeResolver *scope = object.GetScope(this->var_scope);
 
-	for (const auto &adjust : this->adjusts) {
-		/* Try to get the variable. We shall assume it is available, unless told otherwise. */
-		bool available = true;
-		if (adjust.variable == 0x7E) {
-			const SpriteGroup *subgroup = SpriteGroup::Resolve(adjust.subroutine, object, false);
-			if (subgroup == nullptr) {
-				value = CALLBACK_FAILED;
-			} else {
-				value = subgroup->GetCallbackResult();
-			}
-
-			/* Note: 'last_value' and 'reseed' are shared between the main chain and the procedure */
-		} else if (adjust.variable == 0x7B) {
-			value = GetVariable(object, scope, adjust.parameter, last_value, &available);
-		} else {
-			value = GetVariable(object, scope, adjust.variable, adjust.parameter, &available);
-		}
-
-		if (!available) {
-			/* Unsupported variable: skip further processing and return either
-			 * the group from the first range or the default group. */
-			return SpriteGroup::Resolve(this->error_group, object, false);
-		}
+	bool available;
+	switch (this->size) {
+		case DSG_SIZE_BYTE:  available = EvalAdjustsT<uint8,  int8> (this->adjusts, object, this->var_scope, scope, last_value, value); break;
+		case DSG_SIZE_WORD:  available = EvalAdjustsT<uint16, int16>(this->adjusts, object, this->var_scope, scope, last_value, value); break;
+		case DSG_SIZE_DWORD: available = EvalAdjustsT<uint32, int32>(this->adjusts, object, this->var_scope, scope, last_value, value); break;
+		default: NOT_REACHED();
+	}
 
-		switch (this->size) {
-			case DSG_SIZE_BYTE:  value = EvalAdjustT<uint8,  int8> (adjust, scope, last_value, value); break;
-			case DSG_SIZE_WORD:  value = EvalAdjustT<uint16, int16>(adjust, scope, last_value, value); break;
-			case DSG_SIZE_DWORD: value = EvalAdjustT<uint32, int32>(adjust, scope, last_value, value); break;
-			default: NOT_REACHED();
-		}
-		last_value = value;
+	if (!available) {
+		/* Unsupported variable: skip further processing and return either
+		 * the group from the first range or the default group. */
+		return SpriteGroup::Resolve(this->error_group, object, false);
 	}
 
 	object.last_value = last_value;
@@ -234,9 +541,13 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) con
 	if (this->calculated_result) {
 		/* nvar == 0 is a special case -- we turn our value into a callback result */
 		if (value != CALLBACK_FAILED) value = GB(value, 0, 15);
-		static CallbackResultSpriteGroup nvarzero(0, true);
-		nvarzero.result = value;
-		return &nvarzero;
+		_calculated_result_group.result = value;
+		return &_calculated_result_group;
+	}
+
+	if (!this->range_table.empty()) {
+		uint32 index = value - this->range_table_base;
+		return SpriteGroup::Resolve(index < this->range_table.size() ? this->range_table[index] : this->default_group, object, false);
 	}
 
 	if (this->ranges.size() > 4) {
@@ -271,8 +582,11 @@ const SpriteGroup *RandomizedSpriteGroup::Resolve(ResolverObject &object) const
 		}
 	}
 
+	uint32 random_bits = scope->GetRandomBits();
+	if (object.cache_entry != nullptr) AddResolverCacheRead(object.cache_entry, {this->var_scope, this->count, true, 0, 0, random_bits, true});
+
 	uint32 mask = ((uint)this->groups.size() - 1) << this->lowest_randbit;
-	byte index = (scope->GetRandomBits() & mask) >> this->lowest_randbit;
+	byte index = (random_bits & mask) >> this->lowest_randbit;
 
 	return SpriteGroup::Resolve(this->groups[index], object, false);
 }
@@ -280,6 +594,8 @@ const SpriteGroup *RandomizedSpriteGroup::Resolve(ResolverObject &object) const
 
 const SpriteGroup *RealSpriteGroup::Resolve(ResolverObject &object) const
 {
+	/* The result depends on the state of the resolver object, which is not part of the cache key. */
+	if (object.cache_entry != nullptr) object.cache_entry->cacheable = false;
 	return object.ResolveReal(this);
 }
 
@@ -60,6 +60,8 @@ protected:
 	/** Base sprite group resolver */
 	virtual const SpriteGroup *Resolve(ResolverObject &object) const { return this; };
 
+	static const SpriteGroup *ResolveTopLevel(const SpriteGroup *group, ResolverObject &object, bool *cached);
+
 public:
 	virtual ~SpriteGroup() {}
 
@@ -154,6 +156,8 @@ struct DeterministicSpriteGroupAdjust {
 	uint32 add_val;
 	uint32 divmod_val;
 	const SpriteGroup *subroutine;
+	bool is_constant;       ///< The adjusted variable does not depend on the resolved object, see #constant_value.
+	uint32 constant_value;  ///< The value of the variable after shifting, masking and division or modulo, if #is_constant.
 };
 
 
@@ -178,6 +182,11 @@ struct DeterministicSpriteGroup : SpriteGroup {
 
 	const SpriteGroup *error_group; // was first range, before sorting ranges
 
+	std::vector<const SpriteGroup *> range_table; ///< Direct lookup table of the ranges, starting at #range_table_base; empty if not worth it.
+	uint32 range_table_base;                      ///< Value of the first entry of #range_table.
+
+	void Compile();
+
 protected:
 	const SpriteGroup *Resolve(ResolverObject &object) const;
 };
@@ -296,8 +305,12 @@ struct ScopeResolver {
 
 	virtual uint32 GetVariable(byte variable, uint32 parameter, bool *available) const;
 	virtual void StorePSA(uint reg, int32 value);
+	virtual uint64 GetCacheKey() const;
 };
 
+struct ResolverCacheEntry;
+void ClearResolverCache();
+
 /**
  * Interface for #SpriteGroup-s to access the gamestate.
  *
@@ -313,7 +326,7 @@ struct ResolverObject {
 	 * @param callback_param2 Second parameter (var 18) of the callback (only used when \a callback is also set).
 	 */
 	ResolverObject(const GRFFile *grffile, CallbackID callback = CBID_NO_CALLBACK, uint32 callback_param1 = 0, uint32 callback_param2 = 0)
-		: default_scope(*this), callback(callback), callback_param1(callback_param1), callback_param2(callback_param2), grffile(grffile), root_spritegroup(nullptr)
+		: default_scope(*this), callback(callback), callback_param1(callback_param1), callback_param2(callback_param2), grffile(grffile), root_spritegroup(nullptr), cache_entry(nullptr)
 	{
 		this->ResetState();
 	}
@@ -334,6 +347,7 @@ struct ResolverObject {
 
 	const GRFFile *grffile;     ///< GRFFile the resolved SpriteGroup belongs to
 	const SpriteGroup *root_spritegroup; ///< Root SpriteGroup to use for resolving
+	ResolverCacheEntry *cache_entry;     ///< Result being recorded for the resolver cache, if any.
 
 	/**
 	 * Resolve SpriteGroup.
@@ -41,6 +41,7 @@ struct StationScopeResolver : public ScopeResolver {
 	}
 
 	uint32 GetRandomBits() const override;
+	uint64 GetCacheKey() const override { return (uint64)this->tile + 1; }
 	uint32 GetTriggers() const override;
 
 	uint32 GetVariable(byte variable, uint32 parameter, bool *available) const override;
@@ -0,0 +1,289 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file water_regions.cpp Handles dividing the water in the map into square regions to assist pathfinding. */
+
+#include "../stdafx.h"
+#include "../map_func.h"
+#include "../tile_cmd.h"
+#include "../tunnelbridge_map.h"
+#include "../tile_journal.h"
+#include "../ship.h"
+#include "follow_track.hpp"
+#include "water_regions.h"
+
+#include "../safeguards.h"
+
+/** Bit mask of the positions along the edge of a water region; bit i is the i-th tile along the edge. */
+typedef uint16 WaterRegionEdge;
+static_assert(sizeof(WaterRegionEdge) * 8 == WATER_REGION_EDGE_LENGTH);
+
+/**
+ * The water tiles of a square of the map, divided into patches of tiles that
+ * ships can travel between without leaving the square. The data is determined
+ * when it is needed, and thrown away when the journal of changed tiles says
+ * the type of a tile of the square changed. Building or removing anything ships
+ * can pass or not changes the type of the tile.
+ */
+struct WaterRegion {
+	bool initialized = false;                       ///< Whether the data below is up to date.
+	bool has_cross_region_aqueducts = false;        ///< Whether an aqueduct leads from this region to another region.
+	WaterRegionPatchLabel number_of_patches = 0;    ///< Number of patches within this region.
+	WaterRegionEdge edges[DIAGDIR_END] = {};        ///< Per edge, the tiles from which ships can move into the neighbouring region.
+	WaterRegionPatchLabel labels[WATER_REGION_NUMBER_OF_TILES] = {}; ///< The patch of every tile, or #INVALID_WATER_REGION_PATCH.
+};
+
+static std::vector<WaterRegion> _water_regions; ///< The water regions of the map, by region index.
+static TileJournalReader _water_region_journal;  ///< Reader of the changes of the types of tiles, to throw away the data of their regions.
+
+/** Number of water regions along the X axis. */
+static inline uint GetWaterRegionMapSizeX() { return MapSizeX() / WATER_REGION_EDGE_LENGTH; }
+/** Number of water regions along the Y axis. */
+static inline uint GetWaterRegionMapSizeY() { return MapSizeY() / WATER_REGION_EDGE_LENGTH; }
+
+/**
+ * Get the index of the water region with the given region coordinates.
+ * @param x The X coordinate of the region.
+ * @param y The Y coordinate of the region.
+ * @return The region index.
+ */
+static inline uint GetWaterRegionIndex(uint x, uint y)
+{
+	return y * GetWaterRegionMapSizeX() + x;
+}
+
+/**
+ * Get the index of the tile within its water region.
+ * @param tile The tile.
+ * @return The index within the region.
+ */
+static inline uint GetLocalIndex(TileIndex tile)
+{
+	return (TileY(tile) % WATER_REGION_EDGE_LENGTH) * WATER_REGION_EDGE_LENGTH + (TileX(tile) % WATER_REGION_EDGE_LENGTH);
+}
+
+/**
+ * Get the trackdirs ships can use on a tile.
+ * @param tile The tile.
+ * @return The trackdirs.
+ */
+static inline TrackdirBits GetWaterTrackdirs(TileIndex tile)
+{
+	return TrackStatusToTrackdirBits(GetTileTrackStatus(tile, TRANSPORT_WATER, 0));
+}
+
+/**
+ * Determine the patches and edges of a water region.
+ * @param region The region to fill.
+ * @param rx The X coordinate of the region.
+ * @param ry The Y coordinate of the region.
+ */
+static void InitializeWaterRegion(WaterRegion &region, uint rx, uint ry)
+{
+	region.has_cross_region_aqueducts = false;
+	region.number_of_patches = 0;
+	std::fill(std::begin(region.edges), std::end(region.edges), 0);
+	std::fill(std::begin(region.labels), std::end(region.labels), INVALID_WATER_REGION_PATCH);
+
+	uint min_x = rx * WATER_REGION_EDGE_LENGTH;
+	uint min_y = ry * WATER_REGION_EDGE_LENGTH;
+	auto contains = [min_x, min_y](TileIndex tile) {
+		return IsInsideBS(TileX(tile), min_x, WATER_REGION_EDGE_LENGTH) && IsInsideBS(TileY(tile), min_y, WATER_REGION_EDGE_LENGTH);
+	};
+
+	/* Flood fill every patch of tiles that can be travelled between within the region. */
+	std::vector<TileIndex> todo;
+	for (uint y = 0; y < WATER_REGION_EDGE_LENGTH; y++) {
+		for (uint x = 0; x < WATER_REGION_EDGE_LENGTH; x++) {
+			TileIndex start = TileXY(min_x + x, min_y + y);
+			if (region.labels[GetLocalIndex(start)] != INVALID_WATER_REGION_PATCH) continue;
+			if (GetWaterTrackdirs(start) == TRACKDIR_BIT_NONE) continue;
+
+			assert(region.number_of_patches < UINT8_MAX);
+			WaterRegionPatchLabel label = ++region.number_of_patches;
+			region.labels[GetLocalIndex(start)] = label;
+			todo.push_back(start);
+
+			while (!todo.empty()) {
+				TileIndex tile = todo.back();
+				todo.pop_back();
+
+				for (TrackdirBits tds = GetWaterTrackdirs(tile); tds != TRACKDIR_BIT_NONE; tds = KillFirstBit(tds)) {
+					Trackdir td = (Trackdir)FindFirstBit2x64(tds);
+					CFollowTrackWater ft;
+					if (!ft.Follow(tile, td)) continue;
+
+					if (!contains(ft.m_new_tile)) {
+						if (ft.m_tiles_skipped == 0) {
+							/* The tile is at the edge, and ships can go from it to the neighbouring region. */
+							DiagDirection side = TrackdirToExitdir(td);
+							uint pos = DiagDirToAxis(side) == AXIS_X ? TileY(tile) - min_y : TileX(tile) - min_x;
+							SetBit(region.edges[side], pos);
+						} else {
+							region.has_cross_region_aqueducts = true;
+						}
+						continue;
+					}
+
+					uint index = GetLocalIndex(ft.m_new_tile);
+					if (region.labels[index] != INVALID_WATER_REGION_PATCH) continue;
+					region.labels[index] = label;
+					todo.push_back(ft.m_new_tile);
+				}
+			}
+		}
+	}
+
+	region.initialized = true;
+}
+
+/**
+ * Throw away the data of the water regions of a changed block of tiles of the journal.
+ * The neighbouring regions are thrown away as well, as they know which tiles at
+ * their edge lead to the region of the block.
+ * @param tile The northern tile of the block.
+ */
+static void InvalidateWaterRegions(TileIndex tile)
+{
+	static_assert(TILE_JOURNAL_BLOCK_SIZE == WATER_REGION_EDGE_LENGTH);
+
+	uint x = TileX(tile) / WATER_REGION_EDGE_LENGTH;
+	uint y = TileY(tile) / WATER_REGION_EDGE_LENGTH;
+	_water_regions[GetWaterRegionIndex(x, y)].initialized = false;
+	if (x > 0) _water_regions[GetWaterRegionIndex(x - 1, y)].initialized = false;
+	if (y > 0) _water_regions[GetWaterRegionIndex(x, y - 1)].initialized = false;
+	if (x < GetWaterRegionMapSizeX() - 1) _water_regions[GetWaterRegionIndex(x + 1, y)].initialized = false;
+	if (y < GetWaterRegionMapSizeY() - 1) _water_regions[GetWaterRegionIndex(x, y + 1)].initialized = false;
+}
+
+/**
+ * Throw away the data of the water regions with tiles that changed since the previous time.
+ */
+static void ReadWaterRegionChanges()
+{
+	if (!_water_region_journal.ReadChanges(InvalidateWaterRegions)) {
+		for (WaterRegion &region : _water_regions) region.initialized = false;
+	}
+}
+
+/**
+ * Get the water region with the given coordinates, determining its data when needed.
+ * @param x The X coordinate of the region.
+ * @param y The Y coordinate of the region.
+ * @return The region.
+ */
+static const WaterRegion &GetUpdatedWaterRegion(uint x, uint y)
+{
+	if (_water_region_journal.HasChanges()) ReadWaterRegionChanges();
+
+	WaterRegion &region = _water_regions[GetWaterRegionIndex(x, y)];
+	if (!region.initialized) InitializeWaterRegion(region, x, y);
+	return region;
+}
+
+/**
+ * Get a hash of a water region patch, unique for every patch of the map.
+ * @param patch The patch.
+ * @return The hash.
+ */
+uint32 CalculateWaterRegionPatchHash(const WaterRegionPatchDesc &patch)
+{
+	return patch.label | GetWaterRegionIndex(patch.x, patch.y) << 8;
+}
+
+/**
+ * Get the tile at the center of the water region of a patch.
+ * @param patch The patch.
+ * @return The center tile.
+ */
+TileIndex GetWaterRegionCenterTile(const WaterRegionPatchDesc &patch)
+{
+	return TileXY(patch.x * WATER_REGION_EDGE_LENGTH + WATER_REGION_EDGE_LENGTH / 2, patch.y * WATER_REGION_EDGE_LENGTH + WATER_REGION_EDGE_LENGTH / 2);
+}
+
+/**
+ * Get the water region patch a tile belongs to.
+ * @param tile The tile.
+ * @return The patch; its label is #INVALID_WATER_REGION_PATCH when ships can not use the tile.
+ */
+WaterRegionPatchDesc GetWaterRegionPatchInfo(TileIndex tile)
+{
+	uint x = TileX(tile) / WATER_REGION_EDGE_LENGTH;
+	uint y = TileY(tile) / WATER_REGION_EDGE_LENGTH;
+	return { x, y, GetUpdatedWaterRegion(x, y).labels[GetLocalIndex(tile)] };
+}
+
+/**
+ * Call a function for every water region patch ships can reach directly from the given patch.
+ * A neighbouring patch may be visited more than once.
+ * @param patch The patch to get the neighbours of.
+ * @param proc The function to call for every neighbour.
+ * @param data Data to pass to the function.
+ */
+void VisitWaterRegionPatchNeighbours(const WaterRegionPatchDesc &patch, VisitWaterRegionPatchProc *proc, void *data)
+{
+	const WaterRegion &region = GetUpdatedWaterRegion(patch.x, patch.y);
+	uint min_x = patch.x * WATER_REGION_EDGE_LENGTH;
+	uint min_y = patch.y * WATER_REGION_EDGE_LENGTH;
+
+	static const int region_offset_x[DIAGDIR_END] = {-1, 0, 1, 0};
+	static const int region_offset_y[DIAGDIR_END] = {0, 1, 0, -1};
+
+	for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) {
+		if (region.edges[side] == 0) continue;
+
+		int nx = (int)patch.x + region_offset_x[side];
+		int ny = (int)patch.y + region_offset_y[side];
+		if (nx < 0 || ny < 0 || nx >= (int)GetWaterRegionMapSizeX() || ny >= (int)GetWaterRegionMapSizeY()) continue;
+
+		/* Ships can cross where both regions have tiles that lead to the other region. */
+		const WaterRegion &neighbour = GetUpdatedWaterRegion(nx, ny);
+		WaterRegionEdge crossings = region.edges[side] & neighbour.edges[ReverseDiagDir(side)];
+
+		WaterRegionPatchLabel last_label = INVALID_WATER_REGION_PATCH;
+		for (uint pos = 0; pos < WATER_REGION_EDGE_LENGTH; pos++) {
+			if (!HasBit(crossings, pos)) continue;
+
+			TileIndex tile;
+			if (DiagDirToAxis(side) == AXIS_X) {
+				tile = TileXY(side == DIAGDIR_NE ? min_x : min_x + WATER_REGION_EDGE_LENGTH - 1, min_y + pos);
+			} else {
+				tile = TileXY(min_x + pos, side == DIAGDIR_NW ? min_y : min_y + WATER_REGION_EDGE_LENGTH - 1);
+			}
+			if (region.labels[GetLocalIndex(tile)] != patch.label) continue;
+
+			WaterRegionPatchLabel label = neighbour.labels[GetLocalIndex(TileAddByDiagDir(tile, side))];
+			if (label == last_label) continue;
+			last_label = label;
+			proc({ (uint)nx, (uint)ny, label }, data);
+		}
+	}
+
+	if (!region.has_cross_region_aqueducts) return;
+
+	for (uint y = 0; y < WATER_REGION_EDGE_LENGTH; y++) {
+		for (uint x = 0; x < WATER_REGION_EDGE_LENGTH; x++) {
+			TileIndex tile = TileXY(min_x + x, min_y + y);
+			if (region.labels[GetLocalIndex(tile)] != patch.label) continue;
+			if (!IsBridgeTile(tile) || GetTunnelBridgeTransportType(tile) != TRANSPORT_WATER) continue;
+
+			WaterRegionPatchDesc other = GetWaterRegionPatchInfo(GetOtherBridgeEnd(tile));
+			if (other.x != patch.x || other.y != patch.y) proc(other, data);
+		}
+	}
+}
+
+/**
+ * Allocate the water regions for the current map size; their data is determined when it is needed.
+ */
+void AllocateWaterRegions()
+{
+	_water_regions.clear();
+	_water_regions.resize(GetWaterRegionMapSizeX() * GetWaterRegionMapSizeY());
+	/* Only reading the changes of types keeps the other changes from being recorded when nothing else reads them. */
+	_water_region_journal.Start(true);
+}
@@ -0,0 +1,43 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file water_regions.h Handles dividing the water in the map into regions to assist pathfinding. */
+
+#ifndef WATER_REGIONS_H
+#define WATER_REGIONS_H
+
+#include "../tile_type.h"
+
+typedef uint8 WaterRegionPatchLabel; ///< Label of a patch of connected water tiles within a water region.
+
+static const uint WATER_REGION_EDGE_LENGTH = 16; ///< Number of tiles along the edge of a water region.
+static const uint WATER_REGION_NUMBER_OF_TILES = WATER_REGION_EDGE_LENGTH * WATER_REGION_EDGE_LENGTH; ///< Number of tiles in a water region.
+static const WaterRegionPatchLabel INVALID_WATER_REGION_PATCH = 0; ///< Label of tiles that ships can not use.
+
+/**
+ * Describes a single interconnected patch of water within a particular water region.
+ */
+struct WaterRegionPatchDesc {
+	uint x;                      ///< The X coordinate of the water region, i.e. X=2 is the 3rd water region along the X-axis.
+	uint y;                      ///< The Y coordinate of the water region, i.e. Y=2 is the 3rd water region along the Y-axis.
+	WaterRegionPatchLabel label; ///< Unique label identifying the patch within the region.
+
+	bool operator==(const WaterRegionPatchDesc &other) const { return x == other.x && y == other.y && label == other.label; }
+	bool operator!=(const WaterRegionPatchDesc &other) const { return !(*this == other); }
+};
+
+/** Callback for VisitWaterRegionPatchNeighbours; called with every neighbouring patch. */
+typedef void (VisitWaterRegionPatchProc)(const WaterRegionPatchDesc &patch, void *data);
+
+uint32 CalculateWaterRegionPatchHash(const WaterRegionPatchDesc &patch);
+TileIndex GetWaterRegionCenterTile(const WaterRegionPatchDesc &patch);
+WaterRegionPatchDesc GetWaterRegionPatchInfo(TileIndex tile);
+void VisitWaterRegionPatchNeighbours(const WaterRegionPatchDesc &patch, VisitWaterRegionPatchProc *proc, void *data);
+
+void AllocateWaterRegions();
+
+#endif /* WATER_REGIONS_H */
@@ -12,7 +12,7 @@
 
 #include "../../misc/array.hpp"
 #include "../../misc/hashtable.hpp"
-#include "../../misc/binaryheap.hpp"
+#include "../../misc/dary_heap.hpp"
 
 /**
  * Hash table based node list multi-container class.
@@ -25,9 +25,9 @@ public:
 	typedef Titem_ Titem;                                        ///< Make #Titem_ visible from outside of class.
 	typedef typename Titem_::Key Key;                            ///< Make Titem_::Key a property of this class.
 	typedef SmallArray<Titem_, 65536, 256> CItemArray;           ///< Type that we will use as item container.
-	typedef CHashTableT<Titem_, Thash_bits_open_  > COpenList;   ///< How pointers to open nodes will be stored.
-	typedef CHashTableT<Titem_, Thash_bits_closed_> CClosedList; ///< How pointers to closed nodes will be stored.
-	typedef CBinaryHeapT<Titem_> CPriorityQueue;                 ///< How the priority queue will be managed.
+	typedef COpenHashTableT<Titem_, Thash_bits_open_  > COpenList;   ///< How pointers to open nodes will be stored.
+	typedef COpenHashTableT<Titem_, Thash_bits_closed_> CClosedList; ///< How pointers to closed nodes will be stored.
+	typedef CDaryHeapT<Titem_> CPriorityQueue;                       ///< How the priority queue will be managed.
 
 protected:
 	CItemArray      m_arr;        ///< Here we store full item data (Titem_).
@@ -119,11 +119,20 @@ public:
 	inline Titem_& PopOpenNode(const Key &key)
 	{
 		Titem_ &item = m_open.Pop(key);
-		uint idxPop = m_open_queue.FindIndex(item);
-		m_open_queue.Remove(idxPop);
+		m_open_queue.Remove(item);
 		return item;
 	}
 
+	/** replace the data of an open node by the data of a better node with the same key */
+	inline void UpdateOpenNode(Titem_ &item, const Titem_ &new_item)
+	{
+		assert(item.GetKey() == new_item.GetKey() && new_item < item);
+		uint heap_index = item.GetHeapIndex();
+		item = new_item;
+		item.SetHeapIndex(heap_index);
+		m_open_queue.DecreaseKey(item);
+	}
+
 	/** close node */
 	inline void InsertClosedNode(Titem_ &item)
 	{
@@ -99,4 +99,13 @@ bool YapfTrainCheckReverse(const Train *v);
  */
 bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, bool override_railtype);
 
+/**
+ * Run the pathfinders for the vehicles of the current game, and print to the
+ * console how fast they are.
+ * @param rounds The number of times to run the pathfinder for each vehicle.
+ */
+void YapfBenchmark(uint rounds);
+
+extern uint64 _yapf_nodes_visited;
+
 #endif /* YAPF_H */
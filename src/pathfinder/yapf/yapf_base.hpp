@@ -114,6 +114,7 @@ public:
 
 		Yapf().PfSetStartupNodes();
 		bool bDestFound = true;
+		uint64 nodes_visited = 0;
 
 		for (;;) {
 			m_num_steps++;
@@ -121,6 +122,7 @@ public:
 			if (n == nullptr) {
 				break;
 			}
+			nodes_visited++;
 
 			/* if the best open node was worse than the best path found, we can finish */
 			if (m_pBestDestNode != nullptr && m_pBestDestNode->GetCost() < n->GetCostEstimate()) {
@@ -138,6 +140,7 @@ public:
 		}
 
 		bDestFound &= (m_pBestDestNode != nullptr);
+		_yapf_nodes_visited += nodes_visited;
 
 		if (_debug_yapf_level >= 3) {
 			UnitID veh_idx = (m_veh != nullptr) ? m_veh->unitnumber : 0;
@@ -263,10 +266,7 @@ public:
 			 * is it better than new one? */
 			if (n.GetCostEstimate() < openNode->GetCostEstimate()) {
 				/* update the old node by value from new one */
-				m_nodes.PopOpenNode(n.GetKey());
-				*openNode = n;
-				/* add the updated old node back to open list */
-				m_nodes.InsertOpenNode(*openNode);
+				m_nodes.UpdateOpenNode(*openNode, n);
 				if (set_intermediate) m_pBestIntermediateNode = openNode;
 			}
 			return;
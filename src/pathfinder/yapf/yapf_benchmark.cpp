@@ -0,0 +1,65 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_benchmark.cpp Benchmark of the YAPF pathfinders with the vehicles of the current game. */
+
+#include "../../stdafx.h"
+#include "../../train.h"
+#include "../../roadveh.h"
+#include "../../ship.h"
+#include "../../console_func.h"
+#include "yapf.h"
+#include <chrono>
+
+#include "../../safeguards.h"
+
+uint64 _yapf_nodes_visited = 0; ///< Number of nodes visited by all YAPF searches so far.
+
+/**
+ * Run a pathfinder query for every primary vehicle of a type that is out on the map,
+ * and print how fast the pathfinder visited nodes.
+ * @tparam T The type of the vehicles.
+ * @param name The name of the query.
+ * @param rounds The number of times to run the query for each vehicle.
+ * @param query The query to run for a vehicle.
+ */
+template <class T, typename Tquery>
+static void BenchmarkQuery(const char *name, uint rounds, Tquery query)
+{
+	uint queries = 0;
+	uint64 nodes = _yapf_nodes_visited;
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint round = 0; round < rounds; round++) {
+		for (const T *v : T::Iterate()) {
+			if (!v->IsPrimaryVehicle() || v->IsInDepot() || (v->vehstatus & VS_CRASHED) != 0) continue;
+			if (query(v)) queries++;
+		}
+	}
+
+	uint64 us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	nodes = _yapf_nodes_visited - nodes;
+	IConsolePrint(CC_INFO, "{}: {} queries, {} nodes in {} ms, {} nodes/s", name, queries, nodes, us / 1000, us == 0 ? 0 : nodes * 1000000 / us);
+}
+
+void YapfBenchmark(uint rounds)
+{
+	BenchmarkQuery<Train>("Rail, nearest depot", rounds, [](const Train *v) {
+		YapfTrainFindNearestDepot(v, 0);
+		return true;
+	});
+	BenchmarkQuery<RoadVehicle>("Road, nearest depot", rounds, [](const RoadVehicle *v) {
+		YapfRoadVehicleFindNearestDepot(v, 0);
+		return true;
+	});
+	/* Checking whether to reverse searches the route to the destination in both directions. */
+	BenchmarkQuery<Ship>("Water, reverse check", rounds, [](const Ship *v) {
+		if (!IsValidTile(v->dest_tile)) return false;
+		YapfShipCheckReverse(v, nullptr);
+		return true;
+	});
+}
@@ -19,4 +19,10 @@
  */
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track);
 
+/**
+ * Use this function to notify YAPF that the road layout has changed, so the
+ * decisions of road vehicles it remembers are no longer valid.
+ */
+void YapfNotifyRoadLayoutChange();
+
 #endif /* YAPF_CACHE_H */
@@ -61,7 +61,7 @@ struct CYapfNodeT {
 	typedef Tnode Node;
 
 	Tkey_       m_key;
-	Node       *m_hash_next;
+	uint        m_heap_index;
 	Node       *m_parent;
 	int         m_cost;
 	int         m_estimate;
@@ -70,21 +70,21 @@ struct CYapfNodeT {
 	inline void Set(Node *parent, TileIndex tile, Trackdir td, bool is_choice)
 	{
 		m_key.Set(tile, td);
-		m_hash_next = nullptr;
+		m_heap_index = 0;
 		m_parent = parent;
 		m_cost = 0;
 		m_estimate = 0;
 		m_is_choice = is_choice;
 	}
 
-	inline Node *GetHashNext()
+	inline uint GetHeapIndex() const
 	{
-		return m_hash_next;
+		return m_heap_index;
 	}
 
-	inline void SetHashNext(Node *pNext)
+	inline void SetHeapIndex(uint index)
 	{
-		m_hash_next = pNext;
+		m_heap_index = index;
 	}
 
 	inline TileIndex GetTile() const
@@ -11,9 +11,66 @@
 #include "yapf.hpp"
 #include "yapf_node_road.hpp"
 #include "../../roadstop_base.h"
+#include "../../date_func.h"
+#include "../../network/network.h"
+
+#include <map>
 
 #include "../../safeguards.h"
 
+/** Number of ticks a decision in the road vehicle route cache stays valid; after that, the decision is reconsidered. */
+static const uint64 ROADVEH_ROUTE_CACHE_LIFETIME = 4 * DAY_TICKS;
+/** Number of decisions the road vehicle route cache holds at most; it is emptied when it gets full. */
+static const size_t ROADVEH_ROUTE_CACHE_MAX_SIZE = 1 << 16;
+
+/**
+ * Key of a decision in the road vehicle route cache: what road vehicles
+ * going to the same destination decide at a junction.
+ */
+struct RoadVehRouteCacheKey {
+	TileIndex tile;          ///< The junction.
+	DiagDirection enterdir;  ///< Direction in which the vehicle enters the junction.
+	TileIndex dest_tile;     ///< The destination tile, or #INVALID_TILE when going to a road stop.
+	StationID dest_station;  ///< The station of the destination road stop, or #INVALID_STATION.
+	RoadType roadtype;       ///< Road type of the vehicle.
+	bool bus;                ///< Whether the vehicle is a bus.
+	bool non_artic;          ///< Whether the vehicle has no articulated parts.
+	int max_speed;           ///< The speed the costs of the route were calculated for.
+
+	bool operator<(const RoadVehRouteCacheKey &other) const
+	{
+		return std::tie(this->tile, this->enterdir, this->dest_tile, this->dest_station, this->roadtype, this->bus, this->non_artic, this->max_speed) <
+				std::tie(other.tile, other.enterdir, other.dest_tile, other.dest_station, other.roadtype, other.bus, other.non_artic, other.max_speed);
+	}
+};
+
+/** A decision in the road vehicle route cache. */
+struct RoadVehRouteCacheEntry {
+	Trackdir td;      ///< The trackdir to take at the junction.
+	uint64 expires;   ///< The tick at which the decision has to be reconsidered.
+};
+
+static std::map<RoadVehRouteCacheKey, RoadVehRouteCacheEntry> _roadveh_route_cache; ///< Decisions of road vehicles at junctions, by destination.
+static bool _roadveh_route_cache_dirty = false; ///< Whether the road layout changed since the decisions were made.
+
+/**
+ * Get the road route cache; emptied first when the road layout changed since it was filled.
+ * @return The road vehicle route cache.
+ */
+static std::map<RoadVehRouteCacheKey, RoadVehRouteCacheEntry> &GetRoadVehRouteCache()
+{
+	if (_roadveh_route_cache_dirty || _roadveh_route_cache.size() >= ROADVEH_ROUTE_CACHE_MAX_SIZE) {
+		_roadveh_route_cache.clear();
+		_roadveh_route_cache_dirty = false;
+	}
+	return _roadveh_route_cache;
+}
+
+void YapfNotifyRoadLayoutChange()
+{
+	_roadveh_route_cache_dirty = true;
+}
+
 
 template <class Types>
 class CYapfCostRoadT
@@ -256,6 +313,27 @@ public:
 		return m_dest_station != INVALID_STATION ? Station::GetIfValid(m_dest_station) : nullptr;
 	}
 
+	/**
+	 * Get the key of a decision in the route cache for the destination.
+	 * @param v The vehicle.
+	 * @param tile The junction.
+	 * @param enterdir Direction in which the vehicle enters the junction.
+	 * @return The key.
+	 */
+	RoadVehRouteCacheKey GetRouteCacheKey(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir) const
+	{
+		RoadVehRouteCacheKey key;
+		key.tile = tile;
+		key.enterdir = enterdir;
+		key.dest_tile = m_dest_station != INVALID_STATION ? INVALID_TILE : m_destTile;
+		key.dest_station = m_dest_station;
+		key.roadtype = v->roadtype;
+		key.bus = m_bus;
+		key.non_artic = m_non_artic;
+		key.max_speed = std::min<int>(v->GetDisplayMaxSpeed(), v->current_order.GetMaxSpeed() * 2);
+		return key;
+	}
+
 protected:
 	/** to access inherited path finder */
 	Tpf& Yapf()
@@ -378,6 +456,29 @@ public:
 		Yapf().SetOrigin(src_tile, src_trackdirs);
 		Yapf().SetDestination(v);
 
+		/* Road vehicles close to a station with several road stops are spread over the stops, so they
+		 * must decide for themselves. The shared decisions are not part of the game state, so they can
+		 * only be used when there is no other game to stay in sync with. */
+		TileArea non_cached_area;
+		const Station *st = Yapf().GetDestinationStation();
+		if (st != nullptr) {
+			const RoadStop *stop = st->GetPrimaryRoadStop(v);
+			if (stop != nullptr && (IsDriveThroughStopTile(stop->xy) || stop->GetNextRoadStop(v) != nullptr)) {
+				non_cached_area = v->IsBus() ? st->bus_station : st->truck_station;
+				non_cached_area.Expand(YAPF_ROADVEH_PATH_CACHE_DESTINATION_LIMIT);
+			}
+		}
+		bool use_route_cache = !_networking && !non_cached_area.Contains(tile);
+
+		if (use_route_cache) {
+			auto &route_cache = GetRoadVehRouteCache();
+			auto it = route_cache.find(Yapf().GetRouteCacheKey(v, tile, enterdir));
+			if (it != route_cache.end() && it->second.expires > _tick_counter && HasTrackdir(src_trackdirs, it->second.td)) {
+				path_found = true;
+				return it->second.td;
+			}
+		}
+
 		/* find the best path */
 		path_found = Yapf().FindPath(v);
 
@@ -388,13 +489,23 @@ public:
 			uint steps = 0;
 			for (Node *n = pNode; n->m_parent != nullptr; n = n->m_parent) steps++;
 
+			/* Remember the decisions along a found path for other vehicles going to the same destination. */
+			auto &route_cache = GetRoadVehRouteCache();
+			auto remember = [&](TileIndex junction, DiagDirection junction_enterdir, Trackdir td) {
+				if (!use_route_cache || non_cached_area.Contains(junction)) return;
+				route_cache[Yapf().GetRouteCacheKey(v, junction, junction_enterdir)] = { td, _tick_counter + ROADVEH_ROUTE_CACHE_LIFETIME };
+			};
+
 			/* path was found or at least suggested
 			 * walk through the path back to its origin */
 			while (pNode->m_parent != nullptr) {
 				steps--;
-				if (pNode->GetIsChoice() && steps < YAPF_ROADVEH_PATH_CACHE_SEGMENTS) {
-					path_cache.td.push_front(pNode->GetTrackdir());
-					path_cache.tile.push_front(pNode->GetTile());
+				if (pNode->GetIsChoice()) {
+					if (steps < YAPF_ROADVEH_PATH_CACHE_SEGMENTS) {
+						path_cache.td.push_front(pNode->GetTrackdir());
+						path_cache.tile.push_front(pNode->GetTile());
+					}
+					if (path_found) remember(pNode->GetTile(), ReverseDiagDir(TrackdirToExitdir(ReverseTrackdir(pNode->GetTrackdir()))), pNode->GetTrackdir());
 				}
 				pNode = pNode->m_parent;
 			}
@@ -402,26 +513,18 @@ public:
 			Node &best_next_node = *pNode;
 			assert(best_next_node.GetTile() == tile);
 			next_trackdir = best_next_node.GetTrackdir();
+			if (path_found) remember(tile, enterdir, next_trackdir);
 			/* remove last element for the special case when tile == dest_tile */
 			if (path_found && !path_cache.empty() && tile == v->dest_tile) {
 				path_cache.td.pop_back();
 				path_cache.tile.pop_back();
 			}
 
-			/* Check if target is a station, and cached path ends within 8 tiles of the dest tile */
-			const Station *st = Yapf().GetDestinationStation();
-			if (st) {
-				const RoadStop *stop = st->GetPrimaryRoadStop(v);
-				if (stop != nullptr && (IsDriveThroughStopTile(stop->xy) || stop->GetNextRoadStop(v) != nullptr)) {
-					/* Destination station has at least 2 usable road stops, or first is a drive-through stop,
-					 * trim end of path cache within a number of tiles of road stop tile area */
-					TileArea non_cached_area = v->IsBus() ? st->bus_station : st->truck_station;
-					non_cached_area.Expand(YAPF_ROADVEH_PATH_CACHE_DESTINATION_LIMIT);
-					while (!path_cache.empty() && non_cached_area.Contains(path_cache.tile.back())) {
-						path_cache.td.pop_back();
-						path_cache.tile.pop_back();
-					}
-				}
+			/* Destination station has at least 2 usable road stops, or first is a drive-through stop,
+			 * trim end of path cache within a number of tiles of road stop tile area */
+			while (!path_cache.empty() && non_cached_area.Contains(path_cache.tile.back())) {
+				path_cache.td.pop_back();
+				path_cache.tile.pop_back();
 			}
 		}
 		return next_trackdir;
@@ -11,9 +11,11 @@
 #include "../../ship.h"
 #include "../../industry.h"
 #include "../../vehicle_func.h"
+#include "../../station_base.h"
 
 #include "yapf.hpp"
 #include "yapf_node_ship.hpp"
+#include "yapf_ship_regions.h"
 
 #include "../../safeguards.h"
 
@@ -31,7 +33,12 @@ protected:
 	TrackdirBits m_destTrackdirs;
 	StationID    m_destStation;
 
+	std::vector<WaterRegionPatchDesc> m_corridor; ///< The water region patches the search may enter; empty when it may go anywhere.
+	bool         m_corridorEndsAtDestination;     ///< Whether the corridor leads to the destination; otherwise its last patch is the destination.
+
 public:
+	CYapfDestinationTileWaterT() : m_corridorEndsAtDestination(true) {}
+
 	void SetDestination(const Ship *v)
 	{
 		if (v->current_order.IsType(OT_GOTO_STATION)) {
@@ -45,6 +52,58 @@ public:
 		}
 	}
 
+	/**
+	 * Get the water region patches of the destination.
+	 * @return The patches; empty when the destination is not on water.
+	 */
+	std::vector<WaterRegionPatchDesc> GetDestinationPatches() const
+	{
+		std::vector<WaterRegionPatchDesc> patches;
+		if (m_destStation != INVALID_STATION) {
+			const Station *st = Station::Get(m_destStation);
+			for (TileIndex tile : st->docking_station) {
+				if (!IsDockingTile(tile) || !IsShipDestinationTile(tile, m_destStation)) continue;
+				WaterRegionPatchDesc patch = GetWaterRegionPatchInfo(tile);
+				if (patch.label == INVALID_WATER_REGION_PATCH) continue;
+				if (std::find(patches.begin(), patches.end(), patch) == patches.end()) patches.push_back(patch);
+			}
+		} else {
+			WaterRegionPatchDesc patch = GetWaterRegionPatchInfo(m_destTile);
+			if (patch.label != INVALID_WATER_REGION_PATCH) patches.push_back(patch);
+		}
+		return patches;
+	}
+
+	/**
+	 * Limit the search to the given water region patches.
+	 * @param corridor The patches the search may enter.
+	 * @param ends_at_destination Whether the destination is within the corridor; otherwise reaching its last patch ends the search.
+	 */
+	void SetCorridor(std::vector<WaterRegionPatchDesc> &&corridor, bool ends_at_destination)
+	{
+		m_corridor = std::move(corridor);
+		m_corridorEndsAtDestination = ends_at_destination;
+	}
+
+	/** Whether the search is limited to a corridor of water region patches. */
+	inline bool HasCorridor() const
+	{
+		return !m_corridor.empty();
+	}
+
+	/** Whether the search ends before the destination, at the end of the corridor. */
+	inline bool HasIntermediateDestination() const
+	{
+		return !m_corridorEndsAtDestination;
+	}
+
+	/** Whether the search may enter the given tile. */
+	inline bool IsTileInCorridor(TileIndex tile) const
+	{
+		if (m_corridor.empty()) return true;
+		return std::find(m_corridor.begin(), m_corridor.end(), GetWaterRegionPatchInfo(tile)) != m_corridor.end();
+	}
+
 protected:
 	/** to access inherited path finder */
 	inline Tpf& Yapf()
@@ -61,6 +120,8 @@ public:
 
 	inline bool PfDetectDestinationTile(TileIndex tile, Trackdir trackdir)
 	{
+		if (!m_corridorEndsAtDestination) return GetWaterRegionPatchInfo(tile) == m_corridor.back();
+
 		if (m_destStation != INVALID_STATION) {
 			return IsDockingTile(tile) && IsShipDestinationTile(tile, m_destStation);
 		}
@@ -87,11 +148,18 @@ public:
 		int y1 = 2 * TileY(tile) + dg_dir_to_y_offs[(int)exitdir];
 		int x2 = 2 * TileX(m_destTile);
 		int y2 = 2 * TileY(m_destTile);
+		if (!m_corridorEndsAtDestination) {
+			/* Aim for the nearest tile of the region the corridor ends in. */
+			const WaterRegionPatchDesc &end = m_corridor.back();
+			x2 = Clamp(x1, 2 * end.x * WATER_REGION_EDGE_LENGTH, 2 * ((end.x + 1) * WATER_REGION_EDGE_LENGTH - 1));
+			y2 = Clamp(y1, 2 * end.y * WATER_REGION_EDGE_LENGTH, 2 * ((end.y + 1) * WATER_REGION_EDGE_LENGTH - 1));
+		}
 		int dx = abs(x1 - x2);
 		int dy = abs(y1 - y2);
 		int dmin = std::min(dx, dy);
 		int dxy = abs(dx - dy);
 		int d = dmin * YAPF_TILE_CORNER_LENGTH + (dxy - 1) * (YAPF_TILE_LENGTH / 2);
+		if (!m_corridorEndsAtDestination) d = std::max(d, 0);
 		n.m_estimate = n.m_cost + d;
 		assert(n.m_estimate >= n.m_parent->m_estimate);
 		return true;
@@ -125,18 +193,50 @@ public:
 	inline void PfFollowNode(Node &old_node)
 	{
 		TrackFollower F(Yapf().GetVehicle());
-		if (F.Follow(old_node.m_key.m_tile, old_node.m_key.m_td)) {
+		if (F.Follow(old_node.m_key.m_tile, old_node.m_key.m_td) && Yapf().IsTileInCorridor(F.m_new_tile)) {
 			Yapf().AddMultipleNodes(&old_node, F);
 		}
 	}
 
+	static const uint NUMBER_OF_WATER_REGIONS_LOOKAHEAD = 4; ///< Number of water region patches of the route the search may enter.
+
+	/**
+	 * Limit the search of a pathfinder to the first water regions of the route
+	 * over the water regions of the map, so it does not need to visit all water
+	 * between the ship and its destination.
+	 * @param pf The pathfinder, with its destination set.
+	 * @param origin_tile The tile the search starts at.
+	 * @param[out] path_found Set to false when there is no route to the destination.
+	 * @return False when there is no route to the destination, true otherwise.
+	 */
+	static bool SetWaterRegionCorridor(Tpf &pf, TileIndex origin_tile, bool &path_found)
+	{
+		WaterRegionPatchDesc origin = GetWaterRegionPatchInfo(origin_tile);
+		if (origin.label == INVALID_WATER_REGION_PATCH) return true;
+
+		std::vector<WaterRegionPatchDesc> destinations = pf.GetDestinationPatches();
+		/* Nothing to gain when the destination is not on water or close by. */
+		if (destinations.empty() || std::find(destinations.begin(), destinations.end(), origin) != destinations.end()) return true;
+
+		std::vector<WaterRegionPatchDesc> path = YapfShipFindWaterRegionPath(origin, destinations);
+		if (path.empty()) {
+			path_found = false;
+			return false;
+		}
+
+		bool ends_at_destination = path.size() <= NUMBER_OF_WATER_REGIONS_LOOKAHEAD;
+		if (!ends_at_destination) path.resize(NUMBER_OF_WATER_REGIONS_LOOKAHEAD);
+		pf.SetCorridor(std::move(path), ends_at_destination);
+		return true;
+	}
+
 	/** return debug report character to identify the transportation type */
 	inline char TransportTypeChar() const
 	{
 		return 'w';
 	}
 
-	static Trackdir ChooseShipTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, ShipPathCache &path_cache)
+	static Trackdir ChooseShipTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool use_corridor, bool &path_found, ShipPathCache &path_cache)
 	{
 		/* handle special case - when next tile is destination tile */
 		if (tile == v->dest_tile) {
@@ -163,8 +263,18 @@ public:
 		/* set origin and destination nodes */
 		pf.SetOrigin(src_tile, trackdirs);
 		pf.SetDestination(v);
+		if (use_corridor && !SetWaterRegionCorridor(pf, src_tile, path_found)) {
+			/* There is no water route to the destination; just carry on. */
+			TrackdirBits reachable = TrackBitsToTrackdirBits(tracks) & DiagdirReachesTrackdirs(enterdir);
+			return reachable != TRACKDIR_BIT_NONE ? (Trackdir)FindFirstBit2x64(reachable) : INVALID_TRACKDIR;
+		}
+		bool intermediate_destination = pf.HasIntermediateDestination();
 		/* find best path */
 		path_found = pf.FindPath(v);
+		if (!path_found && pf.HasCorridor()) {
+			/* The corridor is too narrow; search all water instead. */
+			return ChooseShipTrack(v, tile, enterdir, tracks, false, path_found, path_cache);
+		}
 
 		Trackdir next_trackdir = INVALID_TRACKDIR; // this would mean "path not found"
 
@@ -173,7 +283,7 @@ public:
 			uint steps = 0;
 			for (Node *n = pNode; n->m_parent != nullptr; n = n->m_parent) steps++;
 			uint skip = 0;
-			if (path_found) skip = YAPF_SHIP_PATH_CACHE_LENGTH / 2;
+			if (path_found && !intermediate_destination) skip = YAPF_SHIP_PATH_CACHE_LENGTH / 2;
 
 			/* walk through the path back to the origin */
 			Node *pPrevNode = nullptr;
@@ -192,7 +302,7 @@ public:
 			assert(best_next_node.GetTile() == tile);
 			next_trackdir = best_next_node.GetTrackdir();
 			/* remove last element for the special case when tile == dest_tile */
-			if (path_found && !path_cache.empty()) path_cache.pop_back();
+			if (path_found && !intermediate_destination && !path_cache.empty()) path_cache.pop_back();
 		}
 		return next_trackdir;
 	}
@@ -352,7 +462,7 @@ struct CYapfShip2 : CYapfT<CYapfShip_TypesT<CYapfShip2, CFollowTrackWater    , C
 Track YapfShipChooseTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, ShipPathCache &path_cache)
 {
 	/* default is YAPF type 2 */
-	typedef Trackdir (*PfnChooseShipTrack)(const Ship*, TileIndex, DiagDirection, TrackBits, bool &path_found, ShipPathCache &path_cache);
+	typedef Trackdir (*PfnChooseShipTrack)(const Ship*, TileIndex, DiagDirection, TrackBits, bool use_corridor, bool &path_found, ShipPathCache &path_cache);
 	PfnChooseShipTrack pfnChooseShipTrack = CYapfShip2::ChooseShipTrack; // default: ExitDir
 
 	/* check if non-default YAPF type needed */
@@ -360,7 +470,7 @@ Track YapfShipChooseTrack(const Ship *v, TileIndex tile, DiagDirection enterdir,
 		pfnChooseShipTrack = &CYapfShip1::ChooseShipTrack; // Trackdir
 	}
 
-	Trackdir td_ret = pfnChooseShipTrack(v, tile, enterdir, tracks, path_found, path_cache);
+	Trackdir td_ret = pfnChooseShipTrack(v, tile, enterdir, tracks, true, path_found, path_cache);
 	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : INVALID_TRACK;
 }
 
@@ -0,0 +1,137 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_ship_regions.cpp Pathfinding over the water regions of the map. */
+
+#include "../../stdafx.h"
+#include "../../core/math_func.hpp"
+#include "yapf_ship_regions.h"
+
+#include <queue>
+#include <unordered_map>
+
+#include "../../safeguards.h"
+
+/** A water region patch in the open list of the search. */
+struct WaterRegionOpenNode {
+	uint estimate;  ///< Cost from the origin plus the estimated cost to the destination.
+	uint32 hash;    ///< Hash of the patch.
+	uint cost;      ///< Cost from the origin.
+
+	/**
+	 * Order the nodes with the highest estimate first, as std::priority_queue pops the largest node.
+	 * Ties are broken on the hash, so the search visits the nodes in the same order everywhere.
+	 */
+	bool operator<(const WaterRegionOpenNode &other) const
+	{
+		if (this->estimate != other.estimate) return this->estimate > other.estimate;
+		return this->hash > other.hash;
+	}
+};
+
+/** What the search knows about a water region patch it reached. */
+struct WaterRegionSearchNode {
+	WaterRegionPatchDesc patch;  ///< The patch.
+	uint32 parent;               ///< Hash of the patch the best route to this patch comes from.
+	uint cost;                   ///< Cost of the best route from the origin.
+	bool closed;                 ///< Whether the best route to this patch is final.
+};
+
+/** State of a search for the route over the water regions. */
+struct WaterRegionSearch {
+	const std::vector<WaterRegionPatchDesc> &destinations;      ///< The patches to reach.
+	std::unordered_map<uint32, WaterRegionSearchNode> nodes;     ///< The patches reached so far, by hash.
+	std::priority_queue<WaterRegionOpenNode> open;               ///< The patches to visit.
+	const WaterRegionSearchNode *current;                        ///< The patch being visited.
+
+	WaterRegionSearch(const std::vector<WaterRegionPatchDesc> &destinations) : destinations(destinations), current(nullptr) {}
+
+	/**
+	 * Get the lowest number of regions between a patch and any of the destinations.
+	 * @param patch The patch.
+	 * @return The distance to the nearest destination, in regions.
+	 */
+	uint Estimate(const WaterRegionPatchDesc &patch) const
+	{
+		uint best = UINT_MAX;
+		for (const WaterRegionPatchDesc &dest : this->destinations) {
+			best = std::min(best, Delta(patch.x, dest.x) + Delta(patch.y, dest.y));
+		}
+		return best;
+	}
+
+	/**
+	 * Add a patch to the search, or improve the route to it.
+	 * @param patch The patch.
+	 * @param parent Hash of the patch the route comes from.
+	 * @param cost Cost of the route from the origin.
+	 */
+	void Add(const WaterRegionPatchDesc &patch, uint32 parent, uint cost)
+	{
+		uint32 hash = CalculateWaterRegionPatchHash(patch);
+		auto it = this->nodes.find(hash);
+		if (it != this->nodes.end()) {
+			if (it->second.closed || it->second.cost <= cost) return;
+			it->second.parent = parent;
+			it->second.cost = cost;
+		} else {
+			this->nodes.emplace(hash, WaterRegionSearchNode{patch, parent, cost, false});
+		}
+		this->open.push({cost + this->Estimate(patch), hash, cost});
+	}
+
+	/** Add a neighbour of the patch being visited to the search. */
+	static void VisitNeighbour(const WaterRegionPatchDesc &patch, void *data)
+	{
+		WaterRegionSearch *search = (WaterRegionSearch *)data;
+		const WaterRegionSearchNode &current = *search->current;
+		uint cost = current.cost + Delta(current.patch.x, patch.x) + Delta(current.patch.y, patch.y);
+		search->Add(patch, CalculateWaterRegionPatchHash(current.patch), cost);
+	}
+};
+
+/**
+ * Find the route a ship should take over the water regions of the map.
+ * The cost of a route is the number of regions it passes, so the route is
+ * a rough guide which the ship pathfinder refines tile by tile.
+ * @param origin The patch the ship is in.
+ * @param destinations The patches the ship may go to.
+ * @return The patches from the origin to the nearest destination, both included; empty when there is no route.
+ */
+std::vector<WaterRegionPatchDesc> YapfShipFindWaterRegionPath(const WaterRegionPatchDesc &origin, const std::vector<WaterRegionPatchDesc> &destinations)
+{
+	std::vector<WaterRegionPatchDesc> path;
+	if (origin.label == INVALID_WATER_REGION_PATCH || destinations.empty()) return path;
+
+	WaterRegionSearch search(destinations);
+	uint32 origin_hash = CalculateWaterRegionPatchHash(origin);
+	search.Add(origin, origin_hash, 0);
+
+	while (!search.open.empty()) {
+		WaterRegionOpenNode open = search.open.top();
+		search.open.pop();
+
+		WaterRegionSearchNode &node = search.nodes.find(open.hash)->second;
+		/* A better route to this patch was found after this entry was added. */
+		if (node.closed || node.cost != open.cost) continue;
+		node.closed = true;
+
+		if (std::find(destinations.begin(), destinations.end(), node.patch) != destinations.end()) {
+			for (const WaterRegionSearchNode *n = &node;; n = &search.nodes.find(n->parent)->second) {
+				path.push_back(n->patch);
+				if (n->parent == CalculateWaterRegionPatchHash(n->patch)) break;
+			}
+			std::reverse(path.begin(), path.end());
+			return path;
+		}
+
+		search.current = &node;
+		VisitWaterRegionPatchNeighbours(node.patch, &WaterRegionSearch::VisitNeighbour, &search);
+	}
+
+	return path;
+}
@@ -16,6 +16,7 @@
 #include "road_func.h"
 #include "tile_map.h"
 #include "road_type.h"
+#include "pathfinder/yapf/yapf_cache.h"
 
 
 /** The different types of road tiles. */
@@ -158,6 +159,7 @@ static inline void SetRoadBits(TileIndex t, RoadBits r, RoadTramType rtt)
 	} else {
 		SB(_m[t].m5, 0, 4, r);
 	}
+	YapfNotifyRoadLayoutChange();
 }
 
 static inline RoadType GetRoadTypeRoad(TileIndex t)
@@ -255,6 +257,7 @@ static inline void SetRoadOwner(TileIndex t, RoadTramType rtt, Owner o)
 	} else {
 		SB(_m[t].m3, 4, 4, o == OWNER_NONE ? OWNER_TOWN : o);
 	}
+	MarkTileChanged(t);
 }
 
 /**
@@ -314,6 +317,7 @@ static inline void SetDisallowedRoadDirections(TileIndex t, DisallowedRoadDirect
 	assert(IsNormalRoad(t));
 	assert(drd < DRD_END);
 	SB(_m[t].m5, 4, 2, drd);
+	YapfNotifyRoadLayoutChange();
 }
 
 /**
@@ -394,6 +398,7 @@ static inline void SetCrossingReservation(TileIndex t, bool b)
 {
 	assert(IsLevelCrossingTile(t));
 	SB(_m[t].m5, 4, 1, b ? 1 : 0);
+	MarkTileChanged(t);
 }
 
 /**
@@ -581,6 +586,7 @@ static inline void SetRoadTypeRoad(TileIndex t, RoadType rt)
 	assert(MayHaveRoad(t));
 	assert(rt == INVALID_ROADTYPE || RoadTypeIsRoad(rt));
 	SB(_m[t].m4, 0, 6, rt);
+	YapfNotifyRoadLayoutChange();
 }
 
 /**
@@ -593,6 +599,7 @@ static inline void SetRoadTypeTram(TileIndex t, RoadType rt)
 	assert(MayHaveRoad(t));
 	assert(rt == INVALID_ROADTYPE || RoadTypeIsTram(rt));
 	SB(_me[t].m8, 6, 6, rt);
+	YapfNotifyRoadLayoutChange();
 }
 
 /**
@@ -2215,6 +2215,9 @@ bool AfterLoadGame()
 				tile++;
 			}
 		}
+
+		/* The tiles were removed from the table directly, so the lookup index is out of date. */
+		RebuildAnimatedTileIndex();
 	}
 
 	if (IsSavegameVersionBefore(SLV_124) && !IsSavegameVersionBefore(SLV_1)) {
@@ -3214,6 +3217,11 @@ bool AfterLoadGame()
 		}
 	}
 
+	/* The town growth schedule is not saved, rebuild it from the grow counters. */
+	RebuildTownGrowthSchedule();
+	/* Neither is the industry production schedule. */
+	RebuildIndustrySchedule();
+
 	/* Compute station catchment areas. This is needed here in case UpdateStationAcceptance is called below. */
 	Station::RecomputeCatchmentForAll();
 
@@ -13,6 +13,7 @@
 #include "compat/animated_tile_sl_compat.h"
 
 #include "../tile_type.h"
+#include "../animated_tile_func.h"
 #include "../core/alloc_func.hpp"
 #include "../core/smallvec_type.hpp"
 
@@ -29,6 +30,7 @@ struct ANITChunkHandler : ChunkHandler {
 
 	void Save() const override
 	{
+		CompactAnimatedTiles();
 		SlTableHeader(_animated_tile_desc);
 
 		SlSetArrayIndex(0);
@@ -36,6 +38,15 @@ struct ANITChunkHandler : ChunkHandler {
 	}
 
 	void Load() const override
+	{
+		this->LoadTiles();
+
+		/* The lookup index of the animated tile table is not saved; afterload already removes tiles through it. */
+		RebuildAnimatedTileIndex();
+	}
+
+	/** Load the animated tile table, in any of its formats. */
+	void LoadTiles() const
 	{
 		/* Before version 80 we did NOT have a variable length animated tile table */
 		if (IsSavegameVersionBefore(SLV_80)) {
@@ -83,6 +83,7 @@ struct INDYChunkHandler : ChunkHandler {
 
 		/* Write the industries */
 		for (Industry *ind : Industry::Iterate()) {
+			SyncIndustryCounter(ind);
 			SlSetArrayIndex(ind->index);
 			SlObject(ind, _industry_desc);
 		}
@@ -26,6 +26,7 @@
 #include "../engine_func.h"
 #include "../company_base.h"
 #include "../disaster_vehicle.h"
+#include "../animated_tile_func.h"
 #include "../core/smallvec_type.hpp"
 #include "saveload_internal.h"
 #include "oldloader.h"
@@ -646,6 +647,7 @@ static bool LoadOldAnimTileList(LoadgameState *ls, int num)
 		if (anim_list[i] == 0) break;
 		_animated_tiles.push_back(anim_list[i]);
 	}
+	RebuildAnimatedTileIndex();
 
 	return true;
 }
@@ -1467,8 +1469,8 @@ static bool LoadOldGameDifficulty(LoadgameState *ls, int num)
 static bool LoadOldMapPart1(LoadgameState *ls, int num)
 {
 	if (_savegame_type == SGT_TTO) {
-		MemSetT(_m, 0, OLD_MAP_SIZE);
-		MemSetT(_me, 0, OLD_MAP_SIZE);
+		MemSetT(_m.data, 0, OLD_MAP_SIZE);
+		MemSetT(_me.data, 0, OLD_MAP_SIZE);
 	}
 
 	for (uint i = 0; i < OLD_MAP_SIZE; i++) {
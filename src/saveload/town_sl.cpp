@@ -284,6 +284,7 @@ struct CITYChunkHandler : ChunkHandler {
 		SlTableHeader(_town_desc);
 
 		for (Town *t : Town::Iterate()) {
+			SyncTownGrowCounter(t);
 			SlSetArrayIndex(t->index);
 			SlObject(t, _town_desc);
 		}
@@ -28,6 +28,12 @@
 #include "landscape.h"
 #include "video/video_driver.hpp"
 #include "smallmap_gui.h"
+#include "thread.h"
+#include "tile_journal.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 
 #include "table/strings.h"
 
@@ -35,6 +41,7 @@
 
 static const char * const SCREENSHOT_NAME = "screenshot"; ///< Default filename of a saved screenshot.
 static const char * const HEIGHTMAP_NAME  = "heightmap";  ///< Default filename of a saved heightmap.
+static const char * const MINIMAP_NAME    = "minimap";    ///< Default filename of a saved tiled minimap.
 
 std::string _screenshot_format_name;  ///< Extension of the current screenshot format (corresponds with #_cur_screenshot_format).
 uint _num_screenshot_formats;         ///< Number of available screenshot formats.
@@ -608,18 +615,19 @@ static void CurrentScreenCallback(void *userdata, void *buf, uint y, uint pitch,
 }
 
 /**
- * generate a large piece of the world
- * @param userdata Viewport area to draw
+ * Render a part of a viewport of the world into a buffer.
+ * @param vp Viewport area to draw
  * @param buf Videobuffer with same bitdepth as current blitter
- * @param y First line to render
  * @param pitch Pitch of the videobuffer
- * @param n Number of lines to render
+ * @param left First column to render
+ * @param top First line to render
+ * @param width Number of columns to render
+ * @param height Number of lines to render
  */
-static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
+static void RenderWorldArea(const Viewport *vp, void *buf, uint pitch, int left, int top, uint width, uint height)
 {
-	Viewport *vp = (Viewport *)userdata;
 	DrawPixelInfo dpi, *old_dpi;
-	int wx, left;
+	int wx, x;
 
 	/* We are no longer rendering to the screen */
 	DrawPixelInfo old_screen = _screen;
@@ -627,7 +635,7 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 
 	_screen.dst_ptr = buf;
 	_screen.width = pitch;
-	_screen.height = n;
+	_screen.height = height;
 	_screen.pitch = pitch;
 	_screen_disable_anim = true;
 
@@ -635,24 +643,24 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 	_cur_dpi = &dpi;
 
 	dpi.dst_ptr = buf;
-	dpi.height = n;
-	dpi.width = vp->width;
+	dpi.height = height;
+	dpi.width = width;
 	dpi.pitch = pitch;
 	dpi.zoom = ZOOM_LVL_WORLD_SCREENSHOT;
-	dpi.left = 0;
-	dpi.top = y;
+	dpi.left = left;
+	dpi.top = top;
 
 	/* Render viewport in blocks of 1600 pixels width */
-	left = 0;
-	while (vp->width - left != 0) {
-		wx = std::min(vp->width - left, 1600);
-		left += wx;
+	x = left;
+	while (left + (int)width - x != 0) {
+		wx = std::min(left + (int)width - x, 1600);
+		x += wx;
 
 		ViewportDoDraw(vp,
-			ScaleByZoom(left - wx - vp->left, vp->zoom) + vp->virtual_left,
-			ScaleByZoom(y - vp->top, vp->zoom) + vp->virtual_top,
-			ScaleByZoom(left - vp->left, vp->zoom) + vp->virtual_left,
-			ScaleByZoom((y + n) - vp->top, vp->zoom) + vp->virtual_top
+			ScaleByZoom(x - wx - vp->left, vp->zoom) + vp->virtual_left,
+			ScaleByZoom(top - vp->top, vp->zoom) + vp->virtual_top,
+			ScaleByZoom(x - vp->left, vp->zoom) + vp->virtual_left,
+			ScaleByZoom((top + (int)height) - vp->top, vp->zoom) + vp->virtual_top
 		);
 	}
 
@@ -663,6 +671,127 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 	_screen_disable_anim = old_disable_anim;
 }
 
+/**
+ * generate a large piece of the world
+ * @param userdata Viewport area to draw
+ * @param buf Videobuffer with same bitdepth as current blitter
+ * @param y First line to render
+ * @param pitch Pitch of the videobuffer
+ * @param n Number of lines to render
+ */
+static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
+{
+	const Viewport *vp = (const Viewport *)userdata;
+	RenderWorldArea(vp, buf, pitch, 0, y, vp->width, n);
+}
+
+#ifdef WITH_MAP_LAYOUT_BLOCKS
+/**
+ * Draw the area of the main viewport at the default zoom level into a buffer, like a screenshot of it, a number of times.
+ * @param rounds The number of times to draw it.
+ * @return The number of microseconds the drawing took, or 0 when there is nothing to draw on.
+ */
+uint64 ViewportDrawingBenchmark(uint rounds)
+{
+	Blitter *blitter = BlitterFactory::GetCurrentBlitter();
+	if (blitter->GetScreenDepth() == 0 || FindWindowById(WC_MAIN_WINDOW, 0) == nullptr) return 0;
+
+	Viewport vp;
+	SetupScreenshotViewport(SC_DEFAULTZOOM, &vp);
+	std::vector<byte> buf((size_t)vp.width * vp.height * blitter->GetScreenDepth() / 8);
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint i = 0; i < rounds; i++) RenderWorldArea(&vp, buf.data(), vp.width, 0, 0, vp.width, vp.height);
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+#endif /* WITH_MAP_LAYOUT_BLOCKS */
+
+/**
+ * Wrapper of a screenshot callback that generates the next lines on a worker thread,
+ * while the screenshot writer is encoding the current ones.
+ * Writers ask for the lines in blocks of the same size, either top down or bottom up,
+ * so the next block is predicted from the direction of the first one that is asked for.
+ * When a writer asks for other lines, they are generated the normal way.
+ * There is only one worker thread, so the callback is never called by two threads at once.
+ */
+class ScreenshotPrefetcher {
+	ScreenshotCallback *callb; ///< The wrapped callback.
+	void *userdata;            ///< User data of the wrapped callback.
+	uint height;               ///< Height of the image in pixels.
+	uint bytes_per_pixel;      ///< Bytes per pixel of the buffers.
+	bool first = true;         ///< Whether no lines have been asked for yet.
+	bool bottom_up = false;    ///< Whether the lines are asked for bottom up.
+
+	std::thread thread;        ///< Worker thread generating the next lines, if any.
+	std::vector<byte> next;    ///< Buffer the next lines are generated into.
+	uint next_y = UINT_MAX;    ///< First of the next lines.
+	uint next_pitch = 0;       ///< Pitch of the next lines.
+	uint next_n = 0;           ///< Number of the next lines.
+
+	/** Wait for the worker thread to finish generating the next lines. */
+	void Wait()
+	{
+		if (this->thread.joinable()) this->thread.join();
+	}
+
+public:
+	/**
+	 * Wrap a screenshot callback.
+	 * @param callb       The callback to wrap.
+	 * @param userdata    User data of \a callb.
+	 * @param h           Height of the image in pixels.
+	 * @param pixelformat Bits per pixel of the image.
+	 */
+	ScreenshotPrefetcher(ScreenshotCallback *callb, void *userdata, uint h, int pixelformat) :
+		callb(callb), userdata(userdata), height(h), bytes_per_pixel(pixelformat / 8) {}
+
+	~ScreenshotPrefetcher()
+	{
+		this->Wait();
+	}
+
+	/**
+	 * Screenshot callback of the wrapper.
+	 * @param userdata The #ScreenshotPrefetcher.
+	 * @see ScreenshotCallback
+	 */
+	static void Callback(void *userdata, void *buf, uint y, uint pitch, uint n)
+	{
+		ScreenshotPrefetcher *pf = (ScreenshotPrefetcher *)userdata;
+		pf->Wait();
+
+		if (y == pf->next_y && n == pf->next_n && pitch == pf->next_pitch) {
+			memcpy(buf, pf->next.data(), pf->next.size());
+		} else {
+			pf->callb(pf->userdata, buf, y, pitch, n);
+		}
+
+		if (pf->first) {
+			pf->first = false;
+			pf->bottom_up = y != 0 && y + n == pf->height;
+		}
+
+		/* Predict the next lines; stop at the end of the image. */
+		if (pf->bottom_up) {
+			if (y == 0) return;
+			pf->next_n = std::min(n, y);
+			pf->next_y = y - pf->next_n;
+		} else {
+			if (y + n >= pf->height) return;
+			pf->next_y = y + n;
+			pf->next_n = std::min(n, pf->height - pf->next_y);
+		}
+		pf->next_pitch = pitch;
+		pf->next.assign((size_t)pitch * pf->next_n * pf->bytes_per_pixel, 0);
+
+		if (!StartNewThread(&pf->thread, "ottd:screenshot", [pf]() {
+				pf->callb(pf->userdata, pf->next.data(), pf->next_y, pf->next_pitch, pf->next_n);
+			})) {
+			pf->next_y = UINT_MAX;
+		}
+	}
+};
+
 /**
  * Construct a pathname for a screenshot file.
  * @param default_fn Default filename.
@@ -812,9 +941,324 @@ static bool MakeLargeWorldScreenshot(ScreenshotType t, uint32 width = 0, uint32
 	Viewport vp;
 	SetupScreenshotViewport(t, &vp, width, height);
 
+	/* Render the next lines while the writer is encoding the current ones. */
+	int depth = BlitterFactory::GetCurrentBlitter()->GetScreenDepth();
+	ScreenshotPrefetcher prefetcher(LargeWorldCallback, &vp, vp.height, depth);
+
 	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
-	return sf->proc(MakeScreenshotName(SCREENSHOT_NAME, sf->extension), LargeWorldCallback, &vp, vp.width, vp.height,
-			BlitterFactory::GetCurrentBlitter()->GetScreenDepth(), _cur_palette.palette);
+	return sf->proc(MakeScreenshotName(SCREENSHOT_NAME, sf->extension), ScreenshotPrefetcher::Callback, &prefetcher, vp.width, vp.height,
+			depth, _cur_palette.palette);
+}
+
+/** Width and height of the tiles of a tiled screenshot, in pixels. */
+static const uint SCREENSHOT_TILE_SIZE = 256;
+
+/**
+ * Callback function signature for generating a part of a tiled screenshot.
+ * @param userdata Pointer to user data.
+ * @param buf      Destination buffer, with #SCREENSHOT_TILE_SIZE pixels per line.
+ * @param left     First column to write.
+ * @param top      First line to write.
+ * @param width    Number of columns to write.
+ * @param height   Number of lines to write.
+ */
+typedef void ScreenshotTileCallback(void *userdata, Colour *buf, int left, int top, uint width, uint height);
+
+/**
+ * Writes the tiles of a tiled screenshot to their files on worker threads,
+ * while the next tiles are generated on the calling thread.
+ */
+class ScreenshotTileWriter {
+	/** A tile waiting to be written. */
+	struct Job {
+		std::string name;               ///< Filename of the tile.
+		std::unique_ptr<Colour[]> tile; ///< The pixels of the tile.
+	};
+
+	const ScreenshotFormat *sf;        ///< Format to write the tiles in.
+	std::vector<std::thread> threads;  ///< The worker threads.
+	std::deque<Job> jobs;              ///< Tiles waiting to be written.
+	std::mutex lock;                   ///< Lock for #jobs, #done and #failed.
+	std::condition_variable job_added; ///< Signalled when a tile is added, or when there are no more tiles.
+	std::condition_variable job_taken; ///< Signalled when a worker takes a tile.
+	bool done = false;                 ///< Whether no more tiles will be added.
+	bool failed = false;               ///< Whether writing a tile failed.
+
+	/**
+	 * Callback of the screenshot writer that copies the lines of a tile.
+	 * @param userdata The pixels of the tile.
+	 * @see ScreenshotCallback
+	 */
+	static void TileCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
+	{
+		memcpy(buf, (const Colour *)userdata + y * SCREENSHOT_TILE_SIZE, n * SCREENSHOT_TILE_SIZE * sizeof(Colour));
+	}
+
+	/**
+	 * Write a tile to its file.
+	 * @param job The tile.
+	 * @return Whether the file was written.
+	 */
+	bool WriteTile(const Job &job)
+	{
+		return this->sf->proc(job.name.c_str(), TileCallback, job.tile.get(), SCREENSHOT_TILE_SIZE, SCREENSHOT_TILE_SIZE, 32, nullptr);
+	}
+
+	/** Loop of the worker threads. */
+	void Work()
+	{
+		std::unique_lock<std::mutex> lock(this->lock);
+		for (;;) {
+			this->job_added.wait(lock, [this]() { return this->done || !this->jobs.empty(); });
+			if (this->jobs.empty()) return;
+
+			Job job = std::move(this->jobs.front());
+			this->jobs.pop_front();
+			this->job_taken.notify_one();
+
+			lock.unlock();
+			bool written = this->WriteTile(job);
+			lock.lock();
+			if (!written) this->failed = true;
+		}
+	}
+
+public:
+	/**
+	 * Start the worker threads.
+	 * @param sf Format to write the tiles in.
+	 */
+	ScreenshotTileWriter(const ScreenshotFormat *sf) : sf(sf)
+	{
+		uint num_threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+		for (uint i = 0; i < num_threads; i++) {
+			std::thread t;
+			if (!StartNewThread(&t, "ottd:screenshot", [this]() { this->Work(); })) break;
+			this->threads.push_back(std::move(t));
+		}
+	}
+
+	~ScreenshotTileWriter()
+	{
+		this->Finish();
+	}
+
+	/**
+	 * Write a tile, or queue it for writing when there are worker threads.
+	 * Waits when too many tiles are queued, so the memory used stays limited.
+	 * @param name Filename of the tile.
+	 * @param tile The pixels of the tile.
+	 */
+	void Write(std::string name, std::unique_ptr<Colour[]> tile)
+	{
+		Job job{std::move(name), std::move(tile)};
+
+		if (this->threads.empty()) {
+			if (!this->WriteTile(job)) this->failed = true;
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(this->lock);
+		this->job_taken.wait(lock, [this]() { return this->jobs.size() < this->threads.size() * 2; });
+		this->jobs.push_back(std::move(job));
+		this->job_added.notify_one();
+	}
+
+	/**
+	 * Check whether writing a tile failed.
+	 * @return True when a tile could not be written.
+	 */
+	bool HasFailed()
+	{
+		std::lock_guard<std::mutex> lock(this->lock);
+		return this->failed;
+	}
+
+	/**
+	 * Write the queued tiles and stop the worker threads.
+	 * @return Whether all tiles were written.
+	 */
+	bool Finish()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->lock);
+			this->done = true;
+		}
+		this->job_added.notify_all();
+		for (std::thread &t : this->threads) t.join();
+		this->threads.clear();
+
+		return !this->failed;
+	}
+};
+
+/**
+ * Generator of a tiled screenshot: a pyramid of tiles of #SCREENSHOT_TILE_SIZE pixels, as used by web map viewers.
+ * The tiles of the highest level are generated by a callback; every tile of a lower level
+ * is its four tiles of the next level scaled down. Tile \c x, \c y of level \c z is
+ * written to the file \c z/x/y in the directory of the screenshot. Tiles are generated
+ * depth first, so only a few tiles per level are in memory at once.
+ * Optionally only the tiles that changed are written; all tiles are still generated,
+ * as a changed tile is made of unchanged ones too.
+ */
+struct ScreenshotTilePyramid {
+	ScreenshotTileCallback *callb; ///< Callback generating the pixels of the highest level.
+	void *userdata;                ///< User data, passed on to #callb.
+	uint width;                    ///< Width of the image at the highest level.
+	uint height;                   ///< Height of the image at the highest level.
+	uint levels;                   ///< The highest level; level 0 is one tile.
+	const std::vector<bool> *dirty; ///< For every tile of the highest level, row by row, whether it changed; \c nullptr when all tiles changed.
+	std::string dir;               ///< Directory to write the tiles to, including the final path separator.
+	std::vector<std::vector<bool>> created; ///< For every level, whether the directory of a column of tiles has been created.
+	const char *extension;         ///< Extension of the files of the tiles.
+	ScreenshotTileWriter writer;   ///< Writer of the tiles.
+
+	/**
+	 * Create the generator of a tiled screenshot.
+	 * @param dir      Directory to write the tiles to.
+	 * @param callb    Callback generating the pixels of the highest level.
+	 * @param userdata User data, passed on to \a callb.
+	 * @param w        Width of the image at the highest level.
+	 * @param h        Height of the image at the highest level.
+	 * @param sf       Format to write the tiles in.
+	 * @param dirty    For every tile of the highest level, row by row, whether it changed; \c nullptr when all tiles changed.
+	 */
+	ScreenshotTilePyramid(const std::string &dir, ScreenshotTileCallback *callb, void *userdata, uint w, uint h, const ScreenshotFormat *sf, const std::vector<bool> *dirty = nullptr) :
+		callb(callb), userdata(userdata), width(w), height(h), levels(0), dirty(dirty), dir(dir + PATHSEP), extension(sf->extension), writer(sf)
+	{
+		while ((uint64)SCREENSHOT_TILE_SIZE << this->levels < std::max(w, h)) this->levels++;
+		for (uint z = 0; z <= this->levels; z++) this->created.emplace_back(1 << z, false);
+	}
+
+	/**
+	 * Scale a tile down to a quarter of a tile of the previous level.
+	 * @param src The tile.
+	 * @param dst The top left pixel of the quarter.
+	 */
+	static void ScaleDown(const Colour *src, Colour *dst)
+	{
+		const uint half = SCREENSHOT_TILE_SIZE / 2;
+		for (uint y = 0; y < half; y++) {
+			for (uint x = 0; x < half; x++) {
+				const Colour *a = src + 2 * y * SCREENSHOT_TILE_SIZE + 2 * x;
+				const Colour *b = a + SCREENSHOT_TILE_SIZE;
+				dst[y * SCREENSHOT_TILE_SIZE + x] = Colour(
+						(a[0].r + a[1].r + b[0].r + b[1].r + 2) / 4,
+						(a[0].g + a[1].g + b[0].g + b[1].g + 2) / 4,
+						(a[0].b + a[1].b + b[0].b + b[1].b + 2) / 4,
+						(a[0].a + a[1].a + b[0].a + b[1].a + 2) / 4);
+			}
+		}
+	}
+
+	/**
+	 * Queue a tile for writing.
+	 * @param z    Level of the tile.
+	 * @param x    Column of the tile.
+	 * @param y    Row of the tile.
+	 * @param tile The pixels of the tile.
+	 */
+	void WriteTile(uint z, uint x, uint y, std::unique_ptr<Colour[]> tile)
+	{
+		std::string column = this->dir + std::to_string(z) + PATHSEP + std::to_string(x) + PATHSEP;
+		if (!this->created[z][x]) {
+			FioCreateDirectory(this->dir + std::to_string(z));
+			FioCreateDirectory(column);
+			this->created[z][x] = true;
+		}
+		this->writer.Write(column + std::to_string(y) + "." + this->extension, std::move(tile));
+	}
+
+	/**
+	 * Generate a tile, and write the tiles of the higher levels it is made of.
+	 * @param z Level of the tile.
+	 * @param x Column of the tile.
+	 * @param y Row of the tile.
+	 * @param[out] changed Whether the tile changed.
+	 * @return The pixels of the tile, or \c nullptr when it is outside of the image or writing failed.
+	 */
+	std::unique_ptr<Colour[]> MakeTile(uint z, uint x, uint y, bool *changed)
+	{
+		uint64 span = (uint64)SCREENSHOT_TILE_SIZE << (this->levels - z);
+		if (x * span >= this->width || y * span >= this->height || this->writer.HasFailed()) return nullptr;
+
+		std::unique_ptr<Colour[]> tile = std::make_unique<Colour[]>(SCREENSHOT_TILE_SIZE * SCREENSHOT_TILE_SIZE);
+		if (z == this->levels) {
+			int left = x * SCREENSHOT_TILE_SIZE;
+			int top = y * SCREENSHOT_TILE_SIZE;
+			this->callb(this->userdata, tile.get(), left, top, std::min(SCREENSHOT_TILE_SIZE, this->width - left), std::min(SCREENSHOT_TILE_SIZE, this->height - top));
+			*changed = this->dirty == nullptr || (*this->dirty)[y * CeilDiv(this->width, SCREENSHOT_TILE_SIZE) + x];
+			return tile;
+		}
+
+		*changed = false;
+		for (uint i = 0; i < 4; i++) {
+			uint cx = 2 * x + GB(i, 0, 1);
+			uint cy = 2 * y + GB(i, 1, 1);
+			bool child_changed;
+			std::unique_ptr<Colour[]> child = this->MakeTile(z + 1, cx, cy, &child_changed);
+			if (child == nullptr) continue;
+
+			ScaleDown(child.get(), tile.get() + GB(i, 1, 1) * SCREENSHOT_TILE_SIZE / 2 * SCREENSHOT_TILE_SIZE + GB(i, 0, 1) * SCREENSHOT_TILE_SIZE / 2);
+			if (child_changed) this->WriteTile(z + 1, cx, cy, std::move(child));
+			*changed |= child_changed;
+		}
+		return tile;
+	}
+
+	/**
+	 * Generate and write all tiles.
+	 * @return Whether all tiles were written.
+	 */
+	bool Make()
+	{
+		FioCreateDirectory(this->dir);
+		bool changed;
+		std::unique_ptr<Colour[]> root = this->MakeTile(0, 0, 0, &changed);
+		if (root != nullptr && changed) this->WriteTile(0, 0, 0, std::move(root));
+		return this->writer.Finish();
+	}
+};
+
+/**
+ * Generate a part of a tiled screenshot of the world.
+ * @param userdata Viewport area to draw
+ * @see ScreenshotTileCallback
+ */
+static void WorldTileCallback(void *userdata, Colour *buf, int left, int top, uint width, uint height)
+{
+	const Viewport *vp = (const Viewport *)userdata;
+
+	if (BlitterFactory::GetCurrentBlitter()->GetScreenDepth() == 32) {
+		RenderWorldArea(vp, buf, SCREENSHOT_TILE_SIZE, left, top, width, height);
+		return;
+	}
+
+	/* Render with the palette, and look up the colours afterwards. */
+	std::vector<uint8> pixels(SCREENSHOT_TILE_SIZE * height);
+	RenderWorldArea(vp, pixels.data(), SCREENSHOT_TILE_SIZE, left, top, width, height);
+	for (uint y = 0; y < height; y++) {
+		for (uint x = 0; x < width; x++) {
+			buf[y * SCREENSHOT_TILE_SIZE + x] = _cur_palette.palette[pixels[y * SCREENSHOT_TILE_SIZE + x]];
+		}
+	}
+}
+
+/**
+ * Make a screenshot of the whole map as a pyramid of tiles.
+ * @return true on success
+ */
+static bool MakeTiledWorldScreenshot()
+{
+	int depth = BlitterFactory::GetCurrentBlitter()->GetScreenDepth();
+	if (depth != 8 && depth != 32) return false;
+
+	Viewport vp;
+	SetupScreenshotViewport(SC_WORLD, &vp);
+
+	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
+	ScreenshotTilePyramid pyramid(MakeScreenshotName(SCREENSHOT_NAME, "tiles"), WorldTileCallback, &vp, vp.width, vp.height, sf);
+	return pyramid.Make();
 }
 
 /**
@@ -958,6 +1402,14 @@ static bool RealMakeScreenshot(ScreenshotType t, std::string name, uint32 width,
 			ret = MakeMinimapWorldScreenshot();
 			break;
 
+		case SC_WORLD_TILES:
+			ret = MakeTiledWorldScreenshot();
+			break;
+
+		case SC_MINIMAP_TILES:
+			ret = MakeMinimapTilesScreenshot();
+			break;
+
 		default:
 			NOT_REACHED();
 	}
@@ -1005,23 +1457,33 @@ bool MakeScreenshot(ScreenshotType t, std::string name, uint32 width, uint32 hei
 }
 
 
+/**
+ * Get the colour of a pixel of a minimap screenshot.
+ * @param x Column of the pixel.
+ * @param y Line of the pixel.
+ * @return The colour, without alpha.
+ */
+static uint32 GetMinimapPixel(uint x, uint y)
+{
+	TileIndex tile = TileXY((MapSizeX() - 1) - x, y);
+	byte val = GetSmallMapOwnerPixels(tile, GetTileType(tile), IncludeHeightmap::Never) & 0xFF;
+
+	uint32 colour_buf = 0;
+	colour_buf  = (_cur_palette.palette[val].b << 0);
+	colour_buf |= (_cur_palette.palette[val].g << 8);
+	colour_buf |= (_cur_palette.palette[val].r << 16);
+	return colour_buf;
+}
+
 static void MinimapScreenCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
 {
 	uint32 *ubuf = (uint32 *)buf;
 	uint num = (pitch * n);
 	for (uint i = 0; i < num; i++) {
 		uint row = y + (int)(i / pitch);
-		uint col = (MapSizeX() - 1) - (i % pitch);
-
-		TileIndex tile = TileXY(col, row);
-		byte val = GetSmallMapOwnerPixels(tile, GetTileType(tile), IncludeHeightmap::Never) & 0xFF;
+		uint col = i % pitch;
 
-		uint32 colour_buf = 0;
-		colour_buf  = (_cur_palette.palette[val].b << 0);
-		colour_buf |= (_cur_palette.palette[val].g << 8);
-		colour_buf |= (_cur_palette.palette[val].r << 16);
-
-		*ubuf = colour_buf;
+		*ubuf = GetMinimapPixel(col, row);
 		ubuf++;   // Skip alpha
 	}
 }
@@ -1034,3 +1496,57 @@ bool MakeMinimapWorldScreenshot()
 	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
 	return sf->proc(MakeScreenshotName(SCREENSHOT_NAME, sf->extension), MinimapScreenCallback, nullptr, MapSizeX(), MapSizeY(), 32, _cur_palette.palette);
 }
+
+static std::string _minimap_tiles_dir;            ///< Directory of the last tiled minimap screenshot; empty when there is none for this map.
+static TileJournalReader _minimap_tiles_journal; ///< Changes of the map since the last tiled minimap screenshot.
+
+/* The blocks of the journal have to lie within one tile of the screenshot. */
+static_assert(SCREENSHOT_TILE_SIZE % TILE_JOURNAL_BLOCK_SIZE == 0);
+
+/** Mark the whole next tiled minimap screenshot dirty, e.g. when the colours of the owners change. */
+void MarkAllMinimapTilesDirty()
+{
+	_minimap_tiles_dir.clear();
+}
+
+/**
+ * Generate a part of a tiled minimap screenshot.
+ * @see ScreenshotTileCallback
+ */
+static void MinimapTileCallback(void *userdata, Colour *buf, int left, int top, uint width, uint height)
+{
+	for (uint y = 0; y < height; y++) {
+		for (uint x = 0; x < width; x++) {
+			buf[y * SCREENSHOT_TILE_SIZE + x] = Colour(GetMinimapPixel(left + x, top + y));
+		}
+	}
+}
+
+/**
+ * Make a minimap screenshot as a pyramid of tiles.
+ * When the previous one was made in the same directory, only the tiles of which the
+ * part of the map changed since then are written again.
+ * @return true on success
+ */
+bool MakeMinimapTilesScreenshot()
+{
+	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
+	std::string dir = MakeScreenshotName(MINIMAP_NAME, "tiles");
+
+	/* Changes made while writing the tiles go to the next time. */
+	uint columns = CeilDiv(MapSizeX(), SCREENSHOT_TILE_SIZE);
+	std::vector<bool> dirty(columns * CeilDiv(MapSizeY(), SCREENSHOT_TILE_SIZE), false);
+	_minimap_tiles_journal.Start();
+	bool incremental = _minimap_tiles_journal.ReadChanges([&](TileIndex tile) {
+		dirty[TileY(tile) / SCREENSHOT_TILE_SIZE * columns + (MapMaxX() - TileX(tile)) / SCREENSHOT_TILE_SIZE] = true;
+	}) && dir == _minimap_tiles_dir;
+
+	ScreenshotTilePyramid pyramid(dir, MinimapTileCallback, nullptr, MapSizeX(), MapSizeY(), sf, incremental ? &dirty : nullptr);
+	if (!pyramid.Make()) {
+		_minimap_tiles_dir.clear();
+		return false;
+	}
+
+	_minimap_tiles_dir = dir;
+	return true;
+}
@@ -16,13 +16,15 @@ const char *GetCurrentScreenshotExtension();
 
 /** Type of requested screenshot */
 enum ScreenshotType {
-	SC_VIEWPORT,    ///< Screenshot of viewport.
-	SC_CRASHLOG,    ///< Raw screenshot from blitter buffer.
-	SC_ZOOMEDIN,    ///< Fully zoomed in screenshot of the visible area.
-	SC_DEFAULTZOOM, ///< Zoomed to default zoom level screenshot of the visible area.
-	SC_WORLD,       ///< World screenshot.
-	SC_HEIGHTMAP,   ///< Heightmap of the world.
-	SC_MINIMAP,     ///< Minimap screenshot.
+	SC_VIEWPORT,      ///< Screenshot of viewport.
+	SC_CRASHLOG,      ///< Raw screenshot from blitter buffer.
+	SC_ZOOMEDIN,      ///< Fully zoomed in screenshot of the visible area.
+	SC_DEFAULTZOOM,   ///< Zoomed to default zoom level screenshot of the visible area.
+	SC_WORLD,         ///< World screenshot.
+	SC_HEIGHTMAP,     ///< Heightmap of the world.
+	SC_MINIMAP,       ///< Minimap screenshot.
+	SC_WORLD_TILES,   ///< World screenshot as a pyramid of tiles.
+	SC_MINIMAP_TILES, ///< Minimap screenshot as a pyramid of tiles, updating the previous one.
 };
 
 void SetupScreenshotViewport(ScreenshotType t, struct Viewport *vp, uint32 width = 0, uint32 height = 0);
@@ -30,6 +32,9 @@ bool MakeHeightmapScreenshot(const char *filename);
 void MakeScreenshotWithConfirm(ScreenshotType t);
 bool MakeScreenshot(ScreenshotType t, std::string name, uint32 width = 0, uint32 height = 0);
 bool MakeMinimapWorldScreenshot();
+bool MakeMinimapTilesScreenshot();
+
+void MarkAllMinimapTilesDirty();
 
 extern std::string _screenshot_format_name;
 extern uint _num_screenshot_formats;
@@ -19,6 +19,10 @@
  * \li AICargo::GetWeight
  * \li AIIndustryType::ResolveNewGRFID
  * \li AIObjectType::ResolveNewGRFID
+ * \li AITileList::AddFilteredRectangle
+ * \li AITileList::KeepFiltered
+ * \li AITileList::ValuateCargoAcceptance
+ * \li AITileList::ValuateCargoProduction
  *
  * Other changes:
  * \li AIRoad::HasRoadType now correctly checks RoadType against RoadType
@@ -19,6 +19,10 @@
  * \li GSCargo::GetWeight
  * \li GSIndustryType::ResolveNewGRFID
  * \li GSObjectType::ResolveNewGRFID
+ * \li GSTileList::AddFilteredRectangle
+ * \li GSTileList::KeepFiltered
+ * \li GSTileList::ValuateCargoAcceptance
+ * \li GSTileList::ValuateCargoProduction
  * \li GSLeagueTable
  *
  * Other changes:
@@ -12,416 +12,438 @@
 #include "script_controller.hpp"
 #include "../../debug.h"
 #include "../../script/squirrel.hpp"
+#include "../../core/math_func.hpp"
 
 #include "../../safeguards.h"
 
 /**
- * Base class for any ScriptList sorter.
+ * Number of keys that may be in ScriptList::values_added before they are
+ * merged into ScriptList::values.
+ * @param size The number of keys in ScriptList::values.
+ * @return The maximum number of added keys.
  */
-class ScriptListSorter {
-protected:
-	ScriptList *list;       ///< The list that's being sorted.
-	bool has_no_more_items; ///< Whether we have more items to iterate over.
-	int64 item_next;        ///< The next item we will show.
-
-public:
-	/**
-	 * Virtual dtor, needed to mute warnings.
-	 */
-	virtual ~ScriptListSorter() { }
-
-	/**
-	 * Get the first item of the sorter.
-	 */
-	virtual int64 Begin() = 0;
-
-	/**
-	 * Stop iterating a sorter.
-	 */
-	virtual void End() = 0;
-
-	/**
-	 * Get the next item of the sorter.
-	 */
-	virtual int64 Next() = 0;
-
-	/**
-	 * See if the sorter has reached the end.
-	 */
-	bool IsEnd()
-	{
-		return this->list->buckets.empty() || this->has_no_more_items;
-	}
-
-	/**
-	 * Callback from the list if an item gets removed.
-	 */
-	virtual void Remove(int item) = 0;
-
-	/**
-	 * Attach the sorter to a new list. This assumes the content of the old list has been moved to
-	 * the new list, too, so that we don't have to invalidate any iterators. Note that std::swap
-	 * doesn't invalidate iterators on lists and maps, so that should be safe.
-	 * @param target New list to attach to.
-	 */
-	virtual void Retarget(ScriptList *new_list)
-	{
-		this->list = new_list;
-	}
-};
+static size_t GetMaxAddedValueKeys(size_t size)
+{
+	return std::max<size_t>(64, IntSqrt((uint32)std::min<size_t>(size, UINT32_MAX)));
+}
 
-/**
- * Sort by value, ascending.
- */
-class ScriptListSorterValueAscending : public ScriptListSorter {
-private:
-	ScriptList::ScriptListBucket::iterator bucket_iter;    ///< The iterator over the list to find the buckets.
-	ScriptList::ScriptItemList *bucket_list;               ///< The current bucket list we're iterator over.
-	ScriptList::ScriptItemList::iterator bucket_list_iter; ///< The iterator over the bucket list.
-
-public:
-	/**
-	 * Create a new sorter.
-	 * @param list The list to sort.
-	 */
-	ScriptListSorterValueAscending(ScriptList *list)
-	{
-		this->list = list;
-		this->End();
-	}
-
-	int64 Begin()
-	{
-		if (this->list->buckets.empty()) return 0;
-		this->has_no_more_items = false;
-
-		this->bucket_iter = this->list->buckets.begin();
-		this->bucket_list = &(*this->bucket_iter).second;
-		this->bucket_list_iter = this->bucket_list->begin();
-		this->item_next = *this->bucket_list_iter;
-
-		int64 item_current = this->item_next;
-		FindNext();
-		return item_current;
-	}
-
-	void End()
-	{
-		this->bucket_list = nullptr;
-		this->has_no_more_items = true;
-		this->item_next = 0;
-	}
+ScriptList::ScriptList()
+{
+	this->items_sorted    = 0;
+	this->items_first     = 0;
+	this->items_removed   = 0;
+	this->values_first    = 0;
+	this->values_outdated = 0;
+	this->values_valid    = false;
 
-	/**
-	 * Find the next item, and store that information.
-	 */
-	void FindNext()
-	{
-		if (this->bucket_list == nullptr) {
-			this->has_no_more_items = true;
-			return;
-		}
+	/* Default sorter */
+	this->sorter_type    = SORT_BY_VALUE;
+	this->sort_ascending = false;
+	this->initialized    = false;
+	this->modifications  = 0;
+	this->has_no_more_items = true;
+	this->has_next          = false;
+}
+
+ScriptList::~ScriptList()
+{
+}
 
-		this->bucket_list_iter++;
-		if (this->bucket_list_iter == this->bucket_list->end()) {
-			this->bucket_iter++;
-			if (this->bucket_iter == this->list->buckets.end()) {
-				this->bucket_list = nullptr;
-				return;
+/**
+ * Merge the entries added after the sorted entries into the sorted entries.
+ * When an item has been added more than once, or was already in the list,
+ * the first addition wins like adding them one by one does.
+ */
+void ScriptList::MergeAddedItems()
+{
+	if (this->items_sorted == this->items.size()) return;
+
+	std::stable_sort(this->items.begin() + this->items_sorted, this->items.end());
+
+	auto sorted_end = this->items.begin() + this->items_sorted;
+	auto added_begin = sorted_end;
+	auto out = added_begin;
+	for (auto it = added_begin; it != this->items.end(); ++it) {
+		if (out != added_begin && (out - 1)->item == it->item) continue;
+
+		auto found = std::lower_bound(this->items.begin(), sorted_end, it->item);
+		if (found != sorted_end && found->item == it->item) {
+			/* A removed item that is added again takes the new value. */
+			if (found->removed) {
+				found->value = it->value;
+				found->removed = false;
+				this->items_removed--;
+				this->items_first = std::min<size_t>(this->items_first, found - this->items.begin());
 			}
-			this->bucket_list = &(*this->bucket_iter).second;
-			this->bucket_list_iter = this->bucket_list->begin();
+			continue;
 		}
-		this->item_next = *this->bucket_list_iter;
+		*out++ = *it;
 	}
+	this->items.erase(out, this->items.end());
 
-	int64 Next()
-	{
-		if (this->IsEnd()) return 0;
+	std::inplace_merge(this->items.begin(), this->items.begin() + this->items_sorted, this->items.end());
+	this->items_sorted = this->items.size();
+	this->items_first = 0;
+}
 
-		int64 item_current = this->item_next;
-		FindNext();
-		return item_current;
+/**
+ * Drop the removed entries at the end of the list, and all removed entries
+ * when they make up most of the list.
+ * @pre All entries are sorted.
+ */
+void ScriptList::CleanupRemovedItems()
+{
+	while (!this->items.empty() && this->items.back().removed) {
+		this->items.pop_back();
+		this->items_removed--;
 	}
+	this->items_sorted = this->items.size();
+	this->items_first = std::min(this->items_first, this->items.size());
 
-	void Remove(int item)
-	{
-		if (this->IsEnd()) return;
-
-		/* If we remove the 'next' item, skip to the next */
-		if (item == this->item_next) {
-			FindNext();
-			return;
-		}
+	if (this->items_removed > 64 && this->items_removed * 2 > this->items.size()) {
+		this->items.erase(std::remove_if(this->items.begin(), this->items.end(), [](const ItemEntry &entry) { return entry.removed; }), this->items.end());
+		this->items_sorted = this->items.size();
+		this->items_first = 0;
+		this->items_removed = 0;
 	}
-};
+}
 
 /**
- * Sort by value, descending.
+ * Find the entry of an item.
+ * @param item The item to look for.
+ * @return The entry, or nullptr when the item is not in the list.
  */
-class ScriptListSorterValueDescending : public ScriptListSorter {
-private:
-	/* Note: We cannot use reverse_iterator.
-	 *       The iterators must only be invalidated when the element they are pointing to is removed.
-	 *       This only holds for forward iterators. */
-	ScriptList::ScriptListBucket::iterator bucket_iter;    ///< The iterator over the list to find the buckets.
-	ScriptList::ScriptItemList *bucket_list;               ///< The current bucket list we're iterator over.
-	ScriptList::ScriptItemList::iterator bucket_list_iter; ///< The iterator over the bucket list.
-
-public:
-	/**
-	 * Create a new sorter.
-	 * @param list The list to sort.
-	 */
-	ScriptListSorterValueDescending(ScriptList *list)
-	{
-		this->list = list;
-		this->End();
-	}
-
-	int64 Begin()
-	{
-		if (this->list->buckets.empty()) return 0;
-		this->has_no_more_items = false;
-
-		/* Go to the end of the bucket-list */
-		this->bucket_iter = this->list->buckets.end();
-		--this->bucket_iter;
-		this->bucket_list = &(*this->bucket_iter).second;
-
-		/* Go to the end of the items in the bucket */
-		this->bucket_list_iter = this->bucket_list->end();
-		--this->bucket_list_iter;
-		this->item_next = *this->bucket_list_iter;
-
-		int64 item_current = this->item_next;
-		FindNext();
-		return item_current;
-	}
-
-	void End()
-	{
-		this->bucket_list = nullptr;
-		this->has_no_more_items = true;
-		this->item_next = 0;
-	}
+ScriptList::ItemEntry *ScriptList::FindItem(int64 item)
+{
+	this->MergeAddedItems();
 
-	/**
-	 * Find the next item, and store that information.
-	 */
-	void FindNext()
-	{
-		if (this->bucket_list == nullptr) {
-			this->has_no_more_items = true;
-			return;
-		}
+	auto it = std::lower_bound(this->items.begin(), this->items.end(), item);
+	if (it == this->items.end() || it->item != item || it->removed) return nullptr;
+	return &*it;
+}
 
-		if (this->bucket_list_iter == this->bucket_list->begin()) {
-			if (this->bucket_iter == this->list->buckets.begin()) {
-				this->bucket_list = nullptr;
-				return;
-			}
-			this->bucket_iter--;
-			this->bucket_list = &(*this->bucket_iter).second;
-			/* Go to the end of the items in the bucket */
-			this->bucket_list_iter = this->bucket_list->end();
-			--this->bucket_list_iter;
-		} else {
-			this->bucket_list_iter--;
-		}
-		this->item_next = *this->bucket_list_iter;
-	}
+/**
+ * Remove the entry of an item from the list.
+ * @param entry The entry to remove.
+ * @pre All entries are sorted.
+ */
+void ScriptList::RemoveEntry(ItemEntry &entry)
+{
+	entry.removed = true;
+	this->items_removed++;
+	this->MarkValueKeyOutdated();
+
+	this->SkipRemovedNext();
+	this->CleanupRemovedItems();
+}
 
-	int64 Next()
-	{
-		if (this->IsEnd()) return 0;
+/**
+ * Change the value of an item.
+ * @param entry The entry of the item.
+ * @param value The new value.
+ */
+void ScriptList::SetEntryValue(ItemEntry &entry, int64 value)
+{
+	if (entry.value == value) return;
 
-		int64 item_current = this->item_next;
-		FindNext();
-		return item_current;
+	/* The item moves in the iteration; skip it when it is the next item. */
+	if (!this->has_no_more_items && this->has_next && this->next.second == entry.item) {
+		this->has_next = this->FindNext(this->next, this->sort_ascending);
 	}
 
-	void Remove(int item)
-	{
-		if (this->IsEnd()) return;
+	this->MarkValueKeyOutdated();
+	entry.value = value;
+	this->AddValueKey(entry.item, value);
+}
 
-		/* If we remove the 'next' item, skip to the next */
-		if (item == this->item_next) {
-			FindNext();
-			return;
-		}
-	}
-};
+/**
+ * When the next item of the iteration has been removed, move on to the item after it.
+ */
+void ScriptList::SkipRemovedNext()
+{
+	if (this->has_no_more_items || !this->has_next) return;
+	if (this->FindItem(this->next.second) != nullptr) return;
+
+	this->has_next = this->FindNext(this->next, this->sort_ascending);
+}
 
 /**
- * Sort by item, ascending.
+ * Note that a key in the value order has become outdated. When too many keys
+ * are outdated, the value order is rebuilt the next time it is needed.
  */
-class ScriptListSorterItemAscending : public ScriptListSorter {
-private:
-	ScriptList::ScriptListMap::iterator item_iter; ///< The iterator over the items in the map.
+void ScriptList::MarkValueKeyOutdated()
+{
+	if (!this->values_valid) return;
 
-public:
-	/**
-	 * Create a new sorter.
-	 * @param list The list to sort.
-	 */
-	ScriptListSorterItemAscending(ScriptList *list)
-	{
-		this->list = list;
-		this->End();
-	}
+	this->values_outdated++;
+	if (this->values_outdated * 2 > this->values.size() - this->values_first + this->values_added.size()) this->values_valid = false;
+}
 
-	int64 Begin()
-	{
-		if (this->list->items.empty()) return 0;
-		this->has_no_more_items = false;
+/**
+ * Add the key of an item to the value order, if it is kept up to date.
+ * @param item The item.
+ * @param value The value of the item.
+ */
+void ScriptList::AddValueKey(int64 item, int64 value)
+{
+	if (!this->values_valid) return;
 
-		this->item_iter = this->list->items.begin();
-		this->item_next = (*this->item_iter).first;
+	ValueKey key(value, item);
+	auto it = std::lower_bound(this->values_added.begin(), this->values_added.end(), key);
+	if (it != this->values_added.end() && *it == key) return;
+	this->values_added.insert(it, key);
 
-		int64 item_current = this->item_next;
-		FindNext();
-		return item_current;
-	}
+	if (this->values_added.size() <= GetMaxAddedValueKeys(this->values.size())) return;
 
-	void End()
-	{
-		this->has_no_more_items = true;
+	std::vector<ValueKey> merged;
+	merged.reserve(this->values.size() - this->values_first + this->values_added.size());
+	std::merge(this->values.begin() + this->values_first, this->values.end(), this->values_added.begin(), this->values_added.end(), std::back_inserter(merged));
+	merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+
+	this->values.swap(merged);
+	this->values_first = 0;
+	this->values_added.clear();
+}
+
+/**
+ * (Re)build the value order from the items in the list.
+ */
+void ScriptList::BuildValueKeys()
+{
+	this->MergeAddedItems();
+
+	this->values.clear();
+	this->values.reserve(this->items.size() - this->items_removed);
+	for (const ItemEntry &entry : this->items) {
+		if (!entry.removed) this->values.emplace_back(entry.value, entry.item);
 	}
+	std::sort(this->values.begin(), this->values.end());
+
+	this->values_first = 0;
+	this->values_added.clear();
+	this->values_outdated = 0;
+	this->values_valid = true;
+}
 
-	/**
-	 * Find the next item, and store that information.
-	 */
-	void FindNext()
-	{
-		if (this->item_iter == this->list->items.end()) {
-			this->has_no_more_items = true;
-			return;
+/**
+ * Check whether a key of the value order still belongs to an item in the list.
+ * @param key The key to check.
+ * @return True iff the item is in the list and has the value of the key.
+ */
+bool ScriptList::IsValidValueKey(const ValueKey &key)
+{
+	const ItemEntry *entry = this->FindItem(key.second);
+	return entry != nullptr && entry->value == key.first;
+}
+
+/**
+ * Find the first item in the current sort type.
+ * @param[out] key The value and item of the first item.
+ * @param ascending Whether to find the first item in ascending or descending order.
+ * @return True iff the list has any item.
+ */
+bool ScriptList::FindFirst(ValueKey &key, bool ascending)
+{
+	if (this->sorter_type == SORT_BY_ITEM) {
+		this->MergeAddedItems();
+
+		if (ascending) {
+			while (this->items_first < this->items.size() && this->items[this->items_first].removed) this->items_first++;
+			if (this->items_first == this->items.size()) return false;
+			key = ValueKey(this->items[this->items_first].value, this->items[this->items_first].item);
+			return true;
 		}
-		this->item_iter++;
-		if (this->item_iter != this->list->items.end()) item_next = (*this->item_iter).first;
+
+		for (auto it = this->items.rbegin(); it != this->items.rend(); ++it) {
+			if (it->removed) continue;
+			key = ValueKey(it->value, it->item);
+			return true;
+		}
+		return false;
 	}
 
-	int64 Next()
-	{
-		if (this->IsEnd()) return 0;
+	if (!this->values_valid) this->BuildValueKeys();
+
+	/* Outdated keys never become valid again, as changing an item back adds its key again. */
+	if (ascending) {
+		while (this->values_first < this->values.size() && !this->IsValidValueKey(this->values[this->values_first])) this->values_first++;
+		while (!this->values_added.empty() && !this->IsValidValueKey(this->values_added.front())) this->values_added.erase(this->values_added.begin());
 
-		int64 item_current = this->item_next;
-		FindNext();
-		return item_current;
+		bool found = this->values_first < this->values.size();
+		if (found) key = this->values[this->values_first];
+		if (!this->values_added.empty() && (!found || this->values_added.front() < key)) {
+			key = this->values_added.front();
+			found = true;
+		}
+		return found;
 	}
 
-	void Remove(int item)
-	{
-		if (this->IsEnd()) return;
+	while (this->values.size() > this->values_first && !this->IsValidValueKey(this->values.back())) this->values.pop_back();
+	while (!this->values_added.empty() && !this->IsValidValueKey(this->values_added.back())) this->values_added.pop_back();
 
-		/* If we remove the 'next' item, skip to the next */
-		if (item == this->item_next) {
-			FindNext();
-			return;
-		}
+	bool found = this->values.size() > this->values_first;
+	if (found) key = this->values.back();
+	if (!this->values_added.empty() && (!found || key < this->values_added.back())) {
+		key = this->values_added.back();
+		found = true;
 	}
-};
+	return found;
+}
 
 /**
- * Sort by item, descending.
+ * Find the item after the given item in the current sort type.
+ * @param[in,out] key The value and item to find the next item of; the value and item of the next item.
+ * @param ascending Whether to find the next item in ascending or descending order.
+ * @return True iff there is an item after the given item.
  */
-class ScriptListSorterItemDescending : public ScriptListSorter {
-private:
-	/* Note: We cannot use reverse_iterator.
-	 *       The iterators must only be invalidated when the element they are pointing to is removed.
-	 *       This only holds for forward iterators. */
-	ScriptList::ScriptListMap::iterator item_iter; ///< The iterator over the items in the map.
-
-public:
-	/**
-	 * Create a new sorter.
-	 * @param list The list to sort.
-	 */
-	ScriptListSorterItemDescending(ScriptList *list)
-	{
-		this->list = list;
-		this->End();
-	}
-
-	int64 Begin()
-	{
-		if (this->list->items.empty()) return 0;
-		this->has_no_more_items = false;
-
-		this->item_iter = this->list->items.end();
-		--this->item_iter;
-		this->item_next = (*this->item_iter).first;
-
-		int64 item_current = this->item_next;
-		FindNext();
-		return item_current;
-	}
-
-	void End()
-	{
-		this->has_no_more_items = true;
-	}
+bool ScriptList::FindNext(ValueKey &key, bool ascending)
+{
+	if (this->sorter_type == SORT_BY_ITEM) {
+		this->MergeAddedItems();
 
-	/**
-	 * Find the next item, and store that information.
-	 */
-	void FindNext()
-	{
-		if (this->item_iter == this->list->items.end()) {
-			this->has_no_more_items = true;
-			return;
+		if (ascending) {
+			auto it = std::upper_bound(this->items.begin(), this->items.end(), key.second, [](int64 item, const ItemEntry &entry) { return item < entry.item; });
+			for (; it != this->items.end(); ++it) {
+				if (it->removed) continue;
+				key = ValueKey(it->value, it->item);
+				return true;
+			}
+			return false;
 		}
-		if (this->item_iter == this->list->items.begin()) {
-			/* Use 'end' as marker for 'beyond begin' */
-			this->item_iter = this->list->items.end();
-		} else {
-			this->item_iter--;
+
+		auto it = std::lower_bound(this->items.begin(), this->items.end(), key.second);
+		while (it != this->items.begin()) {
+			--it;
+			if (it->removed) continue;
+			key = ValueKey(it->value, it->item);
+			return true;
 		}
-		if (this->item_iter != this->list->items.end()) item_next = (*this->item_iter).first;
+		return false;
 	}
 
-	int64 Next()
-	{
-		if (this->IsEnd()) return 0;
+	if (!this->values_valid) this->BuildValueKeys();
 
-		int64 item_current = this->item_next;
-		FindNext();
-		return item_current;
-	}
+	bool found = false;
+	ValueKey result;
+	if (ascending) {
+		auto it = std::upper_bound(this->values.begin() + this->values_first, this->values.end(), key);
+		while (it != this->values.end() && !this->IsValidValueKey(*it)) ++it;
+		if (it != this->values.end()) {
+			result = *it;
+			found = true;
+		}
 
-	void Remove(int item)
-	{
-		if (this->IsEnd()) return;
+		auto added = std::upper_bound(this->values_added.begin(), this->values_added.end(), key);
+		while (added != this->values_added.end() && !this->IsValidValueKey(*added)) ++added;
+		if (added != this->values_added.end() && (!found || *added < result)) {
+			result = *added;
+			found = true;
+		}
+	} else {
+		auto first = this->values.begin() + this->values_first;
+		auto it = std::lower_bound(first, this->values.end(), key);
+		while (it != first) {
+			--it;
+			if (!this->IsValidValueKey(*it)) continue;
+			result = *it;
+			found = true;
+			break;
+		}
 
-		/* If we remove the 'next' item, skip to the next */
-		if (item == this->item_next) {
-			FindNext();
-			return;
+		auto added = std::lower_bound(this->values_added.begin(), this->values_added.end(), key);
+		while (added != this->values_added.begin()) {
+			--added;
+			if (!this->IsValidValueKey(*added)) continue;
+			if (!found || result < *added) {
+				result = *added;
+				found = true;
+			}
+			break;
 		}
 	}
-};
 
+	if (found) key = result;
+	return found;
+}
+
+/**
+ * Remove all items of which the value matches.
+ * @param remove Whether to remove an item with the given value.
+ * @param a The first parameter for \a remove.
+ * @param b The second parameter for \a remove.
+ */
+void ScriptList::RemoveIf(bool (*remove)(int64 value, int64 a, int64 b), int64 a, int64 b)
+{
+	this->MergeAddedItems();
+
+	for (ItemEntry &entry : this->items) {
+		if (entry.removed || !remove(entry.value, a, b)) continue;
+
+		entry.removed = true;
+		this->items_removed++;
+		this->MarkValueKeyOutdated();
+	}
+
+	this->SkipRemovedNext();
+	this->CleanupRemovedItems();
+}
 
+/**
+ * Remove items from the start of the list.
+ * @param count The number of items to remove.
+ * @param ascending Whether the start is that of the list in ascending or descending order.
+ */
+void ScriptList::RemoveFromStart(int32 count, bool ascending)
+{
+	ValueKey key;
+	bool found = this->FindFirst(key, ascending);
+	while (found && count-- > 0) {
+		int64 item = key.second;
+		found = this->FindNext(key, ascending);
+		this->RemoveItem(item);
+	}
+}
 
-ScriptList::ScriptList()
+/**
+ * Get all items in the list, for natively valuating them.
+ * @return The items, sorted ascending.
+ */
+std::vector<int64> ScriptList::GetItems()
 {
-	/* Default sorter */
-	this->sorter         = new ScriptListSorterValueDescending(this);
-	this->sorter_type    = SORT_BY_VALUE;
-	this->sort_ascending = false;
-	this->initialized    = false;
-	this->modifications  = 0;
+	this->MergeAddedItems();
+
+	std::vector<int64> result;
+	result.reserve(this->items.size() - this->items_removed);
+	for (size_t i = this->items_first; i < this->items.size(); i++) {
+		if (!this->items[i].removed) result.push_back(this->items[i].item);
+	}
+	return result;
 }
 
-ScriptList::~ScriptList()
+/**
+ * Set the values of all items, like #Valuate does with a native valuator.
+ * Charges the script #NATIVE_VALUATOR_OPS opcodes per item.
+ * @param values The new values, in the order of #GetItems.
+ * @pre The list did not change since #GetItems.
+ */
+void ScriptList::SetValues(const std::vector<int64> &values)
 {
-	delete this->sorter;
+	ScriptObject::DecreaseOps((int)std::min<size_t>(values.size() * NATIVE_VALUATOR_OPS, INT_MAX));
+
+	this->modifications++;
+	this->values_valid = false;
+
+	size_t index = 0;
+	for (size_t i = this->items_first; i < this->items.size(); i++) {
+		if (this->items[i].removed) continue;
+		this->SetEntryValue(this->items[i], values[index++]);
+	}
+	assert(index == values.size());
 }
 
 bool ScriptList::HasItem(int64 item)
 {
-	return this->items.count(item) == 1;
+	return this->FindItem(item) != nullptr;
 }
 
 void ScriptList::Clear()
@@ -429,41 +451,56 @@ void ScriptList::Clear()
 	this->modifications++;
 
 	this->items.clear();
-	this->buckets.clear();
-	this->sorter->End();
+	this->items_sorted  = 0;
+	this->items_first   = 0;
+	this->items_removed = 0;
+	this->values.clear();
+	this->values_added.clear();
+	this->values_first    = 0;
+	this->values_outdated = 0;
+	this->values_valid    = false;
+	this->has_no_more_items = true;
+	this->has_next          = false;
 }
 
 void ScriptList::AddItem(int64 item, int64 value)
 {
 	this->modifications++;
 
-	if (this->HasItem(item)) return;
+	/* Items are mostly added in ascending order; those go directly to the sorted
+	 * entries. The others are merged, and duplicates dropped, when they are needed. */
+	bool sorted = this->items_sorted == this->items.size() && (this->items.empty() || this->items.back().item < item);
+	this->items.push_back({item, value, false});
+	if (sorted) this->items_sorted++;
 
-	this->items[item] = value;
-	this->buckets[value].insert(item);
+	this->AddValueKey(item, value);
 }
 
 void ScriptList::RemoveItem(int64 item)
 {
 	this->modifications++;
 
-	ScriptListMap::iterator item_iter = this->items.find(item);
-	if (item_iter == this->items.end()) return;
-
-	int64 value = item_iter->second;
+	ItemEntry *entry = this->FindItem(item);
+	if (entry == nullptr) return;
 
-	this->sorter->Remove(item);
-	ScriptListBucket::iterator bucket_iter = this->buckets.find(value);
-	assert(bucket_iter != this->buckets.end());
-	bucket_iter->second.erase(item);
-	if (bucket_iter->second.empty()) this->buckets.erase(bucket_iter);
-	this->items.erase(item_iter);
+	this->RemoveEntry(*entry);
 }
 
 int64 ScriptList::Begin()
 {
 	this->initialized = true;
-	return this->sorter->Begin();
+
+	ValueKey first;
+	if (!this->FindFirst(first, this->sort_ascending)) {
+		this->has_no_more_items = true;
+		this->has_next = false;
+		return 0;
+	}
+
+	this->has_no_more_items = false;
+	this->next = first;
+	this->has_next = this->FindNext(this->next, this->sort_ascending);
+	return first.second;
 }
 
 int64 ScriptList::Next()
@@ -472,12 +509,22 @@ int64 ScriptList::Next()
 		Debug(script, 0, "Next() is invalid as Begin() is never called");
 		return 0;
 	}
-	return this->sorter->Next();
+	if (this->IsEnd()) return 0;
+
+	if (!this->has_next) {
+		this->has_no_more_items = true;
+		return 0;
+	}
+
+	ValueKey current = this->next;
+	this->has_next = this->FindNext(this->next, this->sort_ascending);
+	return current.second;
 }
 
 bool ScriptList::IsEmpty()
 {
-	return this->items.empty();
+	/* Entries that are not sorted yet are never removed, so they always hold an item. */
+	return this->items.size() == this->items_removed;
 }
 
 bool ScriptList::IsEnd()
@@ -486,38 +533,29 @@ bool ScriptList::IsEnd()
 		Debug(script, 0, "IsEnd() is invalid as Begin() is never called");
 		return true;
 	}
-	return this->sorter->IsEnd();
+	return this->IsEmpty() || this->has_no_more_items;
 }
 
 int32 ScriptList::Count()
 {
-	return (int32)this->items.size();
+	this->MergeAddedItems();
+	return (int32)(this->items.size() - this->items_removed);
 }
 
 int64 ScriptList::GetValue(int64 item)
 {
-	ScriptListMap::const_iterator item_iter = this->items.find(item);
-	return item_iter == this->items.end() ? 0 : item_iter->second;
+	const ItemEntry *entry = this->FindItem(item);
+	return entry == nullptr ? 0 : entry->value;
 }
 
 bool ScriptList::SetValue(int64 item, int64 value)
 {
 	this->modifications++;
 
-	ScriptListMap::iterator item_iter = this->items.find(item);
-	if (item_iter == this->items.end()) return false;
-
-	int64 value_old = item_iter->second;
-	if (value_old == value) return true;
-
-	this->sorter->Remove(item);
-	ScriptListBucket::iterator bucket_iter = this->buckets.find(value_old);
-	assert(bucket_iter != this->buckets.end());
-	bucket_iter->second.erase(item);
-	if (bucket_iter->second.empty()) this->buckets.erase(bucket_iter);
-	item_iter->second = value;
-	this->buckets[value].insert(item);
+	ItemEntry *entry = this->FindItem(item);
+	if (entry == nullptr) return false;
 
+	this->SetEntryValue(*entry, value);
 	return true;
 }
 
@@ -528,46 +566,61 @@ void ScriptList::Sort(SorterType sorter, bool ascending)
 	if (sorter != SORT_BY_VALUE && sorter != SORT_BY_ITEM) return;
 	if (sorter == this->sorter_type && ascending == this->sort_ascending) return;
 
-	delete this->sorter;
-	switch (sorter) {
-		case SORT_BY_ITEM:
-			if (ascending) {
-				this->sorter = new ScriptListSorterItemAscending(this);
-			} else {
-				this->sorter = new ScriptListSorterItemDescending(this);
-			}
-			break;
-
-		case SORT_BY_VALUE:
-			if (ascending) {
-				this->sorter = new ScriptListSorterValueAscending(this);
-			} else {
-				this->sorter = new ScriptListSorterValueDescending(this);
-			}
-			break;
-
-		default: NOT_REACHED();
-	}
+	/* The order itself is only (re)built when iterating. */
 	this->sorter_type    = sorter;
 	this->sort_ascending = ascending;
 	this->initialized    = false;
+	this->has_no_more_items = true;
+	this->has_next          = false;
 }
 
 void ScriptList::AddList(ScriptList *list)
 {
 	if (list == this) return;
 
+	list->MergeAddedItems();
+	this->MergeAddedItems();
+	this->modifications++;
+
 	if (this->IsEmpty()) {
 		/* If this is empty, we can just take the items of the other list as is. */
-		this->items = list->items;
-		this->buckets = list->buckets;
-		this->modifications++;
-	} else {
-		ScriptListMap *list_items = &list->items;
-		for (ScriptListMap::iterator iter = list_items->begin(); iter != list_items->end(); iter++) {
-			this->AddItem((*iter).first);
-			this->SetValue((*iter).first, (*iter).second);
+		this->items.clear();
+		for (const ItemEntry &entry : list->items) {
+			if (!entry.removed) this->items.push_back(entry);
+		}
+		this->items_sorted  = this->items.size();
+		this->items_first   = 0;
+		this->items_removed = 0;
+		this->values_valid  = false;
+		return;
+	}
+
+	/* Merge both lists; the values of the other list win. */
+	std::vector<ItemEntry> merged;
+	merged.reserve(this->items.size() - this->items_removed + list->items.size() - list->items_removed);
+	auto it = this->items.begin();
+	for (const ItemEntry &entry : list->items) {
+		if (entry.removed) continue;
+		for (; it != this->items.end() && it->item < entry.item; ++it) {
+			if (!it->removed) merged.push_back(*it);
 		}
+		if (it != this->items.end() && it->item == entry.item) ++it;
+		merged.push_back(entry);
+	}
+	for (; it != this->items.end(); ++it) {
+		if (!it->removed) merged.push_back(*it);
+	}
+
+	this->items.swap(merged);
+	this->items_sorted  = this->items.size();
+	this->items_first   = 0;
+	this->items_removed = 0;
+	this->values_valid  = false;
+
+	/* Like for SetValue, skip the next item of the iteration when its value changed. */
+	if (!this->has_no_more_items && this->has_next) {
+		const ItemEntry *entry = this->FindItem(this->next.second);
+		if (entry == nullptr || entry->value != this->next.first) this->has_next = this->FindNext(this->next, this->sort_ascending);
 	}
 }
 
@@ -576,54 +629,49 @@ void ScriptList::SwapList(ScriptList *list)
 	if (list == this) return;
 
 	this->items.swap(list->items);
-	this->buckets.swap(list->buckets);
-	Swap(this->sorter, list->sorter);
+	Swap(this->items_sorted, list->items_sorted);
+	Swap(this->items_first, list->items_first);
+	Swap(this->items_removed, list->items_removed);
+	this->values.swap(list->values);
+	Swap(this->values_first, list->values_first);
+	this->values_added.swap(list->values_added);
+	Swap(this->values_outdated, list->values_outdated);
+	Swap(this->values_valid, list->values_valid);
 	Swap(this->sorter_type, list->sorter_type);
 	Swap(this->sort_ascending, list->sort_ascending);
 	Swap(this->initialized, list->initialized);
 	Swap(this->modifications, list->modifications);
-	this->sorter->Retarget(this);
-	list->sorter->Retarget(list);
+	Swap(this->has_no_more_items, list->has_no_more_items);
+	Swap(this->has_next, list->has_next);
+	Swap(this->next, list->next);
 }
 
 void ScriptList::RemoveAboveValue(int64 value)
 {
 	this->modifications++;
 
-	for (ScriptListMap::iterator next_iter, iter = this->items.begin(); iter != this->items.end(); iter = next_iter) {
-		next_iter = iter; next_iter++;
-		if ((*iter).second > value) this->RemoveItem((*iter).first);
-	}
+	this->RemoveIf([](int64 v, int64 a, int64 b) { return v > a; }, value, 0);
 }
 
 void ScriptList::RemoveBelowValue(int64 value)
 {
 	this->modifications++;
 
-	for (ScriptListMap::iterator next_iter, iter = this->items.begin(); iter != this->items.end(); iter = next_iter) {
-		next_iter = iter; next_iter++;
-		if ((*iter).second < value) this->RemoveItem((*iter).first);
-	}
+	this->RemoveIf([](int64 v, int64 a, int64 b) { return v < a; }, value, 0);
 }
 
 void ScriptList::RemoveBetweenValue(int64 start, int64 end)
 {
 	this->modifications++;
 
-	for (ScriptListMap::iterator next_iter, iter = this->items.begin(); iter != this->items.end(); iter = next_iter) {
-		next_iter = iter; next_iter++;
-		if ((*iter).second > start && (*iter).second < end) this->RemoveItem((*iter).first);
-	}
+	this->RemoveIf([](int64 v, int64 a, int64 b) { return v > a && v < b; }, start, end);
 }
 
 void ScriptList::RemoveValue(int64 value)
 {
 	this->modifications++;
 
-	for (ScriptListMap::iterator next_iter, iter = this->items.begin(); iter != this->items.end(); iter = next_iter) {
-		next_iter = iter; next_iter++;
-		if ((*iter).second == value) this->RemoveItem((*iter).first);
-	}
+	this->RemoveIf([](int64 v, int64 a, int64 b) { return v == a; }, value, 0);
 }
 
 void ScriptList::RemoveTop(int32 count)
@@ -631,36 +679,13 @@ void ScriptList::RemoveTop(int32 count)
 	this->modifications++;
 
 	if (!this->sort_ascending) {
-		this->Sort(this->sorter_type, !this->sort_ascending);
-		this->RemoveBottom(count);
-		this->Sort(this->sorter_type, !this->sort_ascending);
-		return;
+		/* Removing from a descending list used to flip the sorter twice, which ends the iteration. */
+		this->initialized       = false;
+		this->has_no_more_items = true;
+		this->has_next          = false;
 	}
 
-	switch (this->sorter_type) {
-		default: NOT_REACHED();
-		case SORT_BY_VALUE:
-			for (ScriptListBucket::iterator iter = this->buckets.begin(); iter != this->buckets.end(); iter = this->buckets.begin()) {
-				ScriptItemList *items = &(*iter).second;
-				size_t size = items->size();
-				for (ScriptItemList::iterator iter = items->begin(); iter != items->end(); iter = items->begin()) {
-					if (--count < 0) return;
-					this->RemoveItem(*iter);
-					/* When the last item is removed from the bucket, the bucket itself is removed.
-					 * This means that the iterators can be invalid after a call to RemoveItem.
-					 */
-					if (--size == 0) break;
-				}
-			}
-			break;
-
-		case SORT_BY_ITEM:
-			for (ScriptListMap::iterator iter = this->items.begin(); iter != this->items.end(); iter = this->items.begin()) {
-				if (--count < 0) return;
-				this->RemoveItem((*iter).first);
-			}
-			break;
-	}
+	this->RemoveFromStart(count, this->sort_ascending);
 }
 
 void ScriptList::RemoveBottom(int32 count)
@@ -668,36 +693,13 @@ void ScriptList::RemoveBottom(int32 count)
 	this->modifications++;
 
 	if (!this->sort_ascending) {
-		this->Sort(this->sorter_type, !this->sort_ascending);
-		this->RemoveTop(count);
-		this->Sort(this->sorter_type, !this->sort_ascending);
-		return;
+		/* Removing from a descending list used to flip the sorter twice, which ends the iteration. */
+		this->initialized       = false;
+		this->has_no_more_items = true;
+		this->has_next          = false;
 	}
 
-	switch (this->sorter_type) {
-		default: NOT_REACHED();
-		case SORT_BY_VALUE:
-			for (ScriptListBucket::reverse_iterator iter = this->buckets.rbegin(); iter != this->buckets.rend(); iter = this->buckets.rbegin()) {
-				ScriptItemList *items = &(*iter).second;
-				size_t size = items->size();
-				for (ScriptItemList::reverse_iterator iter = items->rbegin(); iter != items->rend(); iter = items->rbegin()) {
-					if (--count < 0) return;
-					this->RemoveItem(*iter);
-					/* When the last item is removed from the bucket, the bucket itself is removed.
-					 * This means that the iterators can be invalid after a call to RemoveItem.
-					 */
-					if (--size == 0) break;
-				}
-			}
-			break;
-
-		case SORT_BY_ITEM:
-			for (ScriptListMap::reverse_iterator iter = this->items.rbegin(); iter != this->items.rend(); iter = this->items.rbegin()) {
-				if (--count < 0) return;
-				this->RemoveItem((*iter).first);
-			}
-			break;
-	}
+	this->RemoveFromStart(count, !this->sort_ascending);
 }
 
 void ScriptList::RemoveList(ScriptList *list)
@@ -706,52 +708,54 @@ void ScriptList::RemoveList(ScriptList *list)
 
 	if (list == this) {
 		Clear();
-	} else {
-		ScriptListMap *list_items = &list->items;
-		for (ScriptListMap::iterator iter = list_items->begin(); iter != list_items->end(); iter++) {
-			this->RemoveItem((*iter).first);
-		}
+		return;
+	}
+
+	list->MergeAddedItems();
+	this->MergeAddedItems();
+
+	auto it = this->items.begin();
+	for (const ItemEntry &entry : list->items) {
+		if (entry.removed) continue;
+		it = std::lower_bound(it, this->items.end(), entry.item);
+		if (it == this->items.end()) break;
+		if (it->item != entry.item || it->removed) continue;
+
+		it->removed = true;
+		this->items_removed++;
+		this->MarkValueKeyOutdated();
 	}
+
+	this->SkipRemovedNext();
+	this->CleanupRemovedItems();
 }
 
 void ScriptList::KeepAboveValue(int64 value)
 {
 	this->modifications++;
 
-	for (ScriptListMap::iterator next_iter, iter = this->items.begin(); iter != this->items.end(); iter = next_iter) {
-		next_iter = iter; next_iter++;
-		if ((*iter).second <= value) this->RemoveItem((*iter).first);
-	}
+	this->RemoveIf([](int64 v, int64 a, int64 b) { return v <= a; }, value, 0);
 }
 
 void ScriptList::KeepBelowValue(int64 value)
 {
 	this->modifications++;
 
-	for (ScriptListMap::iterator next_iter, iter = this->items.begin(); iter != this->items.end(); iter = next_iter) {
-		next_iter = iter; next_iter++;
-		if ((*iter).second >= value) this->RemoveItem((*iter).first);
-	}
+	this->RemoveIf([](int64 v, int64 a, int64 b) { return v >= a; }, value, 0);
 }
 
 void ScriptList::KeepBetweenValue(int64 start, int64 end)
 {
 	this->modifications++;
 
-	for (ScriptListMap::iterator next_iter, iter = this->items.begin(); iter != this->items.end(); iter = next_iter) {
-		next_iter = iter; next_iter++;
-		if ((*iter).second <= start || (*iter).second >= end) this->RemoveItem((*iter).first);
-	}
+	this->RemoveIf([](int64 v, int64 a, int64 b) { return v <= a || v >= b; }, start, end);
 }
 
 void ScriptList::KeepValue(int64 value)
 {
 	this->modifications++;
 
-	for (ScriptListMap::iterator next_iter, iter = this->items.begin(); iter != this->items.end(); iter = next_iter) {
-		next_iter = iter; next_iter++;
-		if ((*iter).second != value) this->RemoveItem((*iter).first);
-	}
+	this->RemoveIf([](int64 v, int64 a, int64 b) { return v != a; }, value, 0);
 }
 
 void ScriptList::KeepTop(int32 count)
@@ -774,10 +778,22 @@ void ScriptList::KeepList(ScriptList *list)
 
 	this->modifications++;
 
-	ScriptList tmp;
-	tmp.AddList(this);
-	tmp.RemoveList(list);
-	this->RemoveList(&tmp);
+	list->MergeAddedItems();
+	this->MergeAddedItems();
+
+	auto it = list->items.begin();
+	for (ItemEntry &entry : this->items) {
+		if (entry.removed) continue;
+		it = std::lower_bound(it, list->items.end(), entry.item);
+		if (it != list->items.end() && it->item == entry.item && !it->removed) continue;
+
+		entry.removed = true;
+		this->items_removed++;
+		this->MarkValueKeyOutdated();
+	}
+
+	this->SkipRemovedNext();
+	this->CleanupRemovedItems();
 }
 
 SQInteger ScriptList::_get(HSQUIRRELVM vm)
@@ -787,10 +803,10 @@ SQInteger ScriptList::_get(HSQUIRRELVM vm)
 	SQInteger idx;
 	sq_getinteger(vm, 2, &idx);
 
-	ScriptListMap::const_iterator item_iter = this->items.find(idx);
-	if (item_iter == this->items.end()) return SQ_ERROR;
+	const ItemEntry *entry = this->FindItem(idx);
+	if (entry == nullptr) return SQ_ERROR;
 
-	sq_pushinteger(vm, item_iter->second);
+	sq_pushinteger(vm, entry->value);
 	return 1;
 }
 
@@ -869,14 +885,21 @@ SQInteger ScriptList::Valuate(HSQUIRRELVM vm)
 	/* Push the function to call */
 	sq_push(vm, 2);
 
-	for (ScriptListMap::iterator iter = this->items.begin(); iter != this->items.end(); iter++) {
+	/* Values are written directly; the value order is rebuilt once when it is needed. */
+	this->MergeAddedItems();
+	this->values_valid = false;
+
+	for (size_t index = 0; index < this->items.size(); index++) {
+		if (this->items[index].removed) continue;
+		int64 item = this->items[index].item;
+
 		/* Check for changing of items. */
 		int previous_modification_count = this->modifications;
 
 		/* Push the root table as instance object, this is what squirrel does for meta-functions. */
 		sq_pushroottable(vm);
 		/* Push all arguments for the valuator function. */
-		sq_pushinteger(vm, (*iter).first);
+		sq_pushinteger(vm, item);
 		for (int i = 0; i < nparam - 1; i++) {
 			sq_push(vm, i + 3);
 		}
@@ -930,7 +953,7 @@ SQInteger ScriptList::Valuate(HSQUIRRELVM vm)
 			return sq_throwerror(vm, "modifying valuated list outside of valuator function");
 		}
 
-		this->SetValue((*iter).first, value);
+		this->SetEntryValue(this->items[index], value);
 
 		/* Pop the return value. */
 		sq_poptop(vm);
@@ -12,10 +12,7 @@
 #define SCRIPT_LIST_HPP
 
 #include "script_object.hpp"
-#include <map>
-#include <set>
-
-class ScriptListSorter;
+#include <vector>
 
 /**
  * Class that creates a list which can keep item/value pairs, which you can walk.
@@ -35,20 +32,59 @@ public:
 	static const bool SORT_DESCENDING = false;
 
 private:
-	ScriptListSorter *sorter;     ///< Sorting algorithm
+	/** An item in the list together with its value. */
+	struct ItemEntry {
+		int64 item;   ///< The item.
+		int64 value;  ///< The value of the item.
+		bool removed; ///< Whether the item has been removed, while its entry is not cleaned up yet.
+
+		bool operator <(const ItemEntry &other) const { return this->item < other.item; }
+		bool operator <(int64 other) const { return this->item < other; }
+	};
+
+	/** The value of an item followed by the item; the sort key when sorting by value. */
+	typedef std::pair<int64, int64> ValueKey;
+
+	std::vector<ItemEntry> items;       ///< The first #items_sorted entries sorted by item, followed by the entries added since then.
+	size_t items_sorted;                ///< Number of entries at the start of #items that are sorted by item.
+	size_t items_first;                 ///< All sorted entries before this index are removed.
+	size_t items_removed;               ///< Number of removed entries among the sorted entries.
+	std::vector<ValueKey> values;       ///< Sorted keys of the items when sorting by value; may contain outdated keys, which are skipped.
+	size_t values_first;                ///< All keys in #values before this index are outdated.
+	std::vector<ValueKey> values_added; ///< Sorted keys of the items added or changed since #values was built.
+	size_t values_outdated;             ///< Number of keys that became outdated since #values was built.
+	bool values_valid;                  ///< Whether #values and #values_added together have the keys of all items.
+
 	SorterType sorter_type;       ///< Sorting type
 	bool sort_ascending;          ///< Whether to sort ascending or descending
 	bool initialized;             ///< Whether an iteration has been started
 	int modifications;            ///< Number of modification that has been done. To prevent changing data while valuating.
+	bool has_no_more_items;       ///< Whether the iteration has passed the last item.
+	bool has_next;                ///< Whether the iteration has an item after the current one.
+	ValueKey next;                ///< Value and item of the next item of the iteration.
+
+	void MergeAddedItems();
+	void CleanupRemovedItems();
+	ItemEntry *FindItem(int64 item);
+	void RemoveEntry(ItemEntry &entry);
+	void SetEntryValue(ItemEntry &entry, int64 value);
+	void SkipRemovedNext();
+	void MarkValueKeyOutdated();
+	void AddValueKey(int64 item, int64 value);
+	void BuildValueKeys();
+	bool IsValidValueKey(const ValueKey &key);
+	bool FindFirst(ValueKey &key, bool ascending);
+	bool FindNext(ValueKey &key, bool ascending);
+	void RemoveIf(bool (*remove)(int64 value, int64 a, int64 b), int64 a, int64 b);
+	void RemoveFromStart(int32 count, bool ascending);
+
+protected:
+	static const int NATIVE_VALUATOR_OPS = 5; ///< Opcodes charged per item for natively filtering or valuating it, as #Valuate charges per item.
+
+	std::vector<int64> GetItems();
+	void SetValues(const std::vector<int64> &values);
 
 public:
-	typedef std::set<int64> ScriptItemList;                   ///< The list of items inside the bucket
-	typedef std::map<int64, ScriptItemList> ScriptListBucket; ///< The bucket list per value
-	typedef std::map<int64, int64> ScriptListMap;             ///< List per item
-
-	ScriptListMap items;           ///< The items in the list
-	ScriptListBucket buckets;      ///< The items in the list, sorted by value
-
 	ScriptList();
 	~ScriptList();
 
@@ -20,6 +20,7 @@
 #include "../script_storage.hpp"
 #include "../script_instance.hpp"
 #include "../script_fatalerror.hpp"
+#include "../script_thread.hpp"
 #include "script_error.hpp"
 #include "../../debug.h"
 
@@ -35,7 +36,7 @@ static ScriptStorage *GetStorage()
 }
 
 
-/* static */ ScriptInstance *ScriptObject::ActiveInstance::active = nullptr;
+/* static */ thread_local ScriptInstance *ScriptObject::ActiveInstance::active = nullptr;
 
 ScriptObject::ActiveInstance::ActiveInstance(ScriptInstance *instance) : alc_scope(instance->engine)
 {
@@ -210,6 +211,11 @@ ScriptObject::ActiveInstance::~ActiveInstance()
 	return GetStorage()->allow_do_command && squirrel->CanSuspend();
 }
 
+/* static */ void ScriptObject::DecreaseOps(int ops)
+{
+	Squirrel::DecreaseOps(ScriptObject::GetActiveInstance()->engine->GetVM(), ops);
+}
+
 /* static */ void *&ScriptObject::GetEventPointer()
 {
 	return GetStorage()->event_data;
@@ -253,6 +259,12 @@ std::tuple<bool, bool, bool> ScriptObject::DoCommandPrep()
 	/* Are we only interested in the estimate costs? */
 	bool estimate_only = GetDoCommandMode() != nullptr && !GetDoCommandMode()();
 
+	/* When running on a worker thread, commands are executed one script at a time in company order; estimates do not change anything. */
+	if (!estimate_only && !ScriptWaitForCommandTurn(ScriptObject::GetActiveInstance())) {
+		/* The company of this script was removed while waiting; stop running the script, its instance is deleted soon. */
+		throw Script_Suspend(0, nullptr);
+	}
+
 	bool networking = _networking && !_generating_world;
 
 	if (ScriptObject::GetCompany() != OWNER_DEITY && !::Company::IsValidID(ScriptObject::GetCompany())) {
@@ -51,7 +51,7 @@ protected:
 		ScriptInstance *last_active;    ///< The active instance before we go instantiated.
 		ScriptAllocatorScope alc_scope; ///< Keep the correct allocator for the script instance activated
 
-		static ScriptInstance *active;  ///< The global current active instance.
+		static thread_local ScriptInstance *active; ///< The current active instance of this thread.
 	};
 
 public:
@@ -253,6 +253,12 @@ protected:
 	 */
 	static bool CanSuspend();
 
+	/**
+	 * Charge the script for work done natively on its behalf, as if it ran opcodes.
+	 * @param ops The number of opcodes to charge.
+	 */
+	static void DecreaseOps(int ops);
+
 	/**
 	 * Get the pointer to store event data in.
 	 */
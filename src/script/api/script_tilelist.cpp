@@ -10,8 +10,11 @@
 #include "../../stdafx.h"
 #include "script_tilelist.hpp"
 #include "script_industry.hpp"
+#include "script_cargo.hpp"
+#include "script_tile.hpp"
 #include "../../industry.h"
 #include "../../station_base.h"
+#include "../../station_func.h"
 
 #include "../../safeguards.h"
 
@@ -47,6 +50,157 @@ void ScriptTileList::RemoveTile(TileIndex tile)
 	this->RemoveItem(tile);
 }
 
+/**
+ * Check whether a tile has all properties of a filter.
+ * @param tile The tile to check.
+ * @param filter The properties the tile needs to have.
+ * @return True iff the tile matches the filter.
+ */
+static bool MatchesTileFilter(TileIndex tile, ScriptTileList::TileFilter filter)
+{
+	if ((filter & ScriptTileList::TF_BUILDABLE) != 0 && !ScriptTile::IsBuildable(tile)) return false;
+	if ((filter & ScriptTileList::TF_FLAT) != 0 && ScriptTile::GetSlope(tile) != ScriptTile::SLOPE_FLAT) return false;
+	if ((filter & ScriptTileList::TF_WATER) != 0 && !ScriptTile::IsWaterTile(tile)) return false;
+	if ((filter & ScriptTileList::TF_COAST) != 0 && !ScriptTile::IsCoastTile(tile)) return false;
+	if ((filter & ScriptTileList::TF_TREES) != 0 && !ScriptTile::HasTreeOnTile(tile)) return false;
+	if ((filter & ScriptTileList::TF_DESERT) != 0 && !ScriptTile::IsDesertTile(tile)) return false;
+	if ((filter & ScriptTileList::TF_SNOW) != 0 && !ScriptTile::IsSnowTile(tile)) return false;
+	if ((filter & ScriptTileList::TF_NOT_OWNED) != 0 && ScriptTile::GetOwner(tile) != ScriptCompany::COMPANY_INVALID) return false;
+	return true;
+}
+
+void ScriptTileList::AddFilteredRectangle(TileIndex t1, TileIndex t2, TileFilter filter)
+{
+	if (!::IsValidTile(t1)) return;
+	if (!::IsValidTile(t2)) return;
+
+	TileArea ta(t1, t2);
+	ScriptObject::DecreaseOps((int)std::min<uint64>((uint64)ta.w * ta.h * NATIVE_VALUATOR_OPS, INT_MAX));
+	for (TileIndex t : ta) {
+		if (MatchesTileFilter(t, filter)) this->AddItem(t);
+	}
+}
+
+void ScriptTileList::KeepFiltered(TileFilter filter)
+{
+	std::vector<int64> items = this->GetItems();
+	ScriptObject::DecreaseOps((int)std::min<size_t>(items.size() * NATIVE_VALUATOR_OPS, INT_MAX));
+	for (int64 item : items) {
+		if (!MatchesTileFilter((TileIndex)item, filter)) this->RemoveItem(item);
+	}
+}
+
+/** Number of map rows of the tiles that are valuated at once by SumAroundTiles. */
+static const uint SUM_AROUND_TILES_BAND = 64;
+
+/**
+ * Sum a per-tile amount over the catchment area of a station on each of the
+ * given tiles, like e.g. GetAcceptanceAroundTiles does for a single tile.
+ * For a band of rows of tiles at a time a summed-area table of the amount is
+ * made, so the amount of each tile is only determined once, unless the tiles
+ * are so sparse that summing directly is cheaper.
+ * @param tiles The tiles to sum around; preferably sorted ascending.
+ * @param w The width of the station.
+ * @param h The height of the station.
+ * @param rad The catchment radius of the station.
+ * @param amount Function returning the amount of a single tile.
+ * @param[out] sums The sum for each of the tiles.
+ */
+template <typename Tamount>
+static void SumAroundTiles(const std::vector<TileIndex> &tiles, int w, int h, int rad, Tamount amount, std::vector<int64> &sums)
+{
+	sums.resize(tiles.size());
+
+	std::vector<int64> table;
+	size_t first = 0;
+	while (first < tiles.size()) {
+		/* Collect the band of tiles and their extent. */
+		uint band_y = TileY(tiles[first]);
+		uint min_x = MapMaxX();
+		uint max_x = 0;
+		uint min_y = band_y;
+		uint max_y = band_y;
+		size_t last = first;
+		for (; last < tiles.size() && TileY(tiles[last]) < band_y + SUM_AROUND_TILES_BAND; last++) {
+			min_x = std::min(min_x, TileX(tiles[last]));
+			max_x = std::max(max_x, TileX(tiles[last]));
+			min_y = std::min(min_y, TileY(tiles[last]));
+			max_y = std::max(max_y, TileY(tiles[last]));
+		}
+
+		TileArea area = TileArea(TileXY(min_x, min_y), max_x - min_x + w, max_y - min_y + h).Expand(rad);
+		uint64 direct_cost = (uint64)(last - first) * (w + 2 * rad) * (h + 2 * rad);
+
+		if (direct_cost <= (uint64)area.w * area.h) {
+			for (size_t i = first; i < last; i++) {
+				int64 sum = 0;
+				for (TileIndex tile : TileArea(tiles[i], w, h).Expand(rad)) sum += amount(tile);
+				sums[i] = sum;
+			}
+		} else {
+			/* table[(y + 1) * stride + x + 1] is the sum over the area up to and including (x, y). */
+			uint stride = area.w + 1;
+			uint ax = TileX(area.tile);
+			uint ay = TileY(area.tile);
+			table.assign((size_t)stride * (area.h + 1), 0);
+			for (uint y = 0; y < area.h; y++) {
+				int64 row = 0;
+				for (uint x = 0; x < area.w; x++) {
+					row += amount(TileXY(ax + x, ay + y));
+					table[(y + 1) * stride + x + 1] = table[y * stride + x + 1] + row;
+				}
+			}
+
+			for (size_t i = first; i < last; i++) {
+				TileArea ta = TileArea(tiles[i], w, h).Expand(rad);
+				uint sx = TileX(ta.tile) - ax;
+				uint sy = TileY(ta.tile) - ay;
+				uint ex = sx + ta.w;
+				uint ey = sy + ta.h;
+				sums[i] = table[ey * stride + ex] - table[sy * stride + ex] - table[ey * stride + sx] + table[sy * stride + sx];
+			}
+		}
+
+		first = last;
+	}
+}
+
+void ScriptTileList::ValuateCargoAcceptance(CargoID cargo_type, int width, int height, int radius)
+{
+	std::vector<int64> items = this->GetItems();
+	std::vector<int64> values(items.size(), -1);
+
+	if (width > 0 && height > 0 && radius >= 0 && ScriptCargo::IsValidCargo(cargo_type)) {
+		std::vector<TileIndex> tiles;
+		std::vector<size_t> indices;
+		for (size_t i = 0; i < items.size(); i++) {
+			if (!::IsValidTile((TileIndex)items[i])) continue;
+			tiles.push_back((TileIndex)items[i]);
+			indices.push_back(i);
+		}
+
+		/* The acceptance around a tile is the sum of the acceptance of the single tiles, see GetAcceptanceAroundTiles. */
+		std::vector<int64> sums;
+		SumAroundTiles(tiles, width, height, _settings_game.station.modified_catchment ? radius : (int)CA_UNMODIFIED,
+				[cargo_type](TileIndex tile) -> int64 { return ::GetAcceptanceAroundTiles(tile, 1, 1, 0)[cargo_type]; }, sums);
+		for (size_t i = 0; i < sums.size(); i++) values[indices[i]] = (int32)sums[i];
+	}
+
+	this->SetValues(values);
+}
+
+void ScriptTileList::ValuateCargoProduction(CargoID cargo_type, int width, int height, int radius)
+{
+	/* The production of industries is counted once per industry in the catchment
+	 * area, so it is not the sum of the production of the single tiles. */
+	std::vector<int64> items = this->GetItems();
+	std::vector<int64> values;
+	values.reserve(items.size());
+	for (int64 item : items) values.push_back(ScriptTile::GetCargoProduction((TileIndex)item, cargo_type, width, height, radius));
+
+	this->SetValues(values);
+}
+
 /**
  * Helper to get list of tiles that will cover an industry's production or acceptance.
  * @param i Industry in question
@@ -20,6 +20,22 @@
  */
 class ScriptTileList : public ScriptList {
 public:
+	/**
+	 * Properties tiles can be filtered on; combine them with '|' to require
+	 *  all of them at once.
+	 */
+	enum TileFilter {
+		TF_NONE      = 0,      ///< No filtering; every tile matches.
+		TF_BUILDABLE = 1 << 0, ///< The tile is buildable, see ScriptTile::IsBuildable.
+		TF_FLAT      = 1 << 1, ///< The tile has no slope, see ScriptTile::GetSlope.
+		TF_WATER     = 1 << 2, ///< The tile is a water tile, see ScriptTile::IsWaterTile.
+		TF_COAST     = 1 << 3, ///< The tile is a coast tile, see ScriptTile::IsCoastTile.
+		TF_TREES     = 1 << 4, ///< The tile has trees, see ScriptTile::HasTreeOnTile.
+		TF_DESERT    = 1 << 5, ///< The tile is desert, see ScriptTile::IsDesertTile.
+		TF_SNOW      = 1 << 6, ///< The tile is snow covered, see ScriptTile::IsSnowTile.
+		TF_NOT_OWNED = 1 << 7, ///< The tile has no owner, see ScriptTile::GetOwner.
+	};
+
 	/**
 	 * Adds the rectangle between tile_from and tile_to to the to-be-evaluated tiles.
 	 * @param tile_from One corner of the tiles to add.
@@ -51,6 +67,57 @@ public:
 	 * @pre ScriptMap::IsValidTile(tile).
 	 */
 	void RemoveTile(TileIndex tile);
+
+	/**
+	 * Adds the tiles in the rectangle between tile_from and tile_to that
+	 *  match all properties of the filter. This is the same as adding the
+	 *  rectangle and valuating it on every property, but much faster.
+	 * @param tile_from One corner of the tiles to add.
+	 * @param tile_to The other corner of the tiles to add.
+	 * @param filter The properties the tiles need to have.
+	 * @pre ScriptMap::IsValidTile(tile_from).
+	 * @pre ScriptMap::IsValidTile(tile_to).
+	 */
+	void AddFilteredRectangle(TileIndex tile_from, TileIndex tile_to, TileFilter filter);
+
+	/**
+	 * Keep only the tiles that match all properties of the filter.
+	 * @param filter The properties the tiles need to have.
+	 */
+	void KeepFiltered(TileFilter filter);
+
+	/**
+	 * Set the value of every tile in the list to its cargo acceptance, as
+	 *  ScriptTile::GetCargoAcceptance would return it. This is much faster
+	 *  than valuating the list with ScriptTile::GetCargoAcceptance.
+	 * @param cargo_type The cargo to check the acceptance of.
+	 * @param width The width of the station.
+	 * @param height The height of the station.
+	 * @param radius The radius of the station.
+	 * @pre ScriptCargo::IsValidCargo(cargo_type)
+	 * @pre width > 0.
+	 * @pre height > 0.
+	 * @pre radius >= 0.
+	 * @note When a precondition fails, every tile gets the value -1.
+	 */
+	void ValuateCargoAcceptance(CargoID cargo_type, int width, int height, int radius);
+
+	/**
+	 * Set the value of every tile in the list to its cargo production, as
+	 *  ScriptTile::GetCargoProduction would return it. The production is
+	 *  determined for every tile on its own, like valuating the list with
+	 *  ScriptTile::GetCargoProduction does, but without calling a valuator.
+	 * @param cargo_type The cargo to check the production of.
+	 * @param width The width of the station.
+	 * @param height The height of the station.
+	 * @param radius The radius of the station.
+	 * @pre ScriptCargo::IsValidCargo(cargo_type)
+	 * @pre width > 0.
+	 * @pre height > 0.
+	 * @pre radius >= 0.
+	 * @note When a precondition fails, every tile gets the value -1.
+	 */
+	void ValuateCargoProduction(CargoID cargo_type, int width, int height, int radius);
 };
 
 /**
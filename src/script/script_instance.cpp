@@ -17,6 +17,7 @@
 #include "script_storage.hpp"
 #include "script_info.hpp"
 #include "script_instance.hpp"
+#include "script_thread.hpp"
 
 #include "api/script_controller.hpp"
 #include "api/script_error.hpp"
@@ -28,6 +29,7 @@
 #include "../fileio_func.h"
 #include "../league_type.h"
 #include "../misc/endian_buffer.hpp"
+#include <chrono>
 
 #include "../safeguards.h"
 
@@ -45,6 +47,8 @@ ScriptStorage::~ScriptStorage()
  */
 static void PrintFunc(bool error_msg, const SQChar *message)
 {
+	ScriptGameStateScope game_state;
+
 	/* Convert to OpenTTD internal capable string */
 	ScriptController::Print(error_msg, message);
 }
@@ -191,6 +195,7 @@ void ScriptInstance::GameLoop()
 		if (this->is_save_data_on_stack) {
 			sq_poptop(this->engine->GetVM());
 			this->is_save_data_on_stack = false;
+			this->save_data.clear();
 		}
 		try {
 			this->callback(this);
@@ -240,6 +245,7 @@ void ScriptInstance::GameLoop()
 	if (this->is_save_data_on_stack) {
 		sq_poptop(this->engine->GetVM());
 		this->is_save_data_on_stack = false;
+		this->save_data.clear();
 	}
 
 	/* Continue the VM */
@@ -350,7 +356,17 @@ static const SaveLoad _script_byte[] = {
 	SLEG_VAR("type", _script_sl_byte, SLE_UINT8),
 };
 
-/* static */ bool ScriptInstance::SaveObject(HSQUIRRELVM vm, SQInteger index, int max_depth, bool test)
+/**
+ * Append a 64 bits integer to serialised save data, in the byte order of the savegame.
+ * @param buffer The save data.
+ * @param value The integer to append.
+ */
+static void SaveInt64(std::vector<byte> &buffer, int64 value)
+{
+	for (int shift = 56; shift >= 0; shift -= 8) buffer.push_back((byte)(value >> shift));
+}
+
+/* static */ bool ScriptInstance::SaveObject(HSQUIRRELVM vm, SQInteger index, int max_depth, std::vector<byte> &buffer)
 {
 	if (max_depth == 0) {
 		ScriptLog::Error("Savedata can only be nested to 25 deep. No data saved."); // SQUIRREL_MAX_DEPTH = 25
@@ -359,24 +375,14 @@ static const SaveLoad _script_byte[] = {
 
 	switch (sq_gettype(vm, index)) {
 		case OT_INTEGER: {
-			if (!test) {
-				_script_sl_byte = SQSL_INT;
-				SlObject(nullptr, _script_byte);
-			}
 			SQInteger res;
 			sq_getinteger(vm, index, &res);
-			if (!test) {
-				int64 value = (int64)res;
-				SlCopy(&value, 1, SLE_INT64);
-			}
+			buffer.push_back(SQSL_INT);
+			SaveInt64(buffer, (int64)res);
 			return true;
 		}
 
 		case OT_STRING: {
-			if (!test) {
-				_script_sl_byte = SQSL_STRING;
-				SlObject(nullptr, _script_byte);
-			}
 			const SQChar *buf;
 			sq_getstring(vm, index, &buf);
 			size_t len = strlen(buf) + 1;
@@ -384,23 +390,18 @@ static const SaveLoad _script_byte[] = {
 				ScriptLog::Error("Maximum string length is 254 chars. No data saved.");
 				return false;
 			}
-			if (!test) {
-				_script_sl_byte = (byte)len;
-				SlObject(nullptr, _script_byte);
-				SlCopy(const_cast<char *>(buf), len, SLE_CHAR);
-			}
+			buffer.push_back(SQSL_STRING);
+			buffer.push_back((byte)len);
+			buffer.insert(buffer.end(), buf, buf + len);
 			return true;
 		}
 
 		case OT_ARRAY: {
-			if (!test) {
-				_script_sl_byte = SQSL_ARRAY;
-				SlObject(nullptr, _script_byte);
-			}
+			buffer.push_back(SQSL_ARRAY);
 			sq_pushnull(vm);
 			while (SQ_SUCCEEDED(sq_next(vm, index - 1))) {
 				/* Store the value */
-				bool res = SaveObject(vm, -1, max_depth - 1, test);
+				bool res = SaveObject(vm, -1, max_depth - 1, buffer);
 				sq_pop(vm, 2);
 				if (!res) {
 					sq_pop(vm, 1);
@@ -408,22 +409,16 @@ static const SaveLoad _script_byte[] = {
 				}
 			}
 			sq_pop(vm, 1);
-			if (!test) {
-				_script_sl_byte = SQSL_ARRAY_TABLE_END;
-				SlObject(nullptr, _script_byte);
-			}
+			buffer.push_back(SQSL_ARRAY_TABLE_END);
 			return true;
 		}
 
 		case OT_TABLE: {
-			if (!test) {
-				_script_sl_byte = SQSL_TABLE;
-				SlObject(nullptr, _script_byte);
-			}
+			buffer.push_back(SQSL_TABLE);
 			sq_pushnull(vm);
 			while (SQ_SUCCEEDED(sq_next(vm, index - 1))) {
 				/* Store the key + value */
-				bool res = SaveObject(vm, -2, max_depth - 1, test) && SaveObject(vm, -1, max_depth - 1, test);
+				bool res = SaveObject(vm, -2, max_depth - 1, buffer) && SaveObject(vm, -1, max_depth - 1, buffer);
 				sq_pop(vm, 2);
 				if (!res) {
 					sq_pop(vm, 1);
@@ -431,32 +426,20 @@ static const SaveLoad _script_byte[] = {
 				}
 			}
 			sq_pop(vm, 1);
-			if (!test) {
-				_script_sl_byte = SQSL_ARRAY_TABLE_END;
-				SlObject(nullptr, _script_byte);
-			}
+			buffer.push_back(SQSL_ARRAY_TABLE_END);
 			return true;
 		}
 
 		case OT_BOOL: {
-			if (!test) {
-				_script_sl_byte = SQSL_BOOL;
-				SlObject(nullptr, _script_byte);
-			}
 			SQBool res;
 			sq_getbool(vm, index, &res);
-			if (!test) {
-				_script_sl_byte = res ? 1 : 0;
-				SlObject(nullptr, _script_byte);
-			}
+			buffer.push_back(SQSL_BOOL);
+			buffer.push_back(res ? 1 : 0);
 			return true;
 		}
 
 		case OT_NULL: {
-			if (!test) {
-				_script_sl_byte = SQSL_NULL;
-				SlObject(nullptr, _script_byte);
-			}
+			buffer.push_back(SQSL_NULL);
 			return true;
 		}
 
@@ -484,10 +467,12 @@ void ScriptInstance::Save()
 
 	HSQUIRRELVM vm = this->engine->GetVM();
 	if (this->is_save_data_on_stack) {
+		/* Save the data that was just loaded, or that was serialised by the previous
+		 * call; with SlAutolength we are called twice for the same savegame. */
+		if (this->save_data.empty()) SaveObject(vm, -1, SQUIRREL_MAX_DEPTH, this->save_data);
 		_script_sl_byte = 1;
 		SlObject(nullptr, _script_byte);
-		/* Save the data that was just loaded. */
-		SaveObject(vm, -1, SQUIRREL_MAX_DEPTH, false);
+		SlCopy(this->save_data.data(), this->save_data.size(), SLE_UINT8);
 	} else if (!this->is_started) {
 		SaveEmpty();
 		return;
@@ -526,12 +511,18 @@ void ScriptInstance::Save()
 			return;
 		}
 		sq_pushobject(vm, savedata);
-		if (SaveObject(vm, -1, SQUIRREL_MAX_DEPTH, true)) {
+		this->save_data.clear();
+		auto start = std::chrono::steady_clock::now();
+		if (SaveObject(vm, -1, SQUIRREL_MAX_DEPTH, this->save_data)) {
 			_script_sl_byte = 1;
 			SlObject(nullptr, _script_byte);
-			SaveObject(vm, -1, SQUIRREL_MAX_DEPTH, false);
+			SlCopy(this->save_data.data(), this->save_data.size(), SLE_UINT8);
 			this->is_save_data_on_stack = true;
+			Debug(script, 4, "Serialised {} bytes of save data in {} us; {} bytes of script memory in use, {} bytes reserved",
+					this->save_data.size(), std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count(),
+					this->engine->GetAllocatedMemory(), this->engine->GetReservedMemory());
 		} else {
+			this->save_data.clear();
 			SaveEmpty();
 			this->engine->CrashOccurred();
 		}
@@ -700,6 +691,7 @@ void ScriptInstance::LoadOnStack(ScriptData *data)
 	sq_pushinteger(vm, std::get<SQInteger>(version));
 	LoadObjects(vm, data);
 	this->is_save_data_on_stack = true;
+	this->save_data.clear();
 }
 
 bool ScriptInstance::CallLoad()
@@ -709,6 +701,7 @@ bool ScriptInstance::CallLoad()
 	if (!this->is_save_data_on_stack) return true;
 	/* Whatever happens, after CallLoad the savegame data is removed from the stack. */
 	this->is_save_data_on_stack = false;
+	this->save_data.clear();
 
 	if (!this->engine->MethodExists(*this->instance, "Load")) {
 		ScriptLog::Warning("Loading failed: there was data for the script to load, but the script does not have a Load() function.");
@@ -152,6 +152,12 @@ public:
 	 */
 	inline bool IsDead() const { return this->is_dead; }
 
+	/**
+	 * Check whether the script runs any of its code in the next GameLoop.
+	 * @return True iff the script is not dead, paused or suspended for the next tick.
+	 */
+	inline bool WillRunScript() const { return !this->is_dead && !this->is_paused && (this->suspend == 0 || this->suspend == 1); }
+
 	/**
 	 * Call the script Save function and save all data in the savegame.
 	 */
@@ -285,6 +291,7 @@ private:
 	bool is_started;                      ///< Is the scripts constructor executed?
 	bool is_dead;                         ///< True if the script has been stopped.
 	bool is_save_data_on_stack;           ///< Is the save data still on the squirrel stack?
+	std::vector<byte> save_data;          ///< The save data on the squirrel stack, serialised; empty when not serialised yet.
 	int suspend;                          ///< The amount of ticks to suspend this script before it's allowed to continue.
 	bool is_paused;                       ///< Is the script paused? (a paused script will not be executed until unpaused)
 	bool in_shutdown;                     ///< Is this instance currently being destructed?
@@ -298,16 +305,15 @@ private:
 	bool CallLoad();
 
 	/**
-	 * Save one object (int / string / array / table) to the savegame.
+	 * Serialise one object (int / string / array / table) in the format of the savegame.
 	 * @param vm The virtual machine to get all the data from.
 	 * @param index The index on the squirrel stack of the element to save.
 	 * @param max_depth The maximum depth recursive arrays / tables will be stored
 	 *   with before an error is returned.
-	 * @param test If true, don't really store the data but only check if it is
-	 *   valid.
-	 * @return True if the saving was successful.
+	 * @param buffer The buffer to append the serialised object to.
+	 * @return True if the object could be serialised.
 	 */
-	static bool SaveObject(HSQUIRRELVM vm, SQInteger index, int max_depth, bool test);
+	static bool SaveObject(HSQUIRRELVM vm, SQInteger index, int max_depth, std::vector<byte> &buffer);
 
 	/**
 	 * Load all objects from a savegame.
@@ -0,0 +1,268 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file script_thread.cpp Running the scripts of several companies at the same time.
+ *
+ * While the scripts run on worker threads, the game thread waits for them,
+ * so the game state only changes through the commands of the scripts. All
+ * scripts read the game state under one lock, which they only release while
+ * running their own Squirrel code.
+ *
+ * To keep the results the same no matter how the threads are scheduled, a
+ * script that wants to execute a command waits for its turn. The turn is
+ * given to the lowest waiting company once no script is running anymore.
+ * As such commands are only executed while no other script runs, and in an
+ * order that only depends on the game state.
+ *
+ * Every company gets a worker thread of its own the first time its script
+ * runs on a thread; the workers are kept for the following ticks. There is
+ * one worker per company, as all scripts have to run at the same time for
+ * the turns to be given out. When a worker can not be started, all scripts
+ * run one after the other instead.
+ *
+ * Commands that only estimate the costs do not change the game state, so
+ * they do not wait for a turn.
+ */
+
+#include "../stdafx.h"
+#include "../core/bitmath_func.hpp"
+#include "../company_base.h"
+#include "../company_func.h"
+#include "../thread.h"
+#include "../ai/ai_instance.hpp"
+#include "script_instance.hpp"
+#include "script_thread.hpp"
+
+#include <condition_variable>
+
+#include "../safeguards.h"
+
+static bool _script_threads_running = false; ///< Whether scripts are running on worker threads.
+static std::mutex _script_game_state_mutex;  ///< Lock on the game state while scripts run on worker threads.
+static thread_local int _script_game_state_depth = 0; ///< Depth of the game state scopes of this thread.
+static thread_local CompanyID _script_thread_company = INVALID_COMPANY; ///< Current company of this thread, while it does not have the game state lock.
+static thread_local CompanyID _script_thread_owner = INVALID_COMPANY;   ///< Company of which this thread runs the script.
+
+static std::mutex _script_turn_mutex;             ///< Lock on the turn administration.
+static std::condition_variable _script_turn_cond; ///< Signalled when the turn is given to a company.
+static uint _script_threads_busy = 0;             ///< Number of scripts that run and do not wait for their turn.
+static CompanyMask _script_threads_waiting = 0;   ///< Companies that wait for their turn.
+static CompanyID _script_turn = INVALID_COMPANY;  ///< Company that got the turn, but did not take it yet.
+static std::vector<ScriptInstance *> _script_threads_deleted; ///< Instances to delete once all scripts are done.
+
+static std::mutex _script_workers_mutex;              ///< Lock on the administration of the worker threads.
+static std::condition_variable _script_workers_cond;  ///< Signalled when there are scripts to run, or the workers have to exit.
+static std::condition_variable _script_workers_done;  ///< Signalled when the workers finished running the scripts.
+static std::thread _script_workers[MAX_COMPANIES];    ///< The worker thread of every company, once started.
+static CompanyMask _script_workers_jobs = 0;          ///< Companies whose worker has to run the script.
+static ScriptThreadProc *_script_workers_proc = nullptr; ///< The function running the scripts.
+static uint _script_workers_pending = 0;              ///< Number of scripts the workers did not finish yet.
+static bool _script_workers_exit = false;             ///< Whether the workers have to exit.
+
+/** Take the lock on the game state for this thread. */
+static void LockGameState()
+{
+	_script_game_state_mutex.lock();
+	_current_company = _script_thread_company;
+}
+
+/** Release the lock on the game state of this thread. */
+static void UnlockGameState()
+{
+	_script_thread_company = _current_company;
+	_script_game_state_mutex.unlock();
+}
+
+ScriptGameStateScope::ScriptGameStateScope()
+{
+	if (!_script_threads_running) return;
+	if (_script_game_state_depth++ == 0) LockGameState();
+}
+
+ScriptGameStateScope::~ScriptGameStateScope()
+{
+	if (!_script_threads_running) return;
+	if (--_script_game_state_depth == 0) UnlockGameState();
+}
+
+ScriptOwnCodeScope::ScriptOwnCodeScope() : depth(_script_game_state_depth)
+{
+	if (this->depth == 0) return;
+	_script_game_state_depth = 0;
+	UnlockGameState();
+}
+
+ScriptOwnCodeScope::~ScriptOwnCodeScope()
+{
+	if (this->depth == 0) return;
+	LockGameState();
+	_script_game_state_depth = this->depth;
+}
+
+/**
+ * Mark a script as no longer running. When no script runs anymore,
+ * give the turn to the lowest company that is waiting for it.
+ * @pre The turn administration is locked.
+ */
+static void ScriptThreadStopped()
+{
+	if (--_script_threads_busy != 0 || _script_threads_waiting == 0) return;
+
+	_script_turn = (CompanyID)FindFirstBit(_script_threads_waiting);
+	ClrBit(_script_threads_waiting, _script_turn);
+	_script_threads_busy++;
+	_script_turn_cond.notify_all();
+}
+
+/**
+ * Wait until the script of this thread may execute a command.
+ * While waiting, the commands of other scripts may remove the company of this
+ * script, e.g. when it is bought by another company. Then its instance will be
+ * deleted once all scripts are done, and the command may not be executed.
+ * @param instance The instance of the script of this thread.
+ * @return False when the company or the instance was removed while waiting.
+ */
+bool ScriptWaitForCommandTurn(const ScriptInstance *instance)
+{
+	if (!_script_threads_running) return true;
+
+	CompanyID company = _script_thread_owner;
+	{
+		ScriptOwnCodeScope own_code;
+		std::unique_lock<std::mutex> lock(_script_turn_mutex);
+
+		SetBit(_script_threads_waiting, company);
+		ScriptThreadStopped();
+		_script_turn_cond.wait(lock, [company]() { return _script_turn == company; });
+		_script_turn = INVALID_COMPANY;
+	}
+
+	const Company *c = Company::GetIfValid(company);
+	return c != nullptr && c->is_ai && c->ai_instance == instance;
+}
+
+/**
+ * Run the script of a company on this thread.
+ * @param company The company.
+ * @param proc The function running the script.
+ */
+static void ScriptThreadMain(CompanyID company, ScriptThreadProc *proc)
+{
+	_script_thread_owner = company;
+	_script_thread_company = company;
+	{
+		ScriptGameStateScope game_state;
+		proc(company);
+	}
+
+	std::lock_guard<std::mutex> lock(_script_turn_mutex);
+	ScriptThreadStopped();
+}
+
+/**
+ * Main loop of the worker thread of a company: run its script whenever asked to.
+ * @param company The company.
+ */
+static void ScriptWorkerMain(CompanyID company)
+{
+	std::unique_lock<std::mutex> lock(_script_workers_mutex);
+	for (;;) {
+		_script_workers_cond.wait(lock, [company]() { return _script_workers_exit || HasBit(_script_workers_jobs, company); });
+		if (_script_workers_exit) return;
+
+		ClrBit(_script_workers_jobs, company);
+		ScriptThreadProc *proc = _script_workers_proc;
+
+		lock.unlock();
+		ScriptThreadMain(company, proc);
+		lock.lock();
+
+		if (--_script_workers_pending == 0) _script_workers_done.notify_all();
+	}
+}
+
+/** Stops the worker threads when the game exits. */
+static struct ScriptWorkersStopper {
+	~ScriptWorkersStopper()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_script_workers_mutex);
+			_script_workers_exit = true;
+		}
+		_script_workers_cond.notify_all();
+		for (std::thread &worker : _script_workers) {
+			if (worker.joinable()) worker.join();
+		}
+	}
+} _script_workers_stopper;
+
+/**
+ * Run the scripts of some companies, each on the worker thread of its company.
+ * Returns when all of them are done.
+ * @param companies The companies to run the scripts of.
+ * @param proc The function running the script of a company.
+ */
+void RunScriptsOnThreads(CompanyMask companies, ScriptThreadProc *proc)
+{
+	assert(!_script_threads_running);
+
+	CompanyID old_company = _current_company;
+
+	/* When a worker can not be started, the turns can not be given out in the same order; so then run the scripts one after the other. */
+	for (CompanyID c : SetBitIterator<CompanyID>(companies)) {
+		if (_script_workers[c].joinable() || StartNewThread(&_script_workers[c], "ottd:script", [c]() { ScriptWorkerMain(c); })) continue;
+
+		for (CompanyID company : SetBitIterator<CompanyID>(companies)) {
+			/* An earlier script may have removed the company. */
+			const Company *comp = Company::GetIfValid(company);
+			if (comp == nullptr || !comp->is_ai) continue;
+
+			_current_company = company;
+			proc(company);
+		}
+		_current_company = old_company;
+		return;
+	}
+
+	_script_threads_busy = CountBits(companies);
+	_script_threads_waiting = 0;
+	_script_turn = INVALID_COMPANY;
+	_script_threads_running = true;
+
+	{
+		std::lock_guard<std::mutex> lock(_script_workers_mutex);
+		_script_workers_proc = proc;
+		_script_workers_jobs = companies;
+		_script_workers_pending = CountBits(companies);
+	}
+	_script_workers_cond.notify_all();
+
+	{
+		std::unique_lock<std::mutex> lock(_script_workers_mutex);
+		_script_workers_done.wait(lock, []() { return _script_workers_pending == 0; });
+	}
+
+	_script_threads_running = false;
+	_current_company = old_company;
+
+	for (ScriptInstance *instance : _script_threads_deleted) delete instance;
+	_script_threads_deleted.clear();
+}
+
+/**
+ * Delete a script instance. When scripts run on threads, the script may
+ * still be waiting for its turn, so then it is deleted when all are done.
+ * @param instance The instance to delete.
+ */
+void DeleteScriptInstance(ScriptInstance *instance)
+{
+	if (_script_threads_running) {
+		_script_threads_deleted.push_back(instance);
+	} else {
+		delete instance;
+	}
+}
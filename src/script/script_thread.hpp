@@ -0,0 +1,45 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file script_thread.hpp Running the scripts of several companies at the same time. */
+
+#ifndef SCRIPT_THREAD_HPP
+#define SCRIPT_THREAD_HPP
+
+#include "../company_type.h"
+
+/**
+ * Scope in which a script accesses the game state. When the scripts of
+ * several companies run on worker threads, only one of them is inside such
+ * a scope at a time. Outside of running scripts on threads this does nothing.
+ */
+class ScriptGameStateScope {
+public:
+	ScriptGameStateScope();
+	~ScriptGameStateScope();
+};
+
+/**
+ * Scope in which a script only runs its own Squirrel code, so the scripts
+ * of other companies may access the game state meanwhile.
+ */
+class ScriptOwnCodeScope {
+	int depth; ///< The depth of the game state scopes that were left.
+
+public:
+	ScriptOwnCodeScope();
+	~ScriptOwnCodeScope();
+};
+
+/** The function running the script of a company on a worker thread. */
+typedef void (ScriptThreadProc)(CompanyID company);
+
+void RunScriptsOnThreads(CompanyMask companies, ScriptThreadProc *proc);
+bool ScriptWaitForCommandTurn(const class ScriptInstance *instance);
+void DeleteScriptInstance(class ScriptInstance *instance);
+
+#endif /* SCRIPT_THREAD_HPP */
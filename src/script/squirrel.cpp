@@ -13,6 +13,7 @@
 #include "../fileio_func.h"
 #include "../string_func.h"
 #include "script_fatalerror.hpp"
+#include "script_thread.hpp"
 #include "../settings_type.h"
 #include <sqstdaux.h>
 #include <../squirrel/sqpcheader.h>
@@ -39,6 +40,7 @@
 struct ScriptAllocator {
 	size_t allocated_size;   ///< Sum of allocated data size
 	size_t allocation_limit; ///< Maximum this allocator may use before allocations fail
+	size_t reserved_size;    ///< Sum of the memory requested from the OS; the pool chunks and the large allocations
 	/**
 	 * Whether the error has already been thrown, so to not throw secondary errors in
 	 * the handling of the allocation error. This as the handling of the error will
@@ -49,6 +51,27 @@ struct ScriptAllocator {
 
 	static const size_t SAFE_LIMIT = 0x8000000; ///< 128 MiB, a safe choice for almost any situation
 
+	/*
+	 * Squirrel makes lots of small allocations of only a few sizes (strings, table
+	 * nodes, closures, ...) and tells the size again when freeing or reallocating.
+	 * Those are served from per-size free lists carved out of larger chunks, so they
+	 * do not need a trip to malloc/free, nor its per-allocation bookkeeping.
+	 */
+	static const size_t POOL_GRANULARITY = 16;        ///< Difference in size between the size classes; also the alignment of the pooled blocks.
+	static const size_t POOL_MAX_SIZE = 256;          ///< Largest allocation served from the pools.
+	static const size_t POOL_CHUNK_SIZE = 64 * 1024;  ///< Size of the chunks the pooled blocks are carved from.
+	static const size_t POOL_CLASSES = POOL_MAX_SIZE / POOL_GRANULARITY; ///< Number of size classes.
+
+	/** A free block in a pool; the pointer to the next free block is stored in the block itself. */
+	struct PoolBlock {
+		PoolBlock *next; ///< The next free block of the same size class.
+	};
+
+	PoolBlock *free_blocks[POOL_CLASSES]; ///< The free blocks, per size class.
+	std::vector<void *> chunks;           ///< All chunks the pooled blocks are carved from.
+	char *chunk_pos;                      ///< Start of the part of the last chunk that is not carved yet.
+	char *chunk_end;                      ///< End of the last chunk.
+
 #ifdef SCRIPT_DEBUG_ALLOCATIONS
 	std::map<void *, size_t> allocations;
 #endif
@@ -58,6 +81,94 @@ struct ScriptAllocator {
 		if (this->allocated_size > this->allocation_limit) throw Script_FatalError("Maximum memory allocation exceeded");
 	}
 
+	/**
+	 * Get the size class of an allocation that is served from the pools.
+	 * @param size The size of the allocation.
+	 * @return The size class.
+	 */
+	static inline size_t GetPoolClass(size_t size)
+	{
+		return (size - 1) / POOL_GRANULARITY;
+	}
+
+	/**
+	 * Whether an allocation of the given size is served from the pools.
+	 * @param size The size of the allocation.
+	 * @return True iff the allocation comes from a pool.
+	 */
+	static inline bool IsPooled(size_t size)
+	{
+		return size != 0 && size <= POOL_MAX_SIZE;
+	}
+
+	/**
+	 * Allocate a block of memory, either from the pools or the OS.
+	 * @param size The size of the block.
+	 * @return The block, or nullptr if the OS did not have enough memory.
+	 */
+	void *AllocateBlock(size_t size)
+	{
+		if (!IsPooled(size)) {
+			void *p = malloc(size);
+			if (p != nullptr) this->reserved_size += size;
+			return p;
+		}
+
+		size_t pool_class = GetPoolClass(size);
+		PoolBlock *block = this->free_blocks[pool_class];
+		if (block != nullptr) {
+			this->free_blocks[pool_class] = block->next;
+			return block;
+		}
+
+		size_t block_size = (pool_class + 1) * POOL_GRANULARITY;
+		if (this->chunk_pos == nullptr || (size_t)(this->chunk_end - this->chunk_pos) < block_size) {
+			char *chunk = static_cast<char *>(malloc(POOL_CHUNK_SIZE));
+			if (chunk == nullptr) return nullptr;
+			this->chunks.push_back(chunk);
+			this->reserved_size += POOL_CHUNK_SIZE;
+			this->chunk_pos = chunk;
+			this->chunk_end = chunk + POOL_CHUNK_SIZE;
+		}
+
+		void *p = this->chunk_pos;
+		this->chunk_pos += block_size;
+		return p;
+	}
+
+	/**
+	 * Give a block of memory back to the pools or the OS.
+	 * @param p The block.
+	 * @param size The size the block was allocated with.
+	 */
+	void FreeBlock(void *p, size_t size)
+	{
+		if (!IsPooled(size)) {
+			free(p);
+			this->reserved_size -= size;
+			return;
+		}
+
+		size_t pool_class = GetPoolClass(size);
+		PoolBlock *block = static_cast<PoolBlock *>(p);
+		block->next = this->free_blocks[pool_class];
+		this->free_blocks[pool_class] = block;
+	}
+
+	/**
+	 * Give the chunks of the pools back to the OS.
+	 * @pre Nothing is allocated from the pools anymore.
+	 */
+	void ReleasePools()
+	{
+		for (void *chunk : this->chunks) free(chunk);
+		this->reserved_size -= this->chunks.size() * POOL_CHUNK_SIZE;
+		this->chunks.clear();
+		std::fill(std::begin(this->free_blocks), std::end(this->free_blocks), nullptr);
+		this->chunk_pos = nullptr;
+		this->chunk_end = nullptr;
+	}
+
 	/**
 	 * Catch all validation for the allocation; did it allocate too much memory according
 	 * to the allocation limit or did the allocation at the OS level maybe fail? In those
@@ -66,8 +177,9 @@ struct ScriptAllocator {
 	 * clean everything up.
 	 * @param requested_size The requested size that was requested to be allocated.
 	 * @param p              The pointer to the allocated object, or null if allocation failed.
+	 * @param size           The size the object was allocated with.
 	 */
-	void CheckAllocation(size_t requested_size, void *p)
+	void CheckAllocation(size_t requested_size, void *p, size_t size)
 	{
 		if (this->allocated_size + requested_size > this->allocation_limit && !this->error_thrown) {
 			/* Do not allow allocating more than the allocation limit, except when an error is
@@ -78,7 +190,7 @@ struct ScriptAllocator {
 			seprintf(buff, lastof(buff), "Maximum memory allocation exceeded by " PRINTF_SIZE " bytes when allocating " PRINTF_SIZE " bytes",
 				this->allocated_size + requested_size - this->allocation_limit, requested_size);
 			/* Don't leak the rejected allocation. */
-			free(p);
+			if (p != nullptr) this->FreeBlock(p, size);
 			throw Script_FatalError(buff);
 		}
 
@@ -101,9 +213,9 @@ struct ScriptAllocator {
 
 	void *Malloc(SQUnsignedInteger size)
 	{
-		void *p = malloc(size);
+		void *p = this->AllocateBlock(size);
 
-		this->CheckAllocation(size, p);
+		this->CheckAllocation(size, p, size);
 
 		this->allocated_size += size;
 
@@ -126,6 +238,18 @@ struct ScriptAllocator {
 			return nullptr;
 		}
 
+		/* Growing or shrinking within the same size class does not need to move anything. */
+		if (IsPooled(oldsize) && IsPooled(size) && GetPoolClass(oldsize) == GetPoolClass(size) && this->allocated_size + size - oldsize <= this->allocation_limit) {
+			this->allocated_size -= oldsize;
+			this->allocated_size += size;
+
+#ifdef SCRIPT_DEBUG_ALLOCATIONS
+			assert(this->allocations[p] == oldsize);
+			this->allocations[p] = size;
+#endif
+			return p;
+		}
+
 #ifdef SCRIPT_DEBUG_ALLOCATIONS
 		assert(this->allocations[p] == oldsize);
 		this->allocations.erase(p);
@@ -134,13 +258,13 @@ struct ScriptAllocator {
 		 * If memory exception is thrown, the old pointer is expected
 		 * to be valid for engine cleanup.
 		 */
-		void *new_p = malloc(size);
+		void *new_p = this->AllocateBlock(size);
 
-		this->CheckAllocation(size - oldsize, new_p);
+		this->CheckAllocation(size - oldsize, new_p, size);
 
 		/* Memory limit test passed, we can copy data and free old pointer. */
 		memcpy(new_p, p, std::min(oldsize, size));
-		free(p);
+		this->FreeBlock(p, oldsize);
 
 		this->allocated_size -= oldsize;
 		this->allocated_size += size;
@@ -157,7 +281,7 @@ struct ScriptAllocator {
 	void Free(void *p, SQUnsignedInteger size)
 	{
 		if (p == nullptr) return;
-		free(p);
+		this->FreeBlock(p, size);
 		this->allocated_size -= size;
 
 #ifdef SCRIPT_DEBUG_ALLOCATIONS
@@ -171,7 +295,11 @@ struct ScriptAllocator {
 		this->allocated_size = 0;
 		this->allocation_limit = static_cast<size_t>(_settings_game.script.script_max_memory_megabytes) << 20;
 		if (this->allocation_limit == 0) this->allocation_limit = SAFE_LIMIT; // in case the setting is somehow zero
+		this->reserved_size = 0;
 		this->error_thrown = false;
+		std::fill(std::begin(this->free_blocks), std::end(this->free_blocks), nullptr);
+		this->chunk_pos = nullptr;
+		this->chunk_end = nullptr;
 	}
 
 	~ScriptAllocator()
@@ -179,6 +307,7 @@ struct ScriptAllocator {
 #ifdef SCRIPT_DEBUG_ALLOCATIONS
 		assert(this->allocations.size() == 0);
 #endif
+		this->ReleasePools();
 	}
 };
 
@@ -190,7 +319,7 @@ struct ScriptAllocator {
  */
 #include "../safeguards.h"
 
-ScriptAllocator *_squirrel_allocator = nullptr;
+thread_local ScriptAllocator *_squirrel_allocator = nullptr;
 
 /* See 3rdparty/squirrel/squirrel/sqmem.cpp for the default allocator implementation, which this overrides */
 #ifndef SQUIRREL_DEFAULT_ALLOCATOR
@@ -205,6 +334,12 @@ size_t Squirrel::GetAllocatedMemory() const noexcept
 	return this->allocator->allocated_size;
 }
 
+size_t Squirrel::GetReservedMemory() const noexcept
+{
+	assert(this->allocator != nullptr);
+	return this->allocator->reserved_size;
+}
+
 
 void Squirrel::CompileError(HSQUIRRELVM vm, const SQChar *desc, const SQChar *source, SQInteger line, SQInteger column)
 {
@@ -399,7 +534,10 @@ bool Squirrel::Resume(int suspend)
 		suspend = -this->overdrawn_ops;
 	}
 
-	this->crashed = !sq_resumecatch(this->vm, suspend);
+	{
+		ScriptOwnCodeScope own_code;
+		this->crashed = !sq_resumecatch(this->vm, suspend);
+	}
 	this->overdrawn_ops = -this->vm->_ops_till_suspend;
 	this->allocator->CheckLimit();
 	return this->vm->_suspended != 0;
@@ -441,7 +579,10 @@ bool Squirrel::CallMethod(HSQOBJECT instance, const char *method_name, HSQOBJECT
 	}
 	/* Call the method */
 	sq_pushobject(this->vm, instance);
-	if (SQ_FAILED(sq_call(this->vm, 1, ret == nullptr ? SQFalse : SQTrue, SQTrue, suspend))) return false;
+	{
+		ScriptOwnCodeScope own_code;
+		if (SQ_FAILED(sq_call(this->vm, 1, ret == nullptr ? SQFalse : SQTrue, SQTrue, suspend))) return false;
+	}
 	if (ret != nullptr) sq_getstackobj(vm, -1, ret);
 	/* Reset the top, but don't do so for the script main function, as we need
 	 *  a correct stack when resuming. */
@@ -769,6 +910,7 @@ void Squirrel::Uninitialize()
 	sq_close(this->vm);
 
 	assert(this->allocator->allocated_size == 0);
+	this->allocator->ReleasePools();
 
 	/* Reset memory allocation errors. */
 	this->allocator->error_thrown = false;
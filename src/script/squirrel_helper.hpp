@@ -16,6 +16,7 @@
 #include "../string_func.h"
 #include "../tile_type.h"
 #include "squirrel_helper_type.hpp"
+#include "script_thread.hpp"
 
 template <class CL, ScriptType ST> const char *GetClassName();
 
@@ -240,6 +241,7 @@ namespace SQConvert {
 		/* Remove the userdata from the stack */
 		sq_pop(vm, 1);
 
+		ScriptGameStateScope game_state;
 		try {
 			/* Delegate it to a template that can handle this specific function */
 			return HelperT<Tmethod>::SQCall((Tcls *)real_instance, *(Tmethod *)ptr, vm);
@@ -282,6 +284,7 @@ namespace SQConvert {
 		/* Remove the userdata from the stack */
 		sq_pop(vm, 1);
 
+		ScriptGameStateScope game_state;
 		/* Call the function, which its only param is always the VM */
 		return (SQInteger)(((Tcls *)real_instance)->*(*(Tmethod *)ptr))(vm);
 	}
@@ -301,6 +304,7 @@ namespace SQConvert {
 		/* Get the real function pointer */
 		sq_getuserdata(vm, nparam, &ptr, nullptr);
 
+		ScriptGameStateScope game_state;
 		try {
 			/* Delegate it to a template that can handle this specific function */
 			return HelperT<Tmethod>::SQCall((Tcls *)nullptr, *(Tmethod *)ptr, vm);
@@ -327,6 +331,7 @@ namespace SQConvert {
 		/* Remove the userdata from the stack */
 		sq_pop(vm, 1);
 
+		ScriptGameStateScope game_state;
 		/* Call the function, which its only param is always the VM */
 		return (SQInteger)(*(*(Tmethod *)ptr))(vm);
 	}
@@ -339,6 +344,7 @@ namespace SQConvert {
 	static SQInteger DefSQDestructorCallback(SQUserPointer p, SQInteger size)
 	{
 		/* Remove the real instance too */
+		ScriptGameStateScope game_state;
 		if (p != nullptr) ((Tcls *)p)->Release();
 		return 0;
 	}
@@ -352,6 +358,8 @@ namespace SQConvert {
 	inline SQInteger DefSQConstructorCallback(HSQUIRRELVM vm)
 	{
 		try {
+			ScriptGameStateScope game_state;
+
 			/* Create the real instance */
 			Tcls *instance = HelperT<Tmethod>::SQConstruct((Tcls *)nullptr, (Tmethod)nullptr, vm);
 			sq_setinstanceup(vm, -Tnparam, instance);
@@ -371,6 +379,8 @@ namespace SQConvert {
 	inline SQInteger DefSQAdvancedConstructorCallback(HSQUIRRELVM vm)
 	{
 		try {
+			ScriptGameStateScope game_state;
+
 			/* Find the amount of params we got */
 			int nparam = sq_gettop(vm);
 
@@ -201,6 +201,7 @@ struct GUISettings {
 	uint8  settings_restriction_mode;        ///< selected restriction mode in adv. settings GUI. @see RestrictionMode
 	bool   newgrf_show_old_versions;         ///< whether to show old versions in the NewGRF list
 	uint8  newgrf_default_palette;           ///< default palette to use for NewGRFs without action 14 palette information
+	bool   newgrf_resolver_cache;            ///< reuse results of resolving NewGRF callbacks within a tick when the variables they read did not change
 
 	bool   scale_bevels;                     ///< bevels are scaled with GUI scale.
 
@@ -274,6 +275,7 @@ struct NewsSettings {
 /** All settings related to the network. */
 struct NetworkSettings {
 	uint16      sync_freq;                                ///< how often do we check whether we are still in-sync
+	bool        sync_state_hash;                          ///< send hashes of the game state along with the sync checks
 	uint8       frame_freq;                               ///< how often do we send commands to the clients
 	uint16      commands_per_frame;                       ///< how many commands may be sent each frame_freq frames?
 	uint16      max_commands_in_queue;                    ///< how many commands may there be in the incoming queue before dropping the connection?
@@ -329,6 +331,7 @@ struct GameCreationSettings {
 	byte   tgen_smoothness;                  ///< how rough is the terrain from 0-3
 	byte   tree_placer;                      ///< the tree placer algorithm
 	byte   heightmap_rotation;               ///< rotation director for the heightmap
+	bool   heightmap_interpolation;          ///< interpolate between the pixels of the heightmap instead of using the nearest one
 	byte   se_flat_world_height;             ///< land height a flat world gets in SE
 	byte   town_name;                        ///< the town name generator used for town names
 	byte   landscape;                        ///< the landscape we're currently in
@@ -373,6 +376,7 @@ struct ConstructionSettings {
 /** Settings related to the AI. */
 struct AISettings {
 	bool   ai_in_multiplayer;                ///< so we allow AIs in multiplayer
+	bool   ai_threads;                       ///< run the AIs on threads of their own
 	bool   ai_disable_veh_train;             ///< disable types for AI
 	bool   ai_disable_veh_roadveh;           ///< disable types for AI
 	bool   ai_disable_veh_aircraft;          ///< disable types for AI
@@ -23,6 +23,8 @@
 #include "company_base.h"
 #include "guitimer_func.h"
 #include "zoom_func.h"
+#include "screenshot.h"
+#include "tile_journal.h"
 
 #include "smallmap_gui.h"
 
@@ -345,6 +347,9 @@ void BuildOwnerLegend()
 
 	/* Store maximum amount of owner legend entries. */
 	_smallmap_company_count = i;
+
+	/* The colours of the owners are in the tiled minimap screenshots too. */
+	MarkAllMinimapTilesDirty();
 }
 
 struct AndOr {
@@ -745,61 +750,70 @@ void SmallMapWindow::SetZoomLevel(ZoomLevelChange change, const Point *zoom_pt)
 	}
 }
 
+/** Importance of a tile of which the colour overrides those of all other tiles in its group. */
+static const uint8 SMALLMAP_IMPORTANCE_OVERRIDE = UINT8_MAX;
+
 /**
- * Decide which colours to show to the user for a group of tiles.
- * @param ta Tile area to investigate.
- * @return Colours to display.
+ * Decide how important it is to show a tile to the user.
+ * @param tile Tile to investigate.
+ * @param[out] et Effective tile type to show the tile as.
+ * @param[out] colour Colours to display, when the tile overrides the others in its group.
+ * @return Importance of the tile (higher number means more interesting to show), or #SMALLMAP_IMPORTANCE_OVERRIDE.
  */
-inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
+inline uint8 SmallMapWindow::GetTileImportance(TileIndex tile, TileType *et, uint32 *colour) const
 {
-	int importance = 0;
-	TileIndex tile = INVALID_TILE; // Position of the most important tile.
-	TileType et = MP_VOID;         // Effective tile type at that position.
-
-	for (TileIndex ti : ta) {
-		TileType ttype = GetTileType(ti);
+	TileType ttype = GetTileType(tile);
 
-		switch (ttype) {
-			case MP_TUNNELBRIDGE: {
-				TransportType tt = GetTunnelBridgeTransportType(ti);
+	switch (ttype) {
+		case MP_TUNNELBRIDGE: {
+			TransportType tt = GetTunnelBridgeTransportType(tile);
 
-				switch (tt) {
-					case TRANSPORT_RAIL: ttype = MP_RAILWAY; break;
-					case TRANSPORT_ROAD: ttype = MP_ROAD;    break;
-					default:             ttype = MP_WATER;   break;
-				}
-				break;
+			switch (tt) {
+				case TRANSPORT_RAIL: ttype = MP_RAILWAY; break;
+				case TRANSPORT_ROAD: ttype = MP_ROAD;    break;
+				default:             ttype = MP_WATER;   break;
 			}
+			break;
+		}
 
-			case MP_INDUSTRY:
-				/* Special handling of industries while in "Industries" smallmap view. */
-				if (this->map_type == SMT_INDUSTRY) {
-					/* If industry is allowed to be seen, use its colour on the map.
-					 * This has the highest priority above any value in _tiletype_importance. */
-					IndustryType type = Industry::GetByTile(ti)->type;
-					if (_legend_from_industries[_industry_to_list_pos[type]].show_on_map) {
-						if (type == _smallmap_industry_highlight) {
-							if (_smallmap_industry_highlight_state) return MKCOLOUR_XXXX(PC_WHITE);
-						} else {
-							return GetIndustrySpec(type)->map_colour * 0x01010101;
+		case MP_INDUSTRY:
+			/* Special handling of industries while in "Industries" smallmap view. */
+			if (this->map_type == SMT_INDUSTRY) {
+				/* If industry is allowed to be seen, use its colour on the map.
+				 * This has the highest priority above any value in _tiletype_importance. */
+				IndustryType type = Industry::GetByTile(tile)->type;
+				if (_legend_from_industries[_industry_to_list_pos[type]].show_on_map) {
+					if (type == _smallmap_industry_highlight) {
+						if (_smallmap_industry_highlight_state) {
+							*colour = MKCOLOUR_XXXX(PC_WHITE);
+							return SMALLMAP_IMPORTANCE_OVERRIDE;
 						}
+					} else {
+						*colour = GetIndustrySpec(type)->map_colour * 0x01010101;
+						return SMALLMAP_IMPORTANCE_OVERRIDE;
 					}
-					/* Otherwise make it disappear */
-					ttype = IsTileOnWater(ti) ? MP_WATER : MP_CLEAR;
 				}
-				break;
-
-			default:
-				break;
-		}
+				/* Otherwise make it disappear */
+				ttype = IsTileOnWater(tile) ? MP_WATER : MP_CLEAR;
+			}
+			break;
 
-		if (_tiletype_importance[ttype] > importance) {
-			importance = _tiletype_importance[ttype];
-			tile = ti;
-			et = ttype;
-		}
+		default:
+			break;
 	}
 
+	*et = ttype;
+	return _tiletype_importance[ttype];
+}
+
+/**
+ * Decide which colours to show to the user for a tile.
+ * @param tile Tile to investigate.
+ * @param et Effective tile type to show the tile as.
+ * @return Colours to display.
+ */
+inline uint32 SmallMapWindow::GetEffectiveTileColours(TileIndex tile, TileType et) const
+{
 	switch (this->map_type) {
 		case SMT_CONTOUR:
 			return GetSmallMapContoursPixels(tile, et);
@@ -826,6 +840,180 @@ inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
 	}
 }
 
+/**
+ * Decide which colours to show to the user for a group of tiles.
+ * @param ta Tile area to investigate.
+ * @return Colours to display.
+ */
+inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
+{
+	int importance = 0;
+	TileIndex tile = INVALID_TILE; // Position of the most important tile.
+	TileType et = MP_VOID;         // Effective tile type at that position.
+
+	for (TileIndex ti : ta) {
+		TileType ttype;
+		uint32 colour;
+		uint8 ti_importance = this->GetTileImportance(ti, &ttype, &colour);
+		if (ti_importance == SMALLMAP_IMPORTANCE_OVERRIDE) return colour;
+
+		if (ti_importance > importance) {
+			importance = ti_importance;
+			tile = ti;
+			et = ttype;
+		}
+	}
+
+	return this->GetEffectiveTileColours(tile, et);
+}
+
+/** Number of tiles along the edge of a block of tiles of which the cached colours are updated together. */
+static const uint SMALLMAP_CACHE_BLOCK_SIZE = 16;
+/** Every refresh of the window the cached colours of this part of the blocks are updated, for the changes of the map that were not marked. */
+static const uint SMALLMAP_CACHE_SCRUB_FRACTION = 256;
+
+/* The blocks of the journal have to lie within one block of the cached colours. */
+static_assert(SMALLMAP_CACHE_BLOCK_SIZE % TILE_JOURNAL_BLOCK_SIZE == 0);
+
+/**
+ * Get the block of tiles of the cached colours of a tile.
+ * @param tile The tile.
+ * @return Index of the block.
+ */
+static inline uint GetSmallMapCacheBlock(TileIndex tile)
+{
+	return TileY(tile) / SMALLMAP_CACHE_BLOCK_SIZE * (MapSizeX() / SMALLMAP_CACHE_BLOCK_SIZE) + TileX(tile) / SMALLMAP_CACHE_BLOCK_SIZE;
+}
+
+/** Mark the cached colours of the tiles that changed since the last time dirty, for all map types. */
+void SmallMapWindow::ReadTileChanges() const
+{
+	this->tile_journal.Start();
+	bool complete = this->tile_journal.ReadChanges([this](TileIndex tile) {
+		for (SmallMapTileCache &cache : this->tile_caches) {
+			if (cache.valid) cache.dirty[GetSmallMapCacheBlock(tile)] = true;
+		}
+	});
+	if (!complete) this->MarkTileCachesDirty();
+}
+
+/** Mark the cached colours of all tiles dirty, for all map types. */
+void SmallMapWindow::MarkTileCachesDirty() const
+{
+	for (SmallMapTileCache &cache : this->tile_caches) {
+		if (cache.valid) cache.dirty.assign(cache.dirty.size(), true);
+	}
+}
+
+/** Mark a part of the cached colours dirty, so changes of the map that were not marked are shown eventually too. */
+void SmallMapWindow::ScrubTileCaches()
+{
+	uint blocks = MapSize() / (SMALLMAP_CACHE_BLOCK_SIZE * SMALLMAP_CACHE_BLOCK_SIZE);
+	for (uint i = std::max(1U, blocks / SMALLMAP_CACHE_SCRUB_FRACTION); i > 0; i--) {
+		this->cache_scrub_block = (this->cache_scrub_block + 1) % blocks;
+		for (SmallMapTileCache &cache : this->tile_caches) {
+			if (cache.valid) cache.dirty[this->cache_scrub_block] = true;
+		}
+	}
+}
+
+/**
+ * Get the key of the legend and settings the colours of the tiles depend on for the current map type.
+ * @return The key.
+ */
+uint64 SmallMapWindow::GetTileCacheKey() const
+{
+	/* FNV-1a over all values. */
+	uint64 key = 0xCBF29CE484222325ULL;
+	auto add = [&key](uint64 value) { key = (key ^ value) * 0x100000001B3ULL; };
+
+	add(MapSize());
+	add(_settings_client.gui.smallmap_land_colour);
+	add(_smallmap_show_heightmap);
+	add(SmallMapWindow::map_height_limit);
+
+	switch (this->map_type) {
+		case SMT_INDUSTRY:
+			for (int i = 0; i < _smallmap_industry_count; i++) {
+				add(_legend_from_industries[i].type);
+				add(_legend_from_industries[i].show_on_map);
+			}
+			break;
+
+		case SMT_OWNER:
+			for (int i = 0; i < _smallmap_company_count; i++) {
+				add(_legend_land_owners[i].colour);
+				add(_legend_land_owners[i].company);
+				add(_legend_land_owners[i].show_on_map);
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	return key;
+}
+
+/** Update the cached colours of the tiles that changed for the current map type. */
+void SmallMapWindow::UpdateTileCache() const
+{
+	this->ReadTileChanges();
+
+	SmallMapTileCache &cache = this->tile_caches[this->map_type];
+
+	uint64 key = this->GetTileCacheKey();
+	uint blocks_x = MapSizeX() / SMALLMAP_CACHE_BLOCK_SIZE;
+	uint blocks_y = MapSizeY() / SMALLMAP_CACHE_BLOCK_SIZE;
+	if (!cache.valid || cache.key != key) {
+		cache.colours.resize(MapSize());
+		cache.importance.resize(MapSize());
+		cache.dirty.assign(blocks_x * blocks_y, true);
+		cache.key = key;
+		cache.valid = true;
+	}
+
+	for (uint block = 0; block < blocks_x * blocks_y; block++) {
+		if (!cache.dirty[block]) continue;
+		cache.dirty[block] = false;
+
+		TileArea ta(TileXY(block % blocks_x * SMALLMAP_CACHE_BLOCK_SIZE, block / blocks_x * SMALLMAP_CACHE_BLOCK_SIZE), SMALLMAP_CACHE_BLOCK_SIZE, SMALLMAP_CACHE_BLOCK_SIZE);
+		for (TileIndex tile : ta) {
+			TileType et;
+			uint32 colour;
+			cache.importance[tile] = this->GetTileImportance(tile, &et, &colour);
+			cache.colours[tile] = cache.importance[tile] == SMALLMAP_IMPORTANCE_OVERRIDE ? colour : this->GetEffectiveTileColours(tile, et);
+		}
+	}
+}
+
+/**
+ * Decide which colours to show to the user for a group of tiles, from the cached colours of the tiles.
+ * The most important tile of the group is chosen in the same way as by #GetTileColours.
+ * @param ta Tile area to investigate.
+ * @return Colours to display.
+ * @pre The cached colours are up to date, see #UpdateTileCache.
+ */
+inline uint32 SmallMapWindow::GetCachedTileColours(const TileArea &ta) const
+{
+	const SmallMapTileCache &cache = this->tile_caches[this->map_type];
+
+	uint8 importance = 0;
+	TileIndex tile = INVALID_TILE; // Position of the most important tile.
+
+	for (TileIndex ti : ta) {
+		uint8 ti_importance = cache.importance[ti];
+		if (ti_importance == SMALLMAP_IMPORTANCE_OVERRIDE) return cache.colours[ti];
+
+		if (ti_importance > importance) {
+			importance = ti_importance;
+			tile = ti;
+		}
+	}
+
+	return cache.colours[tile];
+}
+
 /**
  * Draws one column of tiles of the small map in a certain mode onto the screen buffer, skipping the shifted rows in between.
  *
@@ -837,9 +1025,10 @@ inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
  * @param start_pos Position of first pixel to draw.
  * @param end_pos Position of last pixel to draw (exclusive).
  * @param blitter current blitter
+ * @param cached Whether to take the colours from the cached colours of the tiles.
  * @note If pixel position is below \c 0, skip drawing.
  */
-void SmallMapWindow::DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch, int reps, int start_pos, int end_pos, Blitter *blitter) const
+void SmallMapWindow::DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch, int reps, int start_pos, int end_pos, Blitter *blitter, bool cached) const
 {
 	void *dst_ptr_abs_end = blitter->MoveTo(_screen.dst_ptr, 0, _screen.height);
 	uint min_xy = _settings_game.construction.freeform_edges ? 1 : 0;
@@ -863,7 +1052,7 @@ void SmallMapWindow::DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch,
 		}
 		ta.ClampToMap(); // Clamp to map boundaries (may contain MP_VOID tiles!).
 
-		uint32 val = this->GetTileColours(ta);
+		uint32 val = cached ? this->GetCachedTileColours(ta) : this->GetTileColours(ta);
 		uint8 *val8 = (uint8 *)&val;
 		int idx = std::max(0, -start_pos);
 		for (int pos = std::max(0, start_pos); pos < end_pos; pos++) {
@@ -983,6 +1172,10 @@ void SmallMapWindow::DrawSmallMap(DrawPixelInfo *dpi) const
 	/* Clear it */
 	GfxFillRect(dpi->left, dpi->top, dpi->left + dpi->width - 1, dpi->top + dpi->height - 1, PC_BLACK);
 
+	/* The blinking highlighted industry changes the colours too often to cache them. */
+	bool cached = this->map_type != SMT_INDUSTRY || _smallmap_industry_highlight == INVALID_INDUSTRYTYPE;
+	if (cached) this->UpdateTileCache();
+
 	/* Which tile is displayed at (dpi->left, dpi->top)? */
 	int dx;
 	Point tile = this->PixelToTile(dpi->left, dpi->top, &dx);
@@ -1001,7 +1194,7 @@ void SmallMapWindow::DrawSmallMap(DrawPixelInfo *dpi) const
 			int end_pos = std::min(dpi->width, x + 4);
 			int reps = (dpi->height - y + 1) / 2; // Number of lines.
 			if (reps > 0) {
-				this->DrawSmallMapColumn(ptr, tile_x, tile_y, dpi->pitch * 2, reps, x, end_pos, blitter);
+				this->DrawSmallMapColumn(ptr, tile_x, tile_y, dpi->pitch * 2, reps, x, end_pos, blitter, cached);
 			}
 		}
 
@@ -1084,7 +1277,9 @@ SmallMapWindow::SmallMapWindow(WindowDesc *desc, int window_number) :
 		Window(desc),
 		row_height(std::max(GetMinButtonSize(FONT_HEIGHT_SMALL) * 2 / 3, uint(FONT_HEIGHT_SMALL))), // Default spacing makes legend too tall - shrink it by 1/3
 		show_legend(false),
-		refresh(GUITimer(FORCE_REFRESH_PERIOD))
+		refresh(GUITimer(FORCE_REFRESH_PERIOD)),
+		tile_caches(lengthof(_legend_table)),
+		cache_scrub_block(0)
 {
 	_smallmap_industry_highlight = INVALID_INDUSTRYTYPE;
 	this->overlay = new LinkGraphOverlay(this, WID_SM_MAP, 0, this->GetOverlayCompanyMask(), 1);
@@ -1111,6 +1306,7 @@ SmallMapWindow::~SmallMapWindow()
 /* virtual */ void SmallMapWindow::Close()
 {
 	this->BreakIndustryChainLink();
+	this->tile_journal.Stop();
 	this->Window::Close();
 }
 
@@ -1628,6 +1824,8 @@ void SmallMapWindow::ShowLegend(bool show)
 	/* Update the window every now and then */
 	if (!this->refresh.Elapsed(delta_ms)) return;
 
+	this->ScrubTileCaches();
+
 	if (this->map_type == SMT_LINKSTATS) {
 		uint32 company_mask = this->GetOverlayCompanyMask();
 		if (this->overlay->GetCompanyMask() != company_mask) {
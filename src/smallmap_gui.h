@@ -18,6 +18,7 @@
 #include "linkgraph/linkgraph_gui.h"
 #include "widgets/smallmap_widget.h"
 #include "guitimer_func.h"
+#include "tile_journal.h"
 
 /* set up the cargos to be displayed in the smallmap's route legend */
 void BuildLinkStatsLegend();
@@ -48,6 +49,15 @@ struct LegendAndColour {
 	bool col_break;            ///< Perform a column break and go further at the next column.
 };
 
+/** Cached importance and colours of every tile of the map, for one map type. */
+struct SmallMapTileCache {
+	std::vector<uint32> colours;   ///< Colours to display of every tile.
+	std::vector<uint8> importance; ///< Importance of every tile, see #SmallMapWindow::GetTileImportance.
+	std::vector<bool> dirty;       ///< For every block of tiles, row by row, whether its cached colours have to be updated.
+	uint64 key = 0;                ///< Key of the legend and settings the colours are for, see #SmallMapWindow::GetTileCacheKey.
+	bool valid = false;            ///< Whether the cache has been filled.
+};
+
 /** Class managing the smallmap window. */
 class SmallMapWindow : public Window {
 protected:
@@ -93,6 +103,10 @@ protected:
 	GUITimer refresh; ///< Refresh timer.
 	LinkGraphOverlay *overlay;
 
+	mutable std::vector<SmallMapTileCache> tile_caches; ///< Cached colours of the tiles for every map type.
+	mutable TileJournalReader tile_journal;             ///< Changes of the map for the cached colours.
+	uint cache_scrub_block;                             ///< Next block of tiles of which the cached colours are updated by #ScrubTileCaches.
+
 	static void BreakIndustryChainLink();
 	Point SmallmapRemapCoords(int x, int y) const;
 
@@ -167,7 +181,7 @@ protected:
 	void SetNewScroll(int sx, int sy, int sub);
 
 	void DrawMapIndicators() const;
-	void DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch, int reps, int start_pos, int end_pos, Blitter *blitter) const;
+	void DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch, int reps, int start_pos, int end_pos, Blitter *blitter, bool cached) const;
 	void DrawVehicles(const DrawPixelInfo *dpi, Blitter *blitter) const;
 	void DrawTowns(const DrawPixelInfo *dpi) const;
 	void DrawSmallMap(DrawPixelInfo *dpi) const;
@@ -178,7 +192,15 @@ protected:
 	void SetZoomLevel(ZoomLevelChange change, const Point *zoom_pt);
 	void SetOverlayCargoMask();
 	void SetupWidgetData();
+	uint8 GetTileImportance(TileIndex tile, TileType *et, uint32 *colour) const;
+	uint32 GetEffectiveTileColours(TileIndex tile, TileType et) const;
 	uint32 GetTileColours(const TileArea &ta) const;
+	uint64 GetTileCacheKey() const;
+	void ReadTileChanges() const;
+	void MarkTileCachesDirty() const;
+	void ScrubTileCaches();
+	void UpdateTileCache() const;
+	uint32 GetCachedTileColours(const TileArea &ta) const;
 
 	int GetPositionOnLegend(Point pt);
 
@@ -18,6 +18,7 @@
 #include "core/math_func.hpp"
 #include "core/mem_func.hpp"
 #include "video/video_driver.hpp"
+#include "thread.h"
 
 #include "table/sprites.h"
 #include "table/strings.h"
@@ -536,7 +537,12 @@ struct GrfSpriteOffset {
 };
 
 /** Map from sprite numbers to position in the GRF file. */
-static std::map<uint32, GrfSpriteOffset> _grf_sprite_offsets;
+typedef std::map<uint32, GrfSpriteOffset> GrfSpriteOffsets;
+
+/** Sprite section indices of the cached sprite files, so each file only has to be parsed once. */
+static std::map<const SpriteFile *, GrfSpriteOffsets> _grf_sprite_offsets_cache;
+/** Sprite section index of the GRF currently being loaded. */
+static const GrfSpriteOffsets *_grf_sprite_offsets = nullptr;
 
 /**
  * Get the file offset for a specific sprite in the sprite section of a GRF.
@@ -545,58 +551,110 @@ static std::map<uint32, GrfSpriteOffset> _grf_sprite_offsets;
  */
 size_t GetGRFSpriteOffset(uint32 id)
 {
-	return _grf_sprite_offsets.find(id) != _grf_sprite_offsets.end() ? _grf_sprite_offsets[id].file_pos : SIZE_MAX;
+	if (_grf_sprite_offsets == nullptr) return SIZE_MAX;
+	auto iter = _grf_sprite_offsets->find(id);
+	return iter != _grf_sprite_offsets->end() ? iter->second.file_pos : SIZE_MAX;
 }
 
 /**
- * Parse the sprite section of GRFs.
- * @param container_version Container version of the GRF we're currently processing.
+ * Parse the sprite section of a GRF, starting at the sprite section offset at the current position.
+ * The position of the file is restored afterwards.
+ * @param file The file to parse.
+ * @param[out] offsets The positions of the sprites in the file.
  */
-void ReadGRFSpriteOffsets(SpriteFile &file)
+static void ParseGRFSpriteOffsets(SpriteFile &file, GrfSpriteOffsets &offsets)
 {
-	_grf_sprite_offsets.clear();
-
-	if (file.GetContainerVersion() >= 2) {
-		/* Seek to sprite section of the GRF. */
-		size_t data_offset = file.ReadDword();
-		size_t old_pos = file.GetPos();
-		file.SeekTo(data_offset, SEEK_CUR);
-
-		GrfSpriteOffset offset = { 0, 0 };
-
-		/* Loop over all sprite section entries and store the file
-		 * offset for each newly encountered ID. */
-		uint32 id, prev_id = 0;
-		while ((id = file.ReadDword()) != 0) {
-			if (id != prev_id) {
-				_grf_sprite_offsets[prev_id] = offset;
-				offset.file_pos = file.GetPos() - 4;
-				offset.control_flags = 0;
-			}
-			prev_id = id;
-			uint length = file.ReadDword();
+	/* Seek to sprite section of the GRF. */
+	size_t data_offset = file.ReadDword();
+	size_t old_pos = file.GetPos();
+	file.SeekTo(data_offset, SEEK_CUR);
+
+	GrfSpriteOffset offset = { 0, 0 };
+
+	/* Loop over all sprite section entries and store the file
+	 * offset for each newly encountered ID. */
+	uint32 id, prev_id = 0;
+	while ((id = file.ReadDword()) != 0) {
+		if (id != prev_id) {
+			offsets[prev_id] = offset;
+			offset.file_pos = file.GetPos() - 4;
+			offset.control_flags = 0;
+		}
+		prev_id = id;
+		uint length = file.ReadDword();
+		if (length > 0) {
+			byte colour = file.ReadByte() & SCC_MASK;
+			length--;
 			if (length > 0) {
-				byte colour = file.ReadByte() & SCC_MASK;
+				byte zoom = file.ReadByte();
 				length--;
-				if (length > 0) {
-					byte zoom = file.ReadByte();
-					length--;
-					if (colour != 0 && zoom == 0) { // ZOOM_LVL_OUT_4X (normal zoom)
-						SetBit(offset.control_flags, (colour != SCC_PAL) ? SCCF_ALLOW_ZOOM_MIN_1X_32BPP : SCCF_ALLOW_ZOOM_MIN_1X_PAL);
-						SetBit(offset.control_flags, (colour != SCC_PAL) ? SCCF_ALLOW_ZOOM_MIN_2X_32BPP : SCCF_ALLOW_ZOOM_MIN_2X_PAL);
-					}
-					if (colour != 0 && zoom == 2) { // ZOOM_LVL_OUT_2X (2x zoomed in)
-						SetBit(offset.control_flags, (colour != SCC_PAL) ? SCCF_ALLOW_ZOOM_MIN_2X_32BPP : SCCF_ALLOW_ZOOM_MIN_2X_PAL);
-					}
+				if (colour != 0 && zoom == 0) { // ZOOM_LVL_OUT_4X (normal zoom)
+					SetBit(offset.control_flags, (colour != SCC_PAL) ? SCCF_ALLOW_ZOOM_MIN_1X_32BPP : SCCF_ALLOW_ZOOM_MIN_1X_PAL);
+					SetBit(offset.control_flags, (colour != SCC_PAL) ? SCCF_ALLOW_ZOOM_MIN_2X_32BPP : SCCF_ALLOW_ZOOM_MIN_2X_PAL);
+				}
+				if (colour != 0 && zoom == 2) { // ZOOM_LVL_OUT_2X (2x zoomed in)
+					SetBit(offset.control_flags, (colour != SCC_PAL) ? SCCF_ALLOW_ZOOM_MIN_2X_32BPP : SCCF_ALLOW_ZOOM_MIN_2X_PAL);
 				}
 			}
-			file.SkipBytes(length);
 		}
-		if (prev_id != 0) _grf_sprite_offsets[prev_id] = offset;
+		file.SkipBytes(length);
+	}
+	if (prev_id != 0) offsets[prev_id] = offset;
+
+	/* Continue processing the data section. */
+	file.SeekTo(old_pos, SEEK_SET);
+}
+
+/**
+ * Parse the sprite section of GRFs.
+ * The sprite section of a cached sprite file is only parsed once.
+ * @param file The GRF we're currently processing.
+ */
+void ReadGRFSpriteOffsets(SpriteFile &file)
+{
+	_grf_sprite_offsets = nullptr;
+
+	if (file.GetContainerVersion() >= 2) {
+		if (GetCachedSpriteFileByName(file.GetFilename()) != &file) {
+			/* Not a cached file, so it could be gone before the next lookup. */
+			static GrfSpriteOffsets offsets;
+			offsets.clear();
+			ParseGRFSpriteOffsets(file, offsets);
+			_grf_sprite_offsets = &offsets;
+			return;
+		}
+
+		auto iter = _grf_sprite_offsets_cache.find(&file);
+		if (iter != _grf_sprite_offsets_cache.end()) {
+			/* Skip sprite section offset; it has been parsed before. */
+			file.ReadDword();
+		} else {
+			iter = _grf_sprite_offsets_cache.emplace(&file, GrfSpriteOffsets()).first;
+			ParseGRFSpriteOffsets(file, iter->second);
+		}
+		_grf_sprite_offsets = &iter->second;
+	}
+}
 
-		/* Continue processing the data section. */
-		file.SeekTo(old_pos, SEEK_SET);
+/**
+ * Parse the sprite sections of all cached sprite files that have not been parsed yet.
+ * The files are independent, so they are parsed in parallel.
+ */
+void ReadAllGRFSpriteOffsets()
+{
+	std::vector<std::pair<SpriteFile *, GrfSpriteOffsets *>> todo;
+	for (auto &f : _sprite_files) {
+		if (f->GetContainerVersion() < 2 || _grf_sprite_offsets_cache.count(f.get()) != 0) continue;
+		todo.emplace_back(f.get(), &_grf_sprite_offsets_cache[f.get()]);
 	}
+
+	ParallelFor("ottd:grfoffsets", todo.size(), [&todo](size_t i) {
+		SpriteFile &file = *todo[i].first;
+		size_t pos = file.GetPos();
+		file.SeekToBegin();
+		ParseGRFSpriteOffsets(file, *todo[i].second);
+		file.SeekTo(pos, SEEK_SET);
+	});
 }
 
 
@@ -636,8 +694,8 @@ bool LoadNextSprite(int load_index, SpriteFile &file, uint file_sprite_id)
 			return false;
 		}
 		/* It is not an error if no sprite with the provided ID is found in the sprite section. */
-		auto iter = _grf_sprite_offsets.find(file.ReadDword());
-		if (iter != _grf_sprite_offsets.end()) {
+		auto iter = _grf_sprite_offsets->find(file.ReadDword());
+		if (iter != _grf_sprite_offsets->end()) {
 			file_pos = iter->second.file_pos;
 			control_flags = iter->second.control_flags;
 		} else {
@@ -1032,6 +1090,8 @@ void GfxInitSpriteMem()
 	_spritecache = nullptr;
 
 	_compact_cache_counter = 0;
+	_grf_sprite_offsets_cache.clear();
+	_grf_sprite_offsets = nullptr;
 	_sprite_files.clear();
 }
 
@@ -63,6 +63,7 @@ void IncreaseSpriteLRU();
 SpriteFile &OpenCachedSpriteFile(const std::string &filename, Subdirectory subdir, bool palette_remap);
 
 void ReadGRFSpriteOffsets(SpriteFile &file);
+void ReadAllGRFSpriteOffsets();
 size_t GetGRFSpriteOffset(uint32 id);
 bool LoadNextSprite(int load_index, SpriteFile &file, uint file_sprite_id);
 bool SkipSpriteData(SpriteFile &file, byte type, uint16 num);
@@ -0,0 +1,222 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file state_hash.cpp Hashing of the game state, e.g. to find out where a desync happened. */
+
+#include "stdafx.h"
+#include "state_hash.h"
+#include "map_func.h"
+#include "vehicle_base.h"
+#include "station_base.h"
+#include "company_base.h"
+#include "town.h"
+#include "industry.h"
+#include "pbs.h"
+#include "tile_journal.h"
+
+#include "safeguards.h"
+
+/** Simple 64 bit hash over a sequence of values; not cryptographic, just sensitive to every bit. */
+class StateHasher {
+	uint64 hash = 0xCBF29CE484222325ULL; ///< The hash so far.
+
+public:
+	/**
+	 * Add a value to the hash.
+	 * @param value The value.
+	 */
+	inline void Add(uint64 value)
+	{
+		this->hash = (this->hash ^ value) * 0x100000001B3ULL;
+		this->hash ^= this->hash >> 32;
+	}
+
+	/**
+	 * Get the hash of all values added so far.
+	 * @return The hash, folded into 32 bits.
+	 */
+	inline uint32 Result() const
+	{
+		return (uint32)(this->hash ^ (this->hash >> 32));
+	}
+};
+
+/**
+ * Hash the parts of a tile that are told to the journal of changed tiles whenever they change:
+ * the type, the owner and the reserved tracks.
+ * @param tile The tile.
+ * @return The value to add to the hash.
+ */
+static uint64 GetTileStateValue(TileIndex tile)
+{
+	TileType type = GetTileType(tile);
+	uint64 value = type;
+	if (type != MP_VOID && type != MP_HOUSE && type != MP_INDUSTRY) value |= (uint64)GetTileOwner(tile) << 8;
+	return value | (uint64)GetReservedTrackbits(tile) << 16;
+}
+
+/**
+ * Hash all tiles of a block of the journal of changed tiles.
+ * @param north The northern tile of the block.
+ * @return The hash of the block.
+ */
+static uint32 HashMapBlock(TileIndex north)
+{
+	StateHasher h;
+	h.Add(north);
+	for (uint y = 0; y < TILE_JOURNAL_BLOCK_SIZE; y++) {
+		for (uint x = 0; x < TILE_JOURNAL_BLOCK_SIZE; x++) {
+			h.Add(GetTileStateValue(north + TileXY(x, y)));
+		}
+	}
+	return h.Result();
+}
+
+static TileJournalReader _map_hash_journal; ///< Reader of the changed tiles, so only the blocks that changed are hashed again.
+static std::vector<uint32> _map_block_hashes; ///< Hash of every block of tiles.
+static uint32 _map_hash; ///< Sum of the hashes of all blocks.
+
+/**
+ * Hash the tiles of the map.
+ * Only the blocks of tiles that changed since the previous time are hashed again,
+ * so only the parts of tiles of which every change is told to the journal are hashed.
+ * @return The hash of the map.
+ */
+static uint32 HashMap()
+{
+	const uint blocks_x = MapSizeX() / TILE_JOURNAL_BLOCK_SIZE;
+	auto rehash_block = [blocks_x](TileIndex north) {
+		uint32 &block = _map_block_hashes[TileY(north) / TILE_JOURNAL_BLOCK_SIZE * blocks_x + TileX(north) / TILE_JOURNAL_BLOCK_SIZE];
+		_map_hash -= block;
+		block = HashMapBlock(north);
+		_map_hash += block;
+	};
+
+	/* Hash all blocks again when starting, when changes were dropped or when the map was replaced. */
+	bool complete = false;
+	if (_map_hash_journal.IsReading()) {
+		complete = _map_hash_journal.ReadChanges(rehash_block);
+	} else {
+		_map_hash_journal.Start();
+	}
+
+	if (!complete) {
+		_map_block_hashes.assign(MapSize() / (TILE_JOURNAL_BLOCK_SIZE * TILE_JOURNAL_BLOCK_SIZE), 0);
+		_map_hash = 0;
+		for (uint y = 0; y < MapSizeY(); y += TILE_JOURNAL_BLOCK_SIZE) {
+			for (uint x = 0; x < MapSizeX(); x += TILE_JOURNAL_BLOCK_SIZE) rehash_block(TileXY(x, y));
+		}
+	}
+	return _map_hash;
+}
+
+/** Hash the position, speed and cargo of all vehicles. */
+static uint32 HashVehicles()
+{
+	StateHasher h;
+	for (const Vehicle *v : Vehicle::Iterate()) {
+		h.Add(v->index);
+		h.Add(v->tile);
+		h.Add((uint32)v->x_pos | (uint64)(uint32)v->y_pos << 32);
+		h.Add((uint32)v->z_pos | (uint64)v->direction << 32 | (uint64)v->progress << 40 | (uint64)v->cur_speed << 48);
+		h.Add(v->cargo.TotalCount());
+	}
+	return h.Result();
+}
+
+/** Hash the cargo waiting at all stations and its rating. */
+static uint32 HashStations()
+{
+	StateHasher h;
+	for (const Station *st : Station::Iterate()) {
+		h.Add(st->index);
+		for (CargoID c = 0; c < NUM_CARGO; c++) {
+			const GoodsEntry &ge = st->goods[c];
+			h.Add(ge.cargo.TotalCount() | (uint64)ge.rating << 32);
+		}
+	}
+	return h.Result();
+}
+
+/** Hash the money and loans of all companies. */
+static uint32 HashCompanies()
+{
+	StateHasher h;
+	for (const Company *c : Company::Iterate()) {
+		h.Add(c->index);
+		h.Add((int64)c->money);
+		h.Add((int64)c->current_loan);
+	}
+	return h.Result();
+}
+
+/** Hash the population and growth of all towns. */
+static uint32 HashTowns()
+{
+	StateHasher h;
+	for (const Town *t : Town::Iterate()) {
+		h.Add(t->index);
+		h.Add(t->cache.population | (uint64)t->cache.num_houses << 32);
+		h.Add(t->growth_rate | (uint64)t->flags << 16);
+	}
+	return h.Result();
+}
+
+/** Hash the production of all industries. */
+static uint32 HashIndustries()
+{
+	StateHasher h;
+	for (const Industry *i : Industry::Iterate()) {
+		h.Add(i->index);
+		h.Add(i->prod_level);
+		for (size_t j = 0; j < lengthof(i->produced_cargo_waiting); j++) {
+			h.Add(i->produced_cargo_waiting[j] | (uint64)i->production_rate[j] << 16);
+		}
+	}
+	return h.Result();
+}
+
+/**
+ * Compute the hashes of all parts of the current game state.
+ */
+void StateHash::Compute()
+{
+	this->part[SHP_MAP] = HashMap();
+	this->part[SHP_VEHICLES] = HashVehicles();
+	this->part[SHP_STATIONS] = HashStations();
+	this->part[SHP_COMPANIES] = HashCompanies();
+	this->part[SHP_TOWNS] = HashTowns();
+	this->part[SHP_INDUSTRIES] = HashIndustries();
+}
+
+/**
+ * Stop keeping the hash of the map up to date, so the changes of tiles are not recorded for it anymore.
+ */
+void StopStateHash()
+{
+	_map_hash_journal.Stop();
+}
+
+/**
+ * Get a human readable name of a part of the game state.
+ * @param part The part.
+ * @return The name of the part.
+ */
+const char *GetStateHashPartName(StateHashPart part)
+{
+	static const char * const names[] = {
+		"map",
+		"vehicles",
+		"stations",
+		"companies",
+		"towns",
+		"industries",
+	};
+	static_assert(lengthof(names) == SHP_END);
+
+	return names[part];
+}
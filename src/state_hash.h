@@ -0,0 +1,38 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file state_hash.h Hashing of the game state, e.g. to find out where a desync happened. */
+
+#ifndef STATE_HASH_H
+#define STATE_HASH_H
+
+#include "core/enum_type.hpp"
+
+/** Parts of the game state that are hashed separately. */
+enum StateHashPart : byte {
+	SHP_BEGIN = 0,
+	SHP_MAP = 0,    ///< Types, owners and reserved tracks of the tiles of the map.
+	SHP_VEHICLES,   ///< Positions, speeds and cargo of vehicles.
+	SHP_STATIONS,   ///< Cargo waiting at stations and its rating.
+	SHP_COMPANIES,  ///< Money and loans of companies.
+	SHP_TOWNS,      ///< Population and growth of towns.
+	SHP_INDUSTRIES, ///< Production of industries.
+	SHP_END,
+};
+DECLARE_POSTFIX_INCREMENT(StateHashPart)
+
+/** Hashes of all parts of the game state. */
+struct StateHash {
+	uint32 part[SHP_END]; ///< Hash of each of the parts.
+
+	void Compute();
+};
+
+void StopStateHash();
+const char *GetStateHashPartName(StateHashPart part);
+
+#endif /* STATE_HASH_H */
@@ -48,6 +48,70 @@ void RebuildStationKdtree()
 	_station_kdtree.Build(stids.begin(), stids.end());
 }
 
+/** Log2 of the side length of the square chunks of the station catchment index. */
+static const uint CATCHMENT_INDEX_CHUNK_BITS = 4;
+
+/** For every chunk of the map, the stations whose catchment area intersects that chunk, sorted by station index. */
+static std::vector<std::vector<StationID>> _station_catchment_index;
+
+/**
+ * Call a function on all chunks of the station catchment index intersecting a tile area.
+ * @param ta   The tile area.
+ * @param func The function to call, must take a std::vector<StationID>& as parameter.
+ */
+template <typename Func>
+static void ForAllCatchmentIndexChunks(const TileArea &ta, Func func)
+{
+	if (ta.tile == INVALID_TILE || ta.w == 0 || ta.h == 0) return;
+
+	uint size_x = MapSizeX() >> CATCHMENT_INDEX_CHUNK_BITS;
+	/* The index is not yet rebuilt for the current map, e.g. while loading a savegame. */
+	if (_station_catchment_index.size() != size_x * (MapSizeY() >> CATCHMENT_INDEX_CHUNK_BITS)) return;
+
+	uint x1 = TileX(ta.tile) >> CATCHMENT_INDEX_CHUNK_BITS;
+	uint y1 = TileY(ta.tile) >> CATCHMENT_INDEX_CHUNK_BITS;
+	uint x2 = (TileX(ta.tile) + ta.w - 1) >> CATCHMENT_INDEX_CHUNK_BITS;
+	uint y2 = (TileY(ta.tile) + ta.h - 1) >> CATCHMENT_INDEX_CHUNK_BITS;
+	for (uint y = y1; y <= y2; y++) {
+		for (uint x = x1; x <= x2; x++) {
+			func(_station_catchment_index[y * size_x + x]);
+		}
+	}
+}
+
+/**
+ * Clear the station catchment index and size it for the current map.
+ * The catchment of all stations must be recomputed afterwards.
+ */
+void ResetStationCatchmentIndex()
+{
+	_station_catchment_index.clear();
+	_station_catchment_index.resize((MapSizeX() >> CATCHMENT_INDEX_CHUNK_BITS) * (MapSizeY() >> CATCHMENT_INDEX_CHUNK_BITS));
+}
+
+/**
+ * Find the stations whose catchment area may cover any tile of a tile area.
+ * The result is a superset of the stations that actually cover a tile of the area;
+ * use Station::TileIsInCatchment to check the individual tiles.
+ * @param ta       The tile area to search.
+ * @param stations List to fill with the found stations, sorted by station index; its previous contents are discarded.
+ */
+void FindStationsInCatchmentIndex(const TileArea &ta, std::vector<StationID> &stations)
+{
+	stations.clear();
+	uint chunks = 0;
+	ForAllCatchmentIndexChunks(ta, [&stations, &chunks](std::vector<StationID> &chunk) {
+		stations.insert(stations.end(), chunk.begin(), chunk.end());
+		chunks++;
+	});
+
+	/* The chunks are sorted themselves, so only stations from several chunks need sorting and deduplication. */
+	if (chunks > 1) {
+		std::sort(stations.begin(), stations.end());
+		stations.erase(std::unique(stations.begin(), stations.end()), stations.end());
+	}
+}
+
 
 BaseStation::~BaseStation()
 {
@@ -155,6 +219,7 @@ Station::~Station()
 
 	CargoPacket::InvalidateAllFrom(this->index);
 
+	this->RemoveFromCatchmentIndex();
 	_station_kdtree.Remove(this->index);
 	if (this->sign.kdtree_valid) _viewport_sign_kdtree.Remove(ViewportSignKdtreeItem::MakeStation(this->index));
 }
@@ -422,6 +487,29 @@ bool Station::CatchmentCoversTown(TownID t) const
 	return false;
 }
 
+/**
+ * Register the current catchment area of this station in the station catchment index.
+ */
+void Station::AddToCatchmentIndex() const
+{
+	StationID index = this->index;
+	ForAllCatchmentIndexChunks(this->catchment_tiles, [index](std::vector<StationID> &chunk) {
+		chunk.insert(std::lower_bound(chunk.begin(), chunk.end(), index), index);
+	});
+}
+
+/**
+ * Remove the current catchment area of this station from the station catchment index.
+ */
+void Station::RemoveFromCatchmentIndex() const
+{
+	StationID index = this->index;
+	ForAllCatchmentIndexChunks(this->catchment_tiles, [index](std::vector<StationID> &chunk) {
+		auto it = std::lower_bound(chunk.begin(), chunk.end(), index);
+		if (it != chunk.end() && *it == index) chunk.erase(it);
+	});
+}
+
 /**
  * Recompute tiles covered in our catchment area.
  * This will additionally recompute nearby towns and industries.
@@ -430,6 +518,7 @@ void Station::RecomputeCatchment()
 {
 	this->industries_near.clear();
 	this->RemoveFromAllNearbyLists();
+	this->RemoveFromCatchmentIndex();
 
 	if (this->rect.IsEmpty()) {
 		this->catchment_tiles.Reset();
@@ -439,6 +528,7 @@ void Station::RecomputeCatchment()
 	if (!_settings_game.station.serve_neutral_industries && this->industry != nullptr) {
 		/* Station is associated with an industry, so we only need to deliver to that industry. */
 		this->catchment_tiles.Initialize(this->industry->location);
+		this->AddToCatchmentIndex();
 		for (TileIndex tile : this->industry->location) {
 			if (IsTileType(tile, MP_INDUSTRY) && GetIndustryIndex(tile) == this->industry->index) {
 				this->catchment_tiles.SetTile(tile);
@@ -455,6 +545,7 @@ void Station::RecomputeCatchment()
 	}
 
 	this->catchment_tiles.Initialize(GetCatchmentRect());
+	this->AddToCatchmentIndex();
 
 	/* Loop finding all station tiles */
 	TileArea ta(TileXY(this->rect.left, this->rect.top), TileXY(this->rect.right, this->rect.bottom));
@@ -496,6 +587,7 @@ void Station::RecomputeCatchment()
  */
 /* static */ void Station::RecomputeCatchmentForAll()
 {
+	ResetStationCatchmentIndex();
 	for (Station *st : Station::Iterate()) { st->RecomputeCatchment(); }
 }
 
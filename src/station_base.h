@@ -510,6 +510,8 @@ public:
 	void AddIndustryToDeliver(Industry *ind, TileIndex tile);
 	void RemoveIndustryToDeliver(Industry *ind);
 	void RemoveFromAllNearbyLists();
+	void AddToCatchmentIndex() const;
+	void RemoveFromCatchmentIndex() const;
 
 	inline bool TileIsInCatchment(TileIndex tile) const
 	{
@@ -562,6 +564,8 @@ public:
 };
 
 void RebuildStationKdtree();
+void ResetStationCatchmentIndex();
+void FindStationsInCatchmentIndex(const TileArea &ta, std::vector<StationID> &stations);
 
 /**
  * Call a function on all stations that have any part of the requested area within their catchment.
@@ -576,20 +580,14 @@ void ForAllStationsAroundTiles(const TileArea &ta, Func func)
 	/* There are no stations, so we will never find anything. */
 	if (Station::GetNumItems() == 0) return;
 
-	/* Not using, or don't have a nearby stations list, so we need to scan. */
-	std::set<StationID> seen_stations;
-
-	/* Scan an area around the building covering the maximum possible station
-	 * to find the possible nearby stations. */
-	uint max_c = _settings_game.station.modified_catchment ? MAX_CATCHMENT : CA_UNMODIFIED;
-	TileArea ta_ext = TileArea(ta).Expand(max_c);
-	for (TileIndex tile : ta_ext) {
-		if (IsTileType(tile, MP_STATION)) seen_stations.insert(GetStationIndex(tile));
-	}
+	/* Not using, or don't have a nearby stations list, so look up the stations
+	 * whose catchment area may cover the area in the catchment index. The list
+	 * is local, as func may look up stations around other tiles itself. */
+	std::vector<StationID> seen_stations;
+	FindStationsInCatchmentIndex(ta, seen_stations);
 
 	for (StationID stationid : seen_stations) {
-		Station *st = Station::GetIfValid(stationid);
-		if (st == nullptr) continue; /* Waypoint */
+		Station *st = Station::Get(stationid);
 
 		/* Check if station is attached to an industry */
 		if (!_settings_game.station.serve_neutral_industries && st->industry != nullptr) continue;
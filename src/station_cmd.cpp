@@ -3923,8 +3923,11 @@ CommandCost CmdRenameStation(DoCommandFlag flags, StationID station_id, const st
 
 static void AddNearbyStationsByCatchment(TileIndex tile, StationList *stations, StationList &nearby)
 {
-	for (Station *st : nearby) {
-		if (st->TileIsInCatchment(tile)) stations->insert(st);
+	std::vector<StationID> candidates;
+	FindStationsInCatchmentIndex(TileArea(tile, 1, 1), candidates);
+	for (StationID stationid : candidates) {
+		Station *st = Station::Get(stationid);
+		if (st->TileIsInCatchment(tile) && nearby.find(st) != nearby.end()) stations->insert(st);
 	}
 }
 
@@ -14,6 +14,12 @@
 #include "genworld.h"
 #include "core/random_func.hpp"
 #include "landscape_type.h"
+#include "thread.h"
+#include "cpu.h"
+#include "tgp_sse.h"
+#include "console_func.h"
+#include <array>
+#include <chrono>
 
 #include "safeguards.h"
 
@@ -199,6 +205,45 @@ static HeightMap _height_map = { {}, 0, 0, 0 };
 /** Maximum number of TGP noise frequencies. */
 static const int MAX_TGP_FREQUENCIES = 10;
 
+/** Number of height map rows handled as one piece of work when processing the height map in parallel. */
+static const int TGP_ROWS_PER_CHUNK = 32;
+
+/** Stages of the height map generation, whose time can be measured. */
+enum TgpStage {
+	TGPS_GENERATE,       ///< Generating the noise, HeightMapGenerate.
+	TGPS_WATER_LEVEL,    ///< Adjusting the water level, HeightMapAdjustWaterLevel.
+	TGPS_COAST_LINES,    ///< Lowering the map edges, HeightMapCoastLines.
+	TGPS_SMOOTH_SLOPES,  ///< Limiting the slopes, HeightMapSmoothSlopes.
+	TGPS_SMOOTH_COASTS,  ///< Softening the coasts, HeightMapSmoothCoasts.
+	TGPS_SINE_TRANSFORM, ///< Redistributing the heights, HeightMapSineTransform.
+	TGPS_CURVES,         ///< Styling the heights, HeightMapCurves.
+	TGPS_END,            ///< End marker.
+};
+
+/** Names of the stages of the height map generation. */
+static const char * const _tgp_stage_names[TGPS_END] = { "generate", "water level", "coast lines", "smooth slopes", "smooth coasts", "sine transform", "curves" };
+
+/** Microseconds spent per stage of the height map generation, or \c nullptr when not measuring. */
+static std::array<uint64, TGPS_END> *_tgp_stage_times = nullptr;
+
+/** Adds the time between its construction and destruction to a stage of the height map generation, when measuring. */
+class TgpStageTimer {
+	TgpStage stage;                               ///< The measured stage.
+	std::chrono::steady_clock::time_point start;  ///< When the stage started.
+
+public:
+	TgpStageTimer(TgpStage stage) : stage(stage)
+	{
+		if (_tgp_stage_times != nullptr) this->start = std::chrono::steady_clock::now();
+	}
+
+	~TgpStageTimer()
+	{
+		if (_tgp_stage_times == nullptr) return;
+		(*_tgp_stage_times)[this->stage] += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->start).count();
+	}
+};
+
 /** Desired water percentage (100% == 1024) - indexed by _settings_game.difficulty.quantity_sea_lakes */
 static const amplitude_t _water_percent[4] = {70, 170, 270, 420};
 
@@ -315,15 +360,17 @@ static inline bool IsValidXY(int x, int y)
 
 
 /**
- * Allocate array of (MapSizeX()+1)*(MapSizeY()+1) heights and init the _height_map structure members
+ * Allocate array of (size_x+1)*(size_y+1) heights and init the _height_map structure members
+ * @param size_x Size of the height map along the X axis, usually MapSizeX().
+ * @param size_y Size of the height map along the Y axis, usually MapSizeY().
  * @return true on success
  */
-static inline bool AllocHeightMap()
+static inline bool AllocHeightMap(uint size_x, uint size_y)
 {
 	assert(_height_map.h.empty());
 
-	_height_map.size_x = MapSizeX();
-	_height_map.size_y = MapSizeY();
+	_height_map.size_x = size_x;
+	_height_map.size_y = size_y;
 
 	/* Allocate memory block for height map row pointers */
 	size_t total_size = (_height_map.size_x + 1) * (_height_map.size_y + 1);
@@ -339,15 +386,55 @@ static inline void FreeHeightMap()
 	_height_map.h.clear();
 }
 
+/**
+ * Call a function for consecutive ranges of rows, spread over the available processors.
+ * The ranges do not depend on the number of processors, so work that draws its own
+ * random numbers per range gives the same result however many processors there are.
+ * @param first First row.
+ * @param end One past the last row.
+ * @param rows_per_chunk Number of rows in a range.
+ * @param fn Function to call with the first row of a range, one past its last row and the number of the range.
+ */
+template <class TFn>
+static void HeightMapParallelRows(int first, int end, int rows_per_chunk, TFn &&fn)
+{
+	if (end <= first) return;
+	size_t chunks = (end - first + rows_per_chunk - 1) / rows_per_chunk;
+	ParallelFor("ottd:tgp", chunks, [&](size_t i) {
+		int begin = first + (int)i * rows_per_chunk;
+		fn(begin, std::min(begin + rows_per_chunk, end), (uint)i);
+	});
+}
+
+/**
+ * Get the seed of the random numbers for a range of rows in a pass over the height map.
+ * The seed only depends on the generation seed, the pass and the range.
+ * @param pass The pass over the height map.
+ * @param chunk The range of rows.
+ * @return The seed.
+ */
+static uint32 GetChunkSeed(uint pass, uint chunk)
+{
+	uint32 seed = _settings_game.game_creation.generation_seed ^ (pass * 0x9E3779B9U) ^ (chunk * 0x85EBCA6BU);
+	/* Mix the bits, so neighbouring ranges do not get similar sequences. */
+	seed ^= seed >> 16;
+	seed *= 0x7FEB352DU;
+	seed ^= seed >> 15;
+	seed *= 0x846CA68BU;
+	seed ^= seed >> 16;
+	return seed;
+}
+
 /**
  * Generates new random height in given amplitude (generated numbers will range from - amplitude to + amplitude)
+ * @param random The random number generator to use.
  * @param rMax Limit of result
  * @return generated height
  */
-static inline height_t RandomHeight(amplitude_t rMax)
+static inline height_t RandomHeight(Randomizer &random, amplitude_t rMax)
 {
 	/* Spread height into range -rMax..+rMax */
-	return A2H(RandomRange(2 * rMax + 1) - rMax);
+	return A2H(random.Next(2 * rMax + 1) - rMax);
 }
 
 /**
@@ -356,13 +443,18 @@ static inline height_t RandomHeight(amplitude_t rMax)
  * This runs several iterations with increasing precision; the last iteration looks at areas
  * of 1 by 1 tiles, the second to last at 2 by 2 tiles and the initial 2**MAX_TGP_FREQUENCIES
  * by 2**MAX_TGP_FREQUENCIES tiles.
+ *
+ * Every iteration is done in parallel for ranges of rows; each range draws its random
+ * numbers from a generator seeded for that range and frequency.
  */
 static void HeightMapGenerate()
 {
+	TgpStageTimer timer(TGPS_GENERATE);
+
 	/* Trying to apply noise to uninitialized height map */
 	assert(!_height_map.h.empty());
 
-	int start = std::max(MAX_TGP_FREQUENCIES - (int)std::min(MapLogX(), MapLogY()), 0);
+	int start = std::max(MAX_TGP_FREQUENCIES - (int)FindLastBit(std::min(_height_map.size_x, _height_map.size_y)), 0);
 	bool first = true;
 
 	for (int frequency = start; frequency < MAX_TGP_FREQUENCIES; frequency++) {
@@ -373,49 +465,75 @@ static void HeightMapGenerate()
 		if (amplitude == 0) continue;
 
 		const int step = 1 << (MAX_TGP_FREQUENCIES - frequency - 1);
+		/* Number of rows of the grid of this frequency. */
+		const int rows = _height_map.size_y / step + 1;
 
 		if (first) {
 			/* This is first round, we need to establish base heights with step = size_min */
-			for (int y = 0; y <= _height_map.size_y; y += step) {
-				for (int x = 0; x <= _height_map.size_x; x += step) {
-					height_t height = (amplitude > 0) ? RandomHeight(amplitude) : 0;
-					_height_map.height(x, y) = height;
+			HeightMapParallelRows(0, rows, TGP_ROWS_PER_CHUNK, [&](int begin, int end, uint chunk) {
+				Randomizer random;
+				random.SetSeed(GetChunkSeed(frequency, chunk));
+				for (int y = begin * step; y < end * step; y += step) {
+					for (int x = 0; x <= _height_map.size_x; x += step) {
+						height_t height = (amplitude > 0) ? RandomHeight(random, amplitude) : 0;
+						_height_map.height(x, y) = height;
+					}
 				}
-			}
+			});
 			first = false;
 			continue;
 		}
 
 		/* It is regular iteration round.
 		 * Interpolate height values at odd x, even y tiles */
-		for (int y = 0; y <= _height_map.size_y; y += 2 * step) {
-			for (int x = 0; x <= _height_map.size_x - 2 * step; x += 2 * step) {
-				height_t h00 = _height_map.height(x + 0 * step, y);
-				height_t h02 = _height_map.height(x + 2 * step, y);
-				height_t h01 = (h00 + h02) / 2;
-				_height_map.height(x + 1 * step, y) = h01;
+		HeightMapParallelRows(0, (rows + 1) / 2, TGP_ROWS_PER_CHUNK, [&](int begin, int end, uint) {
+			for (int y = begin * 2 * step; y < end * 2 * step; y += 2 * step) {
+				for (int x = 0; x <= _height_map.size_x - 2 * step; x += 2 * step) {
+					height_t h00 = _height_map.height(x + 0 * step, y);
+					height_t h02 = _height_map.height(x + 2 * step, y);
+					height_t h01 = (h00 + h02) / 2;
+					_height_map.height(x + 1 * step, y) = h01;
+				}
 			}
-		}
+		});
 
 		/* Interpolate height values at odd y tiles */
-		for (int y = 0; y <= _height_map.size_y - 2 * step; y += 2 * step) {
-			for (int x = 0; x <= _height_map.size_x; x += step) {
-				height_t h00 = _height_map.height(x, y + 0 * step);
-				height_t h20 = _height_map.height(x, y + 2 * step);
-				height_t h10 = (h00 + h20) / 2;
-				_height_map.height(x, y + 1 * step) = h10;
+		HeightMapParallelRows(0, rows / 2, TGP_ROWS_PER_CHUNK, [&](int begin, int end, uint) {
+			for (int y = begin * 2 * step; y < end * 2 * step; y += 2 * step) {
+				for (int x = 0; x <= _height_map.size_x; x += step) {
+					height_t h00 = _height_map.height(x, y + 0 * step);
+					height_t h20 = _height_map.height(x, y + 2 * step);
+					height_t h10 = (h00 + h20) / 2;
+					_height_map.height(x, y + 1 * step) = h10;
+				}
 			}
-		}
+		});
 
 		/* Add noise for next higher frequency (smaller steps) */
-		for (int y = 0; y <= _height_map.size_y; y += step) {
-			for (int x = 0; x <= _height_map.size_x; x += step) {
-				_height_map.height(x, y) += RandomHeight(amplitude);
+		HeightMapParallelRows(0, rows, TGP_ROWS_PER_CHUNK, [&](int begin, int end, uint chunk) {
+			Randomizer random;
+			random.SetSeed(GetChunkSeed(frequency, chunk));
+			for (int y = begin * step; y < end * step; y += step) {
+				for (int x = 0; x <= _height_map.size_x; x += step) {
+					_height_map.height(x, y) += RandomHeight(random, amplitude);
+				}
 			}
-		}
+		});
 	}
 }
 
+/**
+ * Call a function for every height of ranges of rows of the height map, spread over the available processors.
+ * @param fn Function to call with every height.
+ */
+template <class TFn>
+static void HeightMapParallelForEach(TFn &&fn)
+{
+	HeightMapParallelRows(0, _height_map.size_y + 1, TGP_ROWS_PER_CHUNK, [&](int begin, int end, uint) {
+		for (auto it = _height_map.h.begin() + begin * _height_map.dim_x; it != _height_map.h.begin() + end * _height_map.dim_x; ++it) fn(*it);
+	});
+}
+
 /** Returns min, max and average height from height map */
 static void HeightMapGetMinMaxAvg(height_t *min_ptr, height_t *max_ptr, height_t *avg_ptr)
 {
@@ -423,11 +541,24 @@ static void HeightMapGetMinMaxAvg(height_t *min_ptr, height_t *max_ptr, height_t
 	int64 h_accu = 0;
 	h_min = h_max = _height_map.height(0, 0);
 
-	/* Get h_min, h_max and accumulate heights into h_accu */
-	for (const height_t &h : _height_map.h) {
-		if (h < h_min) h_min = h;
-		if (h > h_max) h_max = h;
-		h_accu += h;
+	/* Get h_min, h_max and accumulate heights into h_accu, per range of rows */
+	struct MinMaxAccu {
+		height_t h_min, h_max;
+		int64 h_accu;
+	};
+	std::vector<MinMaxAccu> chunks((_height_map.size_y + TGP_ROWS_PER_CHUNK) / TGP_ROWS_PER_CHUNK, { h_min, h_max, 0 });
+	HeightMapParallelRows(0, _height_map.size_y + 1, TGP_ROWS_PER_CHUNK, [&](int begin, int end, uint chunk) {
+		MinMaxAccu &c = chunks[chunk];
+		for (auto it = _height_map.h.begin() + begin * _height_map.dim_x; it != _height_map.h.begin() + end * _height_map.dim_x; ++it) {
+			if (*it < c.h_min) c.h_min = *it;
+			if (*it > c.h_max) c.h_max = *it;
+			c.h_accu += *it;
+		}
+	});
+	for (const MinMaxAccu &c : chunks) {
+		h_min = std::min(h_min, c.h_min);
+		h_max = std::max(h_max, c.h_max);
+		h_accu += c.h_accu;
 	}
 
 	/* Get average height */
@@ -444,11 +575,22 @@ static int *HeightMapMakeHistogram(height_t h_min, height_t h_max, int *hist_buf
 {
 	int *hist = hist_buf - h_min;
 
-	/* Count the heights and fill the histogram */
-	for (const height_t &h : _height_map.h){
-		assert(h >= h_min);
-		assert(h <= h_max);
-		hist[h]++;
+	/* Count the heights per range of rows; use few ranges, as each needs its own histogram. */
+	int rows_per_chunk = std::max(TGP_ROWS_PER_CHUNK, (_height_map.size_y + 1) / 64);
+	std::vector<std::vector<int>> chunks((_height_map.size_y + rows_per_chunk) / rows_per_chunk);
+	HeightMapParallelRows(0, _height_map.size_y + 1, rows_per_chunk, [&](int begin, int end, uint chunk) {
+		std::vector<int> &chunk_hist = chunks[chunk];
+		chunk_hist.resize(h_max - h_min + 1);
+		for (auto it = _height_map.h.begin() + begin * _height_map.dim_x; it != _height_map.h.begin() + end * _height_map.dim_x; ++it) {
+			assert(*it >= h_min);
+			assert(*it <= h_max);
+			chunk_hist[*it - h_min]++;
+		}
+	});
+
+	/* Fill the histogram */
+	for (const std::vector<int> &chunk_hist : chunks) {
+		for (size_t i = 0; i < chunk_hist.size(); i++) hist_buf[i] += chunk_hist[i];
 	}
 	return hist;
 }
@@ -456,10 +598,12 @@ static int *HeightMapMakeHistogram(height_t h_min, height_t h_max, int *hist_buf
 /** Applies sine wave redistribution onto height map */
 static void HeightMapSineTransform(height_t h_min, height_t h_max)
 {
-	for (height_t &h : _height_map.h) {
+	TgpStageTimer timer(TGPS_SINE_TRANSFORM);
+
+	HeightMapParallelForEach([h_min, h_max](height_t &h) {
 		double fheight;
 
-		if (h < h_min) continue;
+		if (h < h_min) return;
 
 		/* Transform height into 0..1 space */
 		fheight = (double)(h - h_min) / (double)(h_max - h_min);
@@ -525,7 +669,7 @@ static void HeightMapSineTransform(height_t h_min, height_t h_max)
 		h = (height_t)(fheight * (h_max - h_min) + h_min);
 		if (h < 0) h = I2H(0);
 		if (h >= h_max) h = h_max - 1;
-	}
+	});
 }
 
 /**
@@ -546,6 +690,8 @@ static void HeightMapSineTransform(height_t h_min, height_t h_max)
  */
 static void HeightMapCurves(uint level)
 {
+	TgpStageTimer timer(TGPS_CURVES);
+
 	height_t mh = TGPGetMaxHeight() - I2H(1); // height levels above sea level only
 
 	/** Basically scale height X to height Y. Everything in between is interpolated. */
@@ -573,9 +719,6 @@ static void HeightMapCurves(uint level)
 		{ lengthof(curve_map_4), curve_map_4 },
 	};
 
-	height_t ht[lengthof(curve_maps)];
-	MemSetT(ht, 0, lengthof(ht));
-
 	/* Set up a grid to choose curve maps based on location; attempt to get a somewhat square grid */
 	float factor = sqrt((float)_height_map.size_x / (float)_height_map.size_y);
 	uint sx = Clamp((int)(((1 << level) * factor) + 0.5), 1, 128);
@@ -586,9 +729,13 @@ static void HeightMapCurves(uint level)
 		c[i] = Random() % lengthof(curve_maps);
 	}
 
-	/* Apply curves */
+	/** X grid positions and bi-linear ratio of a column of the height map. */
+	struct grid_column_t {
+		uint x1, x2;
+		float xr, xri;
+	};
+	std::vector<grid_column_t> columns(_height_map.size_x);
 	for (int x = 0; x < _height_map.size_x; x++) {
-
 		/* Get our X grid positions and bi-linear ratio */
 		float fx = (float)(sx * x) / _height_map.size_x + 1.0f;
 		uint x1 = (uint)fx;
@@ -603,8 +750,15 @@ static void HeightMapCurves(uint level)
 			x1--;
 			if (x2 >= sx) x2--;
 		}
+		columns[x] = { x1, x2, xr, xri };
+	}
 
-		for (int y = 0; y < _height_map.size_y; y++) {
+	/* Apply curves; every height only depends on itself, so ranges of rows can be done in parallel. */
+	HeightMapParallelRows(0, _height_map.size_y, TGP_ROWS_PER_CHUNK, [&](int begin, int end, uint) {
+		height_t ht[lengthof(curve_maps)];
+		MemSetT(ht, 0, lengthof(ht));
+
+		for (int y = begin; y < end; y++) {
 
 			/* Get our Y grid position and bi-linear ratio */
 			float fy = (float)(sy * y) / _height_map.size_y + 1.0f;
@@ -621,60 +775,69 @@ static void HeightMapCurves(uint level)
 				if (y2 >= sy) y2--;
 			}
 
-			uint corner_a = c[x1 + sx * y1];
-			uint corner_b = c[x1 + sx * y2];
-			uint corner_c = c[x2 + sx * y1];
-			uint corner_d = c[x2 + sx * y2];
-
-			/* Bitmask of which curve maps are chosen, so that we do not bother
-			 * calculating a curve which won't be used. */
-			uint corner_bits = 0;
-			corner_bits |= 1 << corner_a;
-			corner_bits |= 1 << corner_b;
-			corner_bits |= 1 << corner_c;
-			corner_bits |= 1 << corner_d;
-
-			height_t *h = &_height_map.height(x, y);
-
-			/* Do not touch sea level */
-			if (*h < I2H(1)) continue;
-
-			/* Only scale above sea level */
-			*h -= I2H(1);
-
-			/* Apply all curve maps that are used on this tile. */
-			for (uint t = 0; t < lengthof(curve_maps); t++) {
-				if (!HasBit(corner_bits, t)) continue;
-
-				[[maybe_unused]] bool found = false;
-				const control_point_t *cm = curve_maps[t].list;
-				for (uint i = 0; i < curve_maps[t].length - 1; i++) {
-					const control_point_t &p1 = cm[i];
-					const control_point_t &p2 = cm[i + 1];
-
-					if (*h >= p1.x && *h < p2.x) {
-						ht[t] = p1.y + (*h - p1.x) * (p2.y - p1.y) / (p2.x - p1.x);
+			for (int x = 0; x < _height_map.size_x; x++) {
+				const uint x1 = columns[x].x1;
+				const uint x2 = columns[x].x2;
+				const float xr = columns[x].xr;
+				const float xri = columns[x].xri;
+
+				uint corner_a = c[x1 + sx * y1];
+				uint corner_b = c[x1 + sx * y2];
+				uint corner_c = c[x2 + sx * y1];
+				uint corner_d = c[x2 + sx * y2];
+
+				/* Bitmask of which curve maps are chosen, so that we do not bother
+				 * calculating a curve which won't be used. */
+				uint corner_bits = 0;
+				corner_bits |= 1 << corner_a;
+				corner_bits |= 1 << corner_b;
+				corner_bits |= 1 << corner_c;
+				corner_bits |= 1 << corner_d;
+
+				height_t *h = &_height_map.height(x, y);
+
+				/* Do not touch sea level */
+				if (*h < I2H(1)) continue;
+
+				/* Only scale above sea level */
+				*h -= I2H(1);
+
+				/* Apply all curve maps that are used on this tile. */
+				for (uint t = 0; t < lengthof(curve_maps); t++) {
+					if (!HasBit(corner_bits, t)) continue;
+
+					[[maybe_unused]] bool found = false;
+					const control_point_t *cm = curve_maps[t].list;
+					for (uint i = 0; i < curve_maps[t].length - 1; i++) {
+						const control_point_t &p1 = cm[i];
+						const control_point_t &p2 = cm[i + 1];
+
+						if (*h >= p1.x && *h < p2.x) {
+							ht[t] = p1.y + (*h - p1.x) * (p2.y - p1.y) / (p2.x - p1.x);
 #ifdef WITH_ASSERT
-						found = true;
+							found = true;
 #endif
-						break;
+							break;
+						}
 					}
+					assert(found);
 				}
-				assert(found);
-			}
 
-			/* Apply interpolation of curve map results. */
-			*h = (height_t)((ht[corner_a] * yri + ht[corner_b] * yr) * xri + (ht[corner_c] * yri + ht[corner_d] * yr) * xr);
+				/* Apply interpolation of curve map results. */
+				*h = (height_t)((ht[corner_a] * yri + ht[corner_b] * yr) * xri + (ht[corner_c] * yri + ht[corner_d] * yr) * xr);
 
-			/* Readd sea level */
-			*h += I2H(1);
+				/* Readd sea level */
+				*h += I2H(1);
+			}
 		}
-	}
+	});
 }
 
 /** Adjusts heights in height map to contain required amount of water tiles */
 static void HeightMapAdjustWaterLevel(amplitude_t water_percent, height_t h_max_new)
 {
+	TgpStageTimer timer(TGPS_WATER_LEVEL);
+
 	height_t h_min, h_max, h_avg, h_water_level;
 	int64 water_tiles, desired_water_tiles;
 	int *hist;
@@ -701,19 +864,98 @@ static void HeightMapAdjustWaterLevel(amplitude_t water_percent, height_t h_max_
 	 *   values from range: h_water_level..h_max are transformed into 0..h_max_new
 	 *   where h_max_new is depending on terrain type and map size.
 	 */
-	for (height_t &h : _height_map.h) {
+	HeightMapParallelForEach([h_water_level, h_max, h_max_new](height_t &h) {
 		/* Transform height from range h_water_level..h_max into 0..h_max_new range */
 		h = (height_t)(((int)h_max_new) * (h - h_water_level) / (h_max - h_water_level)) + I2H(1);
 		/* Make sure all values are in the proper range (0..h_max_new) */
 		if (h < 0) h = I2H(0);
 		if (h >= h_max_new) h = h_max_new - 1;
-	}
+	});
 
 	free(hist_buf);
 }
 
 static double perlin_coast_noise_2D(const double x, const double y, const double p, const int prime);
 
+/** Calculate perlin_coast_noise_2D for a number of points, see PerlinCoastNoiseProc. */
+static void PerlinCoastNoiseScalar(const double *x, const double *y, double p, int prime, uint32, double *out, uint count)
+{
+	for (uint i = 0; i < count; i++) out[i] = perlin_coast_noise_2D(x[i], y[i], p, prime);
+}
+
+/** Limit the heights of a row to those of another row, see SmoothSlopesLimitProc. */
+static void SmoothSlopesLimitScalar(height_t *row, const height_t *other, uint count, height_t dh)
+{
+	for (uint i = 0; i < count; i++) {
+		height_t h_max = other[i] + dh;
+		if (row[i] > h_max) row[i] = h_max;
+	}
+}
+
+/** Limit the heights of a row to the height before them, see SmoothSlopesScanProc. */
+static void SmoothSlopesForwardScalar(height_t *row, uint count, height_t dh)
+{
+	for (uint i = 1; i < count; i++) {
+		height_t h_max = row[i - 1] + dh;
+		if (row[i] > h_max) row[i] = h_max;
+	}
+}
+
+/** Limit the heights of a row to the height after them, see SmoothSlopesScanProc. */
+static void SmoothSlopesBackwardScalar(height_t *row, uint count, height_t dh)
+{
+	if (count == 0) return;
+	for (uint i = count - 1; i-- > 0;) {
+		height_t h_max = row[i + 1] + dh;
+		if (row[i] > h_max) row[i] = h_max;
+	}
+}
+
+/** The kernels of the height map generation that have vectorised variants. */
+struct TgpKernels {
+	const char *name;                             ///< Name of the used instructions.
+	PerlinCoastNoiseProc *perlin_coast_noise;     ///< Coast noise for a number of points.
+	SmoothSlopesLimitProc *limit_slopes;          ///< Limit heights to those of a neighbouring row.
+	SmoothSlopesScanProc *smooth_slopes_forward;  ///< Limit heights to the height before them.
+	SmoothSlopesScanProc *smooth_slopes_backward; ///< Limit heights to the height after them.
+};
+
+/** The plain C++ kernels; they work everywhere. */
+static const TgpKernels _tgp_kernels_scalar = { "scalar", PerlinCoastNoiseScalar, SmoothSlopesLimitScalar, SmoothSlopesForwardScalar, SmoothSlopesBackwardScalar };
+
+#ifdef WITH_SSE
+#ifdef POINTER_IS_64BIT
+static const TgpKernels _tgp_kernels_sse2 = { "SSE2", PerlinCoastNoiseSSE2, SmoothSlopesLimitSSE2, SmoothSlopesForwardSSE2, SmoothSlopesBackwardSSE2 };
+static const TgpKernels _tgp_kernels_avx2 = { "AVX2", PerlinCoastNoiseAVX2, SmoothSlopesLimitAVX2, SmoothSlopesForwardSSE2, SmoothSlopesBackwardSSE2 };
+#else
+static const TgpKernels _tgp_kernels_sse2 = { "SSE2", PerlinCoastNoiseScalar, SmoothSlopesLimitSSE2, SmoothSlopesForwardSSE2, SmoothSlopesBackwardSSE2 };
+static const TgpKernels _tgp_kernels_avx2 = { "AVX2", PerlinCoastNoiseScalar, SmoothSlopesLimitAVX2, SmoothSlopesForwardSSE2, SmoothSlopesBackwardSSE2 };
+#endif /* POINTER_IS_64BIT */
+#endif /* WITH_SSE */
+
+/** The kernels in use; chosen on first use. */
+static const TgpKernels *_tgp_kernels = nullptr;
+
+/**
+ * Get the fastest kernels the CPU supports. They all give exactly the same height map.
+ * @note Only call this from the main thread, as it chooses the kernels on first use.
+ * @return The kernels.
+ */
+static const TgpKernels &GetTgpKernels()
+{
+	if (_tgp_kernels == nullptr) {
+		_tgp_kernels = &_tgp_kernels_scalar;
+#ifdef WITH_SSE
+		if (HasAVX2Support()) {
+			_tgp_kernels = &_tgp_kernels_avx2;
+		} else if (HasCPUIDFlag(1, 3, 26)) {
+			_tgp_kernels = &_tgp_kernels_sse2;
+		}
+#endif /* WITH_SSE */
+	}
+	return *_tgp_kernels;
+}
+
 /**
  * This routine sculpts in from the edge a random amount, again a Perlin
  * sequence, to avoid the rigid flat-edge slopes that were present before. The
@@ -736,57 +978,92 @@ static double perlin_coast_noise_2D(const double x, const double y, const double
  */
 static void HeightMapCoastLines(uint8 water_borders)
 {
+	TgpStageTimer timer(TGPS_COAST_LINES);
+
 	int smallest_size = std::min(_settings_game.game_creation.map_x, _settings_game.game_creation.map_y);
 	const int margin = 4;
-	int y, x;
-	double max_x;
-	double max_y;
+	const TgpKernels &kernels = GetTgpKernels();
+	const uint32 seed = _settings_game.game_creation.generation_seed;
+
+	/* Lower to sea level; every row is done on its own, so ranges of rows can be done in parallel.
+	 * The noise for all rows of a range is calculated in one go, so it can be vectorised. */
+	HeightMapParallelRows(0, _height_map.size_y + 1, TGP_ROWS_PER_CHUNK, [&](int begin, int end, uint) {
+		const uint count = end - begin;
+		double mirrored[TGP_ROWS_PER_CHUNK], straight[TGP_ROWS_PER_CHUNK];
+		double noise1[TGP_ROWS_PER_CHUNK], noise2[TGP_ROWS_PER_CHUNK];
+		for (int y = begin; y < end; y++) {
+			mirrored[y - begin] = _height_map.size_y - y;
+			straight[y - begin] = y;
+		}
 
-	/* Lower to sea level */
-	for (y = 0; y <= _height_map.size_y; y++) {
 		if (HasBit(water_borders, BORDER_NE)) {
-			/* Top right */
-			max_x = abs((perlin_coast_noise_2D(_height_map.size_y - y, y, 0.9, 53) + 0.25) * 5 + (perlin_coast_noise_2D(y, y, 0.35, 179) + 1) * 12);
-			max_x = std::max((smallest_size * smallest_size / 64) + max_x, (smallest_size * smallest_size / 64) + margin - max_x);
-			if (smallest_size < 8 && max_x > 5) max_x /= 1.5;
-			for (x = 0; x < max_x; x++) {
-				_height_map.height(x, y) = 0;
+			kernels.perlin_coast_noise(mirrored, straight, 0.9, 53, seed, noise1, count);
+			kernels.perlin_coast_noise(straight, straight, 0.35, 179, seed, noise2, count);
+			for (int y = begin; y < end; y++) {
+				/* Top right */
+				double max_x = abs((noise1[y - begin] + 0.25) * 5 + (noise2[y - begin] + 1) * 12);
+				max_x = std::max((smallest_size * smallest_size / 64) + max_x, (smallest_size * smallest_size / 64) + margin - max_x);
+				if (smallest_size < 8 && max_x > 5) max_x /= 1.5;
+				for (int x = 0; x < max_x; x++) {
+					_height_map.height(x, y) = 0;
+				}
 			}
 		}
 
 		if (HasBit(water_borders, BORDER_SW)) {
-			/* Bottom left */
-			max_x = abs((perlin_coast_noise_2D(_height_map.size_y - y, y, 0.85, 101) + 0.3) * 6 + (perlin_coast_noise_2D(y, y, 0.45,  67) + 0.75) * 8);
-			max_x = std::max((smallest_size * smallest_size / 64) + max_x, (smallest_size * smallest_size / 64) + margin - max_x);
-			if (smallest_size < 8 && max_x > 5) max_x /= 1.5;
-			for (x = _height_map.size_x; x > (_height_map.size_x - 1 - max_x); x--) {
-				_height_map.height(x, y) = 0;
+			kernels.perlin_coast_noise(mirrored, straight, 0.85, 101, seed, noise1, count);
+			kernels.perlin_coast_noise(straight, straight, 0.45, 67, seed, noise2, count);
+			for (int y = begin; y < end; y++) {
+				/* Bottom left */
+				double max_x = abs((noise1[y - begin] + 0.3) * 6 + (noise2[y - begin] + 0.75) * 8);
+				max_x = std::max((smallest_size * smallest_size / 64) + max_x, (smallest_size * smallest_size / 64) + margin - max_x);
+				if (smallest_size < 8 && max_x > 5) max_x /= 1.5;
+				for (int x = _height_map.size_x; x > (_height_map.size_x - 1 - max_x); x--) {
+					_height_map.height(x, y) = 0;
+				}
 			}
 		}
-	}
+	});
+
+	/* Lower to sea level; likewise every column is done on its own. */
+	HeightMapParallelRows(0, _height_map.size_x + 1, TGP_ROWS_PER_CHUNK, [&](int begin, int end, uint) {
+		const uint count = end - begin;
+		double straight[TGP_ROWS_PER_CHUNK], half[TGP_ROWS_PER_CHUNK], third[TGP_ROWS_PER_CHUNK];
+		double noise1[TGP_ROWS_PER_CHUNK], noise2[TGP_ROWS_PER_CHUNK];
+		for (int x = begin; x < end; x++) {
+			straight[x - begin] = x;
+			half[x - begin] = _height_map.size_y / 2;
+			third[x - begin] = _height_map.size_y / 3;
+		}
 
-	/* Lower to sea level */
-	for (x = 0; x <= _height_map.size_x; x++) {
 		if (HasBit(water_borders, BORDER_NW)) {
-			/* Top left */
-			max_y = abs((perlin_coast_noise_2D(x, _height_map.size_y / 2, 0.9, 167) + 0.4) * 5 + (perlin_coast_noise_2D(x, _height_map.size_y / 3, 0.4, 211) + 0.7) * 9);
-			max_y = std::max((smallest_size * smallest_size / 64) + max_y, (smallest_size * smallest_size / 64) + margin - max_y);
-			if (smallest_size < 8 && max_y > 5) max_y /= 1.5;
-			for (y = 0; y < max_y; y++) {
-				_height_map.height(x, y) = 0;
+			kernels.perlin_coast_noise(straight, half, 0.9, 167, seed, noise1, count);
+			kernels.perlin_coast_noise(straight, third, 0.4, 211, seed, noise2, count);
+			for (int x = begin; x < end; x++) {
+				/* Top left */
+				double max_y = abs((noise1[x - begin] + 0.4) * 5 + (noise2[x - begin] + 0.7) * 9);
+				max_y = std::max((smallest_size * smallest_size / 64) + max_y, (smallest_size * smallest_size / 64) + margin - max_y);
+				if (smallest_size < 8 && max_y > 5) max_y /= 1.5;
+				for (int y = 0; y < max_y; y++) {
+					_height_map.height(x, y) = 0;
+				}
 			}
 		}
 
 		if (HasBit(water_borders, BORDER_SE)) {
-			/* Bottom right */
-			max_y = abs((perlin_coast_noise_2D(x, _height_map.size_y / 3, 0.85, 71) + 0.25) * 6 + (perlin_coast_noise_2D(x, _height_map.size_y / 3, 0.35, 193) + 0.75) * 12);
-			max_y = std::max((smallest_size * smallest_size / 64) + max_y, (smallest_size * smallest_size / 64) + margin - max_y);
-			if (smallest_size < 8 && max_y > 5) max_y /= 1.5;
-			for (y = _height_map.size_y; y > (_height_map.size_y - 1 - max_y); y--) {
-				_height_map.height(x, y) = 0;
+			kernels.perlin_coast_noise(straight, third, 0.85, 71, seed, noise1, count);
+			kernels.perlin_coast_noise(straight, third, 0.35, 193, seed, noise2, count);
+			for (int x = begin; x < end; x++) {
+				/* Bottom right */
+				double max_y = abs((noise1[x - begin] + 0.25) * 6 + (noise2[x - begin] + 0.75) * 12);
+				max_y = std::max((smallest_size * smallest_size / 64) + max_y, (smallest_size * smallest_size / 64) + margin - max_y);
+				if (smallest_size < 8 && max_y > 5) max_y /= 1.5;
+				for (int y = _height_map.size_y; y > (_height_map.size_y - 1 - max_y); y--) {
+					_height_map.height(x, y) = 0;
+				}
 			}
 		}
-	}
+	});
 }
 
 /** Start at given point, move in given direction, find and Smooth coast in that direction */
@@ -829,6 +1106,8 @@ static void HeightMapSmoothCoastInDirection(int org_x, int org_y, int dir_x, int
 /** Smooth coasts by modulating height of tiles close to map edges with cosine of distance from edge */
 static void HeightMapSmoothCoasts(uint8 water_borders)
 {
+	TgpStageTimer timer(TGPS_SMOOTH_COASTS);
+
 	int x, y;
 	/* First Smooth NW and SE coasts (y close to 0 and y close to size_y) */
 	for (x = 0; x < _height_map.size_x; x++) {
@@ -848,21 +1127,41 @@ static void HeightMapSmoothCoasts(uint8 water_borders)
  * one level between tiles. This routine smooths out those differences so that
  * the most it can change is one level. When OTTD can support cliffs, this
  * routine may not be necessary.
+ *
+ * Limiting every height to dh_max above its north-west and north-east neighbours,
+ * going from the north corner, limits it to every height north of it plus dh_max
+ * per tile of distance. That is the same as first limiting along the rows and then
+ * along the columns; rows, respectively columns, can be done in parallel.
+ * The same goes for the limiting from the south corner.
+ * The limiting along the columns is done a whole row of a range of columns at a time.
  */
 static void HeightMapSmoothSlopes(height_t dh_max)
 {
-	for (int y = 0; y <= (int)_height_map.size_y; y++) {
-		for (int x = 0; x <= (int)_height_map.size_x; x++) {
-			height_t h_max = std::min(_height_map.height(x > 0 ? x - 1 : x, y), _height_map.height(x, y > 0 ? y - 1 : y)) + dh_max;
-			if (_height_map.height(x, y) > h_max) _height_map.height(x, y) = h_max;
+	TgpStageTimer timer(TGPS_SMOOTH_SLOPES);
+
+	const TgpKernels &kernels = GetTgpKernels();
+	const uint dim_x = _height_map.dim_x;
+
+	HeightMapParallelRows(0, _height_map.size_y + 1, TGP_ROWS_PER_CHUNK, [&](int begin, int end, uint) {
+		for (int y = begin; y < end; y++) {
+			kernels.smooth_slopes_forward(&_height_map.height(0, y), dim_x, dh_max);
 		}
-	}
-	for (int y = _height_map.size_y; y >= 0; y--) {
-		for (int x = _height_map.size_x; x >= 0; x--) {
-			height_t h_max = std::min(_height_map.height(x < _height_map.size_x ? x + 1 : x, y), _height_map.height(x, y < _height_map.size_y ? y + 1 : y)) + dh_max;
-			if (_height_map.height(x, y) > h_max) _height_map.height(x, y) = h_max;
+	});
+	HeightMapParallelRows(0, _height_map.size_x + 1, TGP_ROWS_PER_CHUNK, [&](int begin, int end, uint) {
+		for (int y = 1; y <= _height_map.size_y; y++) {
+			kernels.limit_slopes(&_height_map.height(begin, y), &_height_map.height(begin, y - 1), end - begin, dh_max);
 		}
-	}
+	});
+	HeightMapParallelRows(0, _height_map.size_y + 1, TGP_ROWS_PER_CHUNK, [&](int begin, int end, uint) {
+		for (int y = begin; y < end; y++) {
+			kernels.smooth_slopes_backward(&_height_map.height(0, y), dim_x, dh_max);
+		}
+	});
+	HeightMapParallelRows(0, _height_map.size_x + 1, TGP_ROWS_PER_CHUNK, [&](int begin, int end, uint) {
+		for (int y = _height_map.size_y - 1; y >= 0; y--) {
+			kernels.limit_slopes(&_height_map.height(begin, y), &_height_map.height(begin, y + 1), end - begin, dh_max);
+		}
+	});
 }
 
 /**
@@ -991,7 +1290,7 @@ static void TgenSetTileHeight(TileIndex tile, int height)
  */
 void GenerateTerrainPerlin()
 {
-	if (!AllocHeightMap()) return;
+	if (!AllocHeightMap(MapSizeX(), MapSizeY())) return;
 	GenerateWorldSetAbortCallback(FreeHeightMap);
 
 	HeightMapGenerate();
@@ -1022,3 +1321,54 @@ void GenerateTerrainPerlin()
 	FreeHeightMap();
 	GenerateWorldSetAbortCallback(nullptr);
 }
+
+/**
+ * Generate height maps of several sizes and show how long every stage of the
+ * generation takes, with the vectorised kernels as well as without them.
+ * The current map is not changed; its settings are used for the generation.
+ * @param max_size Size of the largest height map.
+ */
+void TgpBenchmark(uint max_size)
+{
+	SavedRandomSeeds saved_seeds;
+	SaveRandomSeeds(&saved_seeds);
+
+	const TgpKernels &kernels = GetTgpKernels();
+	const TgpKernels *kernel_sets[] = { &kernels, &_tgp_kernels_scalar };
+	const uint sets = &kernels == &_tgp_kernels_scalar ? 1 : 2;
+
+	for (uint size = 1 << MIN_MAP_SIZE_BITS; size <= max_size; size <<= 2) {
+		std::vector<height_t> results[lengthof(kernel_sets)];
+
+		for (uint set = 0; set < sets; set++) {
+			std::array<uint64, TGPS_END> times = {};
+			_tgp_kernels = kernel_sets[set];
+			_tgp_stage_times = &times;
+
+			/* Every run gets the same random numbers, so all generate the same height map. */
+			RestoreRandomSeeds(saved_seeds);
+			AllocHeightMap(size, size);
+			HeightMapGenerate();
+			HeightMapNormalize();
+			results[set] = _height_map.h;
+			FreeHeightMap();
+
+			_tgp_stage_times = nullptr;
+
+			uint64 total = 0;
+			std::string stages;
+			for (int stage = 0; stage < TGPS_END; stage++) {
+				total += times[stage];
+				stages += fmt::format(", {} {} ms", _tgp_stage_names[stage], times[stage] / 1000);
+			}
+			IConsolePrint(CC_INFO, "{}x{} {}: {} ms{}", size, size, kernel_sets[set]->name, total / 1000, stages);
+		}
+
+		if (sets > 1 && results[0] != results[1]) {
+			IConsolePrint(CC_ERROR, "{}x{}: the {} kernels generated a different height map than the scalar kernels.", size, size, kernels.name);
+		}
+	}
+
+	_tgp_kernels = &kernels;
+	RestoreRandomSeeds(saved_seeds);
+}
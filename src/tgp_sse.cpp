@@ -0,0 +1,267 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tgp_sse.cpp Vectorised kernels of the Perlin noise enhanced map generator using SSE2 and AVX2. */
+
+#ifdef WITH_SSE
+
+#include "stdafx.h"
+#include <math.h>
+#include "immintrin.h"
+#include "tgp_sse.h"
+
+#include "safeguards.h"
+
+/*
+ * All kernels give exactly the same results as the scalar code in tgp.cpp.
+ * For the noise that means that every lane does the same double operations in
+ * the same order, and that the integer hash only depends on the lower 32 bits
+ * of its input, so it can be done in 32 bits lanes. The slopes are limited by
+ * the same wrapping 16 bits additions and signed minimums as the scalar code.
+ */
+
+#ifdef POINTER_IS_64BIT
+
+/**
+ * Multiply the 32 bits lanes of two vectors, keeping the lower 32 bits of the products.
+ * SSE2 has no instruction for this, so multiply the even and odd lanes into 64 bits separately.
+ */
+GNU_TARGET("sse2")
+static inline __m128i MulLo32SSE2(__m128i a, __m128i b)
+{
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/** int_noise of tgp.cpp for the lower two lanes of the already combined coordinates. */
+GNU_TARGET("sse2")
+static inline __m128d IntNoiseSSE2(__m128i n)
+{
+	n = _mm_xor_si128(_mm_slli_epi32(n, 13), n);
+	__m128i r = MulLo32SSE2(n, _mm_add_epi32(MulLo32SSE2(MulLo32SSE2(n, n), _mm_set1_epi32(15731)), _mm_set1_epi32(789221)));
+	r = _mm_and_si128(_mm_add_epi32(r, _mm_set1_epi32(1376312589)), _mm_set1_epi32(0x7fffffff));
+	return _mm_sub_pd(_mm_set1_pd(1.0), _mm_div_pd(_mm_cvtepi32_pd(r), _mm_set1_pd(1073741824.0)));
+}
+
+/** interpolated_noise of tgp.cpp for two points. */
+GNU_TARGET("sse2")
+static inline __m128d InterpolatedNoiseSSE2(__m128d x, __m128d y, __m128i prime, __m128i seed)
+{
+	__m128i integer_x = _mm_cvttpd_epi32(x);
+	__m128i integer_y = _mm_cvttpd_epi32(y);
+	__m128d fractional_x = _mm_sub_pd(x, _mm_cvtepi32_pd(integer_x));
+	__m128d fractional_y = _mm_sub_pd(y, _mm_cvtepi32_pd(integer_y));
+
+	/* The noise of the neighbouring positions is that of one, respectively prime, further. */
+	__m128i n = _mm_add_epi32(_mm_add_epi32(integer_x, MulLo32SSE2(integer_y, prime)), seed);
+	__m128i one = _mm_set1_epi32(1);
+	__m128d v1 = IntNoiseSSE2(n);
+	__m128d v2 = IntNoiseSSE2(_mm_add_epi32(n, one));
+	__m128d v3 = IntNoiseSSE2(_mm_add_epi32(n, prime));
+	__m128d v4 = IntNoiseSSE2(_mm_add_epi32(_mm_add_epi32(n, prime), one));
+
+	__m128d i1 = _mm_add_pd(v1, _mm_mul_pd(fractional_x, _mm_sub_pd(v2, v1)));
+	__m128d i2 = _mm_add_pd(v3, _mm_mul_pd(fractional_x, _mm_sub_pd(v4, v3)));
+	return _mm_add_pd(i1, _mm_mul_pd(fractional_y, _mm_sub_pd(i2, i1)));
+}
+
+GNU_TARGET("sse2")
+void PerlinCoastNoiseSSE2(const double *x, const double *y, double p, int prime, uint32 seed, double *out, uint count)
+{
+	double amplitude[6];
+	for (int i = 0; i < 6; i++) amplitude[i] = pow(p, (double)i);
+
+	const __m128i prime_v = _mm_set1_epi32(prime);
+	const __m128i seed_v = _mm_set1_epi32(seed);
+	const __m128d scale = _mm_set1_pd(64.0);
+
+	uint j = 0;
+	for (; j + 2 <= count; j += 2) {
+		__m128d px = _mm_loadu_pd(x + j);
+		__m128d py = _mm_loadu_pd(y + j);
+		__m128d total = _mm_setzero_pd();
+		for (int i = 0; i < 6; i++) {
+			__m128d frequency = _mm_set1_pd((double)(1 << i));
+			__m128d noise = InterpolatedNoiseSSE2(_mm_div_pd(_mm_mul_pd(px, frequency), scale), _mm_div_pd(_mm_mul_pd(py, frequency), scale), prime_v, seed_v);
+			total = _mm_add_pd(total, _mm_mul_pd(noise, _mm_set1_pd(amplitude[i])));
+		}
+		_mm_storeu_pd(out + j, total);
+	}
+	if (j < count) {
+		/* Do the last point as the first of a pair with itself. */
+		double px[2] = { x[j], x[j] };
+		double py[2] = { y[j], y[j] };
+		double result[2];
+		PerlinCoastNoiseSSE2(px, py, p, prime, seed, result, 2);
+		out[j] = result[0];
+	}
+}
+
+/** int_noise of tgp.cpp for four lanes of the already combined coordinates. */
+GNU_TARGET("avx2")
+static inline __m256d IntNoiseAVX2(__m128i n)
+{
+	n = _mm_xor_si128(_mm_slli_epi32(n, 13), n);
+	__m128i r = _mm_mullo_epi32(n, _mm_add_epi32(_mm_mullo_epi32(_mm_mullo_epi32(n, n), _mm_set1_epi32(15731)), _mm_set1_epi32(789221)));
+	r = _mm_and_si128(_mm_add_epi32(r, _mm_set1_epi32(1376312589)), _mm_set1_epi32(0x7fffffff));
+	return _mm256_sub_pd(_mm256_set1_pd(1.0), _mm256_div_pd(_mm256_cvtepi32_pd(r), _mm256_set1_pd(1073741824.0)));
+}
+
+/** interpolated_noise of tgp.cpp for four points. */
+GNU_TARGET("avx2")
+static inline __m256d InterpolatedNoiseAVX2(__m256d x, __m256d y, __m128i prime, __m128i seed)
+{
+	__m128i integer_x = _mm256_cvttpd_epi32(x);
+	__m128i integer_y = _mm256_cvttpd_epi32(y);
+	__m256d fractional_x = _mm256_sub_pd(x, _mm256_cvtepi32_pd(integer_x));
+	__m256d fractional_y = _mm256_sub_pd(y, _mm256_cvtepi32_pd(integer_y));
+
+	__m128i n = _mm_add_epi32(_mm_add_epi32(integer_x, _mm_mullo_epi32(integer_y, prime)), seed);
+	__m128i one = _mm_set1_epi32(1);
+	__m256d v1 = IntNoiseAVX2(n);
+	__m256d v2 = IntNoiseAVX2(_mm_add_epi32(n, one));
+	__m256d v3 = IntNoiseAVX2(_mm_add_epi32(n, prime));
+	__m256d v4 = IntNoiseAVX2(_mm_add_epi32(_mm_add_epi32(n, prime), one));
+
+	__m256d i1 = _mm256_add_pd(v1, _mm256_mul_pd(fractional_x, _mm256_sub_pd(v2, v1)));
+	__m256d i2 = _mm256_add_pd(v3, _mm256_mul_pd(fractional_x, _mm256_sub_pd(v4, v3)));
+	return _mm256_add_pd(i1, _mm256_mul_pd(fractional_y, _mm256_sub_pd(i2, i1)));
+}
+
+GNU_TARGET("avx2")
+void PerlinCoastNoiseAVX2(const double *x, const double *y, double p, int prime, uint32 seed, double *out, uint count)
+{
+	double amplitude[6];
+	for (int i = 0; i < 6; i++) amplitude[i] = pow(p, (double)i);
+
+	const __m128i prime_v = _mm_set1_epi32(prime);
+	const __m128i seed_v = _mm_set1_epi32(seed);
+	const __m256d scale = _mm256_set1_pd(64.0);
+
+	uint j = 0;
+	for (; j + 4 <= count; j += 4) {
+		__m256d px = _mm256_loadu_pd(x + j);
+		__m256d py = _mm256_loadu_pd(y + j);
+		__m256d total = _mm256_setzero_pd();
+		for (int i = 0; i < 6; i++) {
+			__m256d frequency = _mm256_set1_pd((double)(1 << i));
+			__m256d noise = InterpolatedNoiseAVX2(_mm256_div_pd(_mm256_mul_pd(px, frequency), scale), _mm256_div_pd(_mm256_mul_pd(py, frequency), scale), prime_v, seed_v);
+			total = _mm256_add_pd(total, _mm256_mul_pd(noise, _mm256_set1_pd(amplitude[i])));
+		}
+		_mm256_storeu_pd(out + j, total);
+	}
+	if (j < count) PerlinCoastNoiseSSE2(x + j, y + j, p, prime, seed, out + j, count - j);
+}
+
+#endif /* POINTER_IS_64BIT */
+
+GNU_TARGET("sse2")
+void SmoothSlopesLimitSSE2(int16 *row, const int16 *other, uint count, int16 dh)
+{
+	const __m128i dh_v = _mm_set1_epi16(dh);
+
+	uint i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128i h = _mm_loadu_si128((const __m128i *)(row + i));
+		__m128i h_max = _mm_add_epi16(_mm_loadu_si128((const __m128i *)(other + i)), dh_v);
+		_mm_storeu_si128((__m128i *)(row + i), _mm_min_epi16(h, h_max));
+	}
+	for (; i < count; i++) {
+		int16 h_max = other[i] + dh;
+		if (row[i] > h_max) row[i] = h_max;
+	}
+}
+
+GNU_TARGET("avx2")
+void SmoothSlopesLimitAVX2(int16 *row, const int16 *other, uint count, int16 dh)
+{
+	const __m256i dh_v = _mm256_set1_epi16(dh);
+
+	uint i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m256i h = _mm256_loadu_si256((const __m256i *)(row + i));
+		__m256i h_max = _mm256_add_epi16(_mm256_loadu_si256((const __m256i *)(other + i)), dh_v);
+		_mm256_storeu_si256((__m256i *)(row + i), _mm256_min_epi16(h, h_max));
+	}
+	SmoothSlopesLimitSSE2(row + i, other + i, count - i, dh);
+}
+
+/*
+ * Limiting the heights in order is a prefix scan: every height becomes the minimum
+ * of all heights before it plus dh for every step between them. Within a block of
+ * eight heights it is done by limiting to the heights one, two and four steps before,
+ * each time on the already limited heights. Lanes without a height before them in
+ * the block get a height that limits nothing. Heights of the map generation are far
+ * below it, so none of the additions wrap and the result is exactly that of the loop.
+ */
+
+GNU_TARGET("sse2")
+void SmoothSlopesForwardSSE2(int16 *row, uint count, int16 dh)
+{
+	if (count == 0) return;
+
+	const int16 none = INT16_MAX - 8 * dh;
+	const __m128i fill1 = _mm_setr_epi16(none, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i fill2 = _mm_setr_epi16(none, none, 0, 0, 0, 0, 0, 0);
+	const __m128i fill4 = _mm_setr_epi16(none, none, none, none, 0, 0, 0, 0);
+	const __m128i dh1 = _mm_set1_epi16(dh);
+	const __m128i dh2 = _mm_set1_epi16(2 * dh);
+	const __m128i dh4 = _mm_set1_epi16(4 * dh);
+	const __m128i steps = _mm_setr_epi16(dh, 2 * dh, 3 * dh, 4 * dh, 5 * dh, 6 * dh, 7 * dh, 8 * dh);
+
+	int16 carry = row[0];
+	uint i = 1;
+	for (; i + 8 <= count; i += 8) {
+		__m128i h = _mm_loadu_si128((const __m128i *)(row + i));
+		h = _mm_min_epi16(h, _mm_add_epi16(_mm_or_si128(_mm_slli_si128(h, 2), fill1), dh1));
+		h = _mm_min_epi16(h, _mm_add_epi16(_mm_or_si128(_mm_slli_si128(h, 4), fill2), dh2));
+		h = _mm_min_epi16(h, _mm_add_epi16(_mm_or_si128(_mm_slli_si128(h, 8), fill4), dh4));
+		h = _mm_min_epi16(h, _mm_add_epi16(_mm_set1_epi16(carry), steps));
+		_mm_storeu_si128((__m128i *)(row + i), h);
+		carry = (int16)_mm_extract_epi16(h, 7);
+	}
+	for (; i < count; i++) {
+		int16 h_max = row[i - 1] + dh;
+		if (row[i] > h_max) row[i] = h_max;
+	}
+}
+
+GNU_TARGET("sse2")
+void SmoothSlopesBackwardSSE2(int16 *row, uint count, int16 dh)
+{
+	if (count == 0) return;
+
+	const int16 none = INT16_MAX - 8 * dh;
+	const __m128i fill1 = _mm_setr_epi16(0, 0, 0, 0, 0, 0, 0, none);
+	const __m128i fill2 = _mm_setr_epi16(0, 0, 0, 0, 0, 0, none, none);
+	const __m128i fill4 = _mm_setr_epi16(0, 0, 0, 0, none, none, none, none);
+	const __m128i dh1 = _mm_set1_epi16(dh);
+	const __m128i dh2 = _mm_set1_epi16(2 * dh);
+	const __m128i dh4 = _mm_set1_epi16(4 * dh);
+	const __m128i steps = _mm_setr_epi16(8 * dh, 7 * dh, 6 * dh, 5 * dh, 4 * dh, 3 * dh, 2 * dh, dh);
+
+	/* The heights from 'end' onwards are done. */
+	uint end = count - 1;
+	int16 carry = row[end];
+	for (; end >= 8; end -= 8) {
+		__m128i h = _mm_loadu_si128((const __m128i *)(row + end - 8));
+		h = _mm_min_epi16(h, _mm_add_epi16(_mm_or_si128(_mm_srli_si128(h, 2), fill1), dh1));
+		h = _mm_min_epi16(h, _mm_add_epi16(_mm_or_si128(_mm_srli_si128(h, 4), fill2), dh2));
+		h = _mm_min_epi16(h, _mm_add_epi16(_mm_or_si128(_mm_srli_si128(h, 8), fill4), dh4));
+		h = _mm_min_epi16(h, _mm_add_epi16(_mm_set1_epi16(carry), steps));
+		_mm_storeu_si128((__m128i *)(row + end - 8), h);
+		carry = (int16)_mm_extract_epi16(h, 0);
+	}
+	while (end > 0) {
+		end--;
+		int16 h_max = row[end + 1] + dh;
+		if (row[end] > h_max) row[end] = h_max;
+	}
+}
+
+#endif /* WITH_SSE */
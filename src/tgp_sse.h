@@ -0,0 +1,59 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tgp_sse.h Vectorised kernels of the Perlin noise enhanced map generator. */
+
+#ifndef TGP_SSE_H
+#define TGP_SSE_H
+
+/**
+ * Calculate the coast noise for a number of points.
+ * @param x The x coordinates of the points.
+ * @param y The y coordinates of the points.
+ * @param p The persistence of the noise.
+ * @param prime The prime selecting the series of random numbers.
+ * @param seed The generation seed.
+ * @param[out] out The noise of the points.
+ * @param count The number of points.
+ */
+typedef void PerlinCoastNoiseProc(const double *x, const double *y, double p, int prime, uint32 seed, double *out, uint count);
+
+/**
+ * Limit every height of a row to a height of the same column in another row plus a difference.
+ * @param row The row to limit.
+ * @param other The row with the limiting heights.
+ * @param count The number of heights.
+ * @param dh The allowed difference.
+ */
+typedef void SmoothSlopesLimitProc(int16 *row, const int16 *other, uint count, int16 dh);
+
+/**
+ * Limit every height of a row to the height before it, respectively after it, plus a difference.
+ * The heights are limited in order, so a limited height limits the next one.
+ * @param row The row to limit.
+ * @param count The number of heights.
+ * @param dh The allowed difference.
+ */
+typedef void SmoothSlopesScanProc(int16 *row, uint count, int16 dh);
+
+#ifdef WITH_SSE
+
+/* The noise is calculated in doubles, so it is only identical to the scalar
+ * code when that does not use the x87 FPU, as is the case for 64 bits. */
+#ifdef POINTER_IS_64BIT
+PerlinCoastNoiseProc PerlinCoastNoiseSSE2;
+PerlinCoastNoiseProc PerlinCoastNoiseAVX2;
+#endif /* POINTER_IS_64BIT */
+
+SmoothSlopesLimitProc SmoothSlopesLimitSSE2;
+SmoothSlopesLimitProc SmoothSlopesLimitAVX2;
+SmoothSlopesScanProc SmoothSlopesForwardSSE2;
+SmoothSlopesScanProc SmoothSlopesBackwardSSE2;
+
+#endif /* WITH_SSE */
+
+#endif /* TGP_SSE_H */
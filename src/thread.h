@@ -12,9 +12,11 @@
 
 #include "debug.h"
 #include "crashlog.h"
+#include <atomic>
 #include <system_error>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 /**
  * Sleep on the current thread for a defined time.
@@ -84,4 +86,33 @@ inline bool StartNewThread(std::thread *thr, const char *name, TFn&& _Fx, TArgs&
 	return false;
 }
 
+/**
+ * Call a function for every index from 0 up to \a count, spread over as many threads as there are processors,
+ * and wait until all calls have finished. The calls may be made in any order and concurrently, so they must
+ * not modify shared state. When no threads can be started all calls are made on the current thread.
+ * @tparam TFn Type of the function to call.
+ * @param name Name of the worker threads.
+ * @param count Number of indices to call the function for.
+ * @param fn Function to call with each index.
+ */
+template<class TFn>
+inline void ParallelFor(const char *name, size_t count, TFn &&fn)
+{
+	std::atomic<size_t> next(0);
+	auto worker = [&]() {
+		for (size_t i = next++; i < count; i = next++) fn(i);
+	};
+
+	std::vector<std::thread> threads;
+	size_t num_threads = std::min<size_t>(count, std::thread::hardware_concurrency());
+	for (size_t i = 1; i < num_threads; i++) {
+		std::thread t;
+		if (!StartNewThread(&t, name, [&worker]() { worker(); })) break;
+		threads.push_back(std::move(t));
+	}
+
+	worker();
+	for (std::thread &t : threads) t.join();
+}
+
 #endif /* THREAD_H */
@@ -0,0 +1,185 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tile_journal.cpp Journal of the blocks of tiles of the map that changed, for caches of data about the map. */
+
+#include "stdafx.h"
+#include "map_func.h"
+#include "tile_journal.h"
+#include "core/bitmath_func.hpp"
+
+#include "safeguards.h"
+
+bool _tile_journal_active = false;       ///< Whether there are readers of all changes, so all changes have to be recorded.
+bool _tile_journal_types_active = false; ///< Whether there are readers of the journal, so changes of the types of tiles have to be recorded.
+
+static TileJournalReader *_first_tile_journal_reader = nullptr; ///< The first of the readers of the journal.
+
+/**
+ * The changed blocks, in order of change, shifted up by one bit; the lowest bit
+ * tells whether the type of a tile changed. A block is only recorded again
+ * after a reader has read the journal. So until anyone reads the journal,
+ * every block is in it at most twice: once for a change of a type, once for any other change.
+ */
+static std::vector<uint32> _tile_journal;
+static uint64 _tile_journal_start = 0;              ///< Position of the first change in the journal, counted from the start of the game.
+static std::vector<uint32> _tile_block_epochs;      ///< For every block, the epoch in which it was last recorded in the journal.
+static std::vector<uint32> _tile_block_type_epochs; ///< For every block, the epoch in which it was last recorded in the journal for a change of a type.
+static uint32 _tile_journal_epoch = 1;              ///< The epoch; it goes up every time the journal is read.
+
+/** Number of blocks of tiles along the X axis. */
+static inline uint GetTileJournalBlocksX() { return MapSizeX() / TILE_JOURNAL_BLOCK_SIZE; }
+
+/** Drop the changes from the journal all readers have read. */
+void TrimTileJournal()
+{
+	uint64 end = _tile_journal_start + _tile_journal.size();
+	uint64 first = end;
+	for (const TileJournalReader *reader = _first_tile_journal_reader; reader != nullptr; reader = reader->next) {
+		first = std::min(first, reader->position);
+	}
+	if (first <= _tile_journal_start) return;
+
+	_tile_journal.erase(_tile_journal.begin(), _tile_journal.begin() + (first - _tile_journal_start));
+	_tile_journal_start = first;
+}
+
+/** Work out which changes have to be recorded for the readers of the journal. */
+void UpdateTileJournalActive()
+{
+	_tile_journal_active = false;
+	_tile_journal_types_active = false;
+	for (const TileJournalReader *reader = _first_tile_journal_reader; reader != nullptr; reader = reader->next) {
+		_tile_journal_types_active = true;
+		if (!reader->types_only) _tile_journal_active = true;
+	}
+}
+
+/**
+ * Start reading the changes from now on.
+ * @param types_only Whether to only read the changes of the types of tiles;
+ *                   then the other changes do not have to be recorded for this reader.
+ */
+void TileJournalReader::Start(bool types_only)
+{
+	if (this->reading) return;
+
+	this->next = _first_tile_journal_reader;
+	_first_tile_journal_reader = this;
+	this->position = _tile_journal_start + _tile_journal.size();
+	this->reading = true;
+	this->types_only = types_only;
+	this->lost = false;
+	UpdateTileJournalActive();
+	/* Blocks recorded before are not recorded again till the next epoch, but this reader starts after them. */
+	_tile_journal_epoch++;
+}
+
+/** Remove this reader from the readers of the journal. */
+void TileJournalReader::Unlink()
+{
+	if (!this->reading) return;
+
+	for (TileJournalReader **reader = &_first_tile_journal_reader; *reader != nullptr; reader = &(*reader)->next) {
+		if (*reader == this) {
+			*reader = this->next;
+			break;
+		}
+	}
+	this->next = nullptr;
+	this->reading = false;
+	UpdateTileJournalActive();
+}
+
+/** Stop reading the changes. */
+void TileJournalReader::Stop()
+{
+	if (!this->reading) return;
+
+	this->Unlink();
+	TrimTileJournal();
+}
+
+/**
+ * Check whether there are changes this reader did not read yet.
+ * @return True when #ReadChanges would pass any block or return false.
+ */
+bool TileJournalReader::HasChanges() const
+{
+	assert(this->reading);
+	return this->lost || this->position != _tile_journal_start + _tile_journal.size();
+}
+
+/**
+ * Read the changes since the previous time, or since the start of reading.
+ * @param proc Function to call with the northern tile of every block that changed; a block may be passed more than once.
+ * @return False when the changes could not all be kept, or the map was replaced; then everything has to be considered changed.
+ */
+bool TileJournalReader::ReadChanges(const TileJournalProc &proc)
+{
+	assert(this->reading);
+
+	uint64 end = _tile_journal_start + _tile_journal.size();
+	bool complete = !this->lost;
+	if (complete) {
+		const uint blocks_x = GetTileJournalBlocksX();
+		for (size_t i = this->position - _tile_journal_start; i < _tile_journal.size(); i++) {
+			if (this->types_only && !HasBit(_tile_journal[i], 0)) continue;
+			uint32 block = _tile_journal[i] >> 1;
+			proc(TileXY(block % blocks_x * TILE_JOURNAL_BLOCK_SIZE, block / blocks_x * TILE_JOURNAL_BLOCK_SIZE));
+		}
+	}
+
+	this->position = end;
+	this->lost = false;
+	_tile_journal_epoch++;
+	TrimTileJournal();
+	return complete;
+}
+
+/**
+ * Record a change of a tile for the readers of the journal.
+ * @param tile The tile that changed.
+ * @param type_change Whether the type of the tile changed.
+ * @note Use #MarkTileChanged or #MarkTileTypeChanged, which do not do anything when there are no readers.
+ */
+void RecordTileChange(TileIndex tile, bool type_change)
+{
+	uint32 block = TileY(tile) / TILE_JOURNAL_BLOCK_SIZE * GetTileJournalBlocksX() + TileX(tile) / TILE_JOURNAL_BLOCK_SIZE;
+	if (type_change) {
+		/* The readers of all changes read the changes of types as well. */
+		if (_tile_block_type_epochs[block] == _tile_journal_epoch) return;
+		_tile_block_type_epochs[block] = _tile_journal_epoch;
+	} else if (_tile_block_epochs[block] == _tile_journal_epoch) {
+		return;
+	}
+	_tile_block_epochs[block] = _tile_journal_epoch;
+
+	/* With more changes than blocks, it is as cheap to consider everything changed; so drop the changes. */
+	if (_tile_journal.size() >= _tile_block_epochs.size()) {
+		for (TileJournalReader *reader = _first_tile_journal_reader; reader != nullptr; reader = reader->next) {
+			if (reader->position != _tile_journal_start + _tile_journal.size()) reader->lost = true;
+		}
+		_tile_journal_start += _tile_journal.size();
+		_tile_journal.clear();
+	}
+
+	_tile_journal.push_back(block << 1 | (type_change ? 1 : 0));
+}
+
+/** Forget all changes after (re)allocating the map; the readers have to consider everything changed. */
+void ResetTileJournal()
+{
+	for (TileJournalReader *reader = _first_tile_journal_reader; reader != nullptr; reader = reader->next) {
+		reader->lost = true;
+	}
+	_tile_journal_start += _tile_journal.size();
+	_tile_journal.clear();
+	_tile_block_epochs.assign(MapSize() / (TILE_JOURNAL_BLOCK_SIZE * TILE_JOURNAL_BLOCK_SIZE), 0);
+	_tile_block_type_epochs.assign(_tile_block_epochs.size(), 0);
+	_tile_journal_epoch = 1;
+}
@@ -0,0 +1,86 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tile_journal.h Journal of the blocks of tiles of the map that changed, for caches of data about the map. */
+
+#ifndef TILE_JOURNAL_H
+#define TILE_JOURNAL_H
+
+#include "tile_type.h"
+#include <functional>
+
+static const uint TILE_JOURNAL_BLOCK_SIZE = 16; ///< Number of tiles along the edge of a block of tiles of which the changes are journaled together.
+
+/** Callback for TileJournalReader::ReadChanges; called with the northern tile of every changed block. */
+typedef std::function<void(TileIndex tile)> TileJournalProc;
+
+/**
+ * A reader of the journal of changed tiles, which keeps track of how far it has read.
+ * Every reader gets all changes, or only the changes of the types of tiles;
+ * the journal only keeps the changes not everyone has read.
+ * A reader that has not started reading costs nothing.
+ */
+class TileJournalReader {
+	TileJournalReader *next = nullptr; ///< The next reader of the journal.
+	uint64 position = 0;               ///< Position in the journal up to where the changes have been read.
+	bool reading = false;              ///< Whether this reader reads the journal.
+	bool types_only = false;           ///< Whether this reader only reads the changes of the types of tiles.
+	bool lost = false;                 ///< Whether changes have been dropped from the journal before this reader read them.
+
+	void Unlink();
+
+	friend void TrimTileJournal();
+	friend void UpdateTileJournalActive();
+	friend void RecordTileChange(TileIndex tile, bool type_change);
+	friend void ResetTileJournal();
+
+public:
+	/* Only unlink, as readers with static storage may outlive the journal itself. */
+	~TileJournalReader() { this->Unlink(); }
+
+	/**
+	 * Whether this reader reads the journal.
+	 * @return True between #Start and #Stop.
+	 */
+	bool IsReading() const { return this->reading; }
+
+	void Start(bool types_only = false);
+	void Stop();
+	bool HasChanges() const;
+	bool ReadChanges(const TileJournalProc &proc);
+};
+
+extern bool _tile_journal_active;
+extern bool _tile_journal_types_active;
+
+void RecordTileChange(TileIndex tile, bool type_change);
+void ResetTileJournal();
+
+/**
+ * Tell the readers of the journal that a tile changed.
+ * Besides for every tile marked dirty, this is called when an owner of a tile is set,
+ * as that changes without repainting when companies merge or go bankrupt, and when
+ * a reservation of a track is set, as the hash of the game state relies on that.
+ * When there are no readers of all changes, this only checks a flag.
+ * @param tile The tile that changed.
+ */
+static inline void MarkTileChanged(TileIndex tile)
+{
+	if (_tile_journal_active) RecordTileChange(tile, false);
+}
+
+/**
+ * Tell the readers of the journal that the type of a tile changed.
+ * This is recorded for the readers of only these changes too, like the water regions.
+ * @param tile The tile that changed.
+ */
+static inline void MarkTileTypeChanged(TileIndex tile)
+{
+	if (_tile_journal_types_active) RecordTileChange(tile, true);
+}
+
+#endif /* TILE_JOURNAL_H */
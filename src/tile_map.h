@@ -14,6 +14,7 @@
 #include "map_func.h"
 #include "core/bitmath_func.hpp"
 #include "settings_type.h"
+#include "tile_journal.h"
 
 /**
  * Returns the height of a tile
@@ -136,6 +137,7 @@ static inline void SetTileType(TileIndex tile, TileType type)
 	 * the upper edges of the map are also VOID tiles. */
 	assert(IsInnerTile(tile) == (type != MP_VOID));
 	SB(_m[tile].type, 4, 4, type);
+	MarkTileTypeChanged(tile);
 }
 
 /**
@@ -202,6 +204,7 @@ static inline void SetTileOwner(TileIndex tile, Owner owner)
 	assert(!IsTileType(tile, MP_INDUSTRY));
 
 	SB(_m[tile].m1, 0, 5, owner);
+	MarkTileChanged(tile);
 }
 
 /**
@@ -84,7 +84,9 @@ struct Town : TownPool::PoolItem<&_town_pool> {
 
 	uint16 time_until_rebuild;       ///< time until we rebuild a house
 
-	uint16 grow_counter;             ///< counter to count when to grow, value is smaller than or equal to growth_rate
+	uint16 grow_counter;             ///< counter to count when to grow, value is smaller than or equal to growth_rate; only up to date as of #grow_counter_tick while #grow_scheduled
+	uint64 grow_counter_tick;        ///< NOSAVE: Tick of the town growth schedule at which #grow_counter was last brought up to date.
+	bool grow_scheduled;             ///< NOSAVE: Whether the town is in the town growth schedule.
 	uint16 growth_rate;              ///< town growth rate
 
 	byte fund_buildings_months;      ///< fund buildings program in action?
@@ -101,7 +103,7 @@ struct Town : TownPool::PoolItem<&_town_pool> {
 	 * Creates a new town.
 	 * @param tile center tile of the town
 	 */
-	Town(TileIndex tile = INVALID_TILE) : xy(tile) { }
+	Town(TileIndex tile = INVALID_TILE) : xy(tile), grow_counter_tick(0), grow_scheduled(false) { }
 
 	/** Destroy the town. */
 	~Town();
@@ -151,6 +153,8 @@ void ShowTownViewWindow(TownID town);
 void ExpandTown(Town *t);
 
 void RebuildTownKdtree();
+void RebuildTownGrowthSchedule();
+void SyncTownGrowCounter(Town *t);
 
 /** Settings for town council attitudes. */
 enum TownCouncilAttitudes {
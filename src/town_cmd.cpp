@@ -74,6 +74,79 @@ void RebuildTownKdtree()
 	_town_kdtree.Build(townids.begin(), townids.end());
 }
 
+/** Number of ticks the town growth schedule has advanced, see #OnTick_Town. */
+static uint64 _town_growth_tick = 0;
+
+/**
+ * Growing towns, ordered by the tick at which their grow counter runs out
+ * and then by town index, which is the order a loop over all towns visits them.
+ */
+static std::set<std::pair<uint64, TownID>> _town_growth_schedule;
+
+/**
+ * Get the tick at which the grow counter of a scheduled town runs out.
+ * @param t The town.
+ * @return The tick of the town growth schedule the town has to act in.
+ */
+static inline uint64 GetTownGrowthDueTick(const Town *t)
+{
+	return t->grow_counter_tick + t->grow_counter + 1;
+}
+
+/**
+ * Bring the grow counter of a town up to date with the town growth schedule.
+ * This does not change when the town is going to grow.
+ * @param t The town.
+ */
+void SyncTownGrowCounter(Town *t)
+{
+	if (!t->grow_scheduled) return;
+
+	/* Towns due in the current tick but not yet handled still have their counter at zero. */
+	uint64 elapsed = std::min<uint64>(_town_growth_tick - t->grow_counter_tick, t->grow_counter);
+	t->grow_counter -= (uint16)elapsed;
+	t->grow_counter_tick += elapsed;
+}
+
+/**
+ * Remove a town from the town growth schedule, so its grow counter and growth flag can be changed.
+ * @param t The town.
+ */
+static void UnscheduleTownGrowth(Town *t)
+{
+	if (!t->grow_scheduled) return;
+
+	_town_growth_schedule.erase(std::make_pair(GetTownGrowthDueTick(t), t->index));
+	SyncTownGrowCounter(t);
+	t->grow_scheduled = false;
+}
+
+/**
+ * Add a town to the town growth schedule if it is growing.
+ * @param t The town, which may not be scheduled already.
+ */
+static void ScheduleTownGrowth(Town *t)
+{
+	assert(!t->grow_scheduled);
+	if (!HasBit(t->flags, TOWN_IS_GROWING)) return;
+
+	t->grow_counter_tick = _town_growth_tick;
+	t->grow_scheduled = true;
+	_town_growth_schedule.emplace(GetTownGrowthDueTick(t), t->index);
+}
+
+/**
+ * Rebuild the town growth schedule from the grow counters of all towns.
+ */
+void RebuildTownGrowthSchedule()
+{
+	_town_growth_schedule.clear();
+	for (Town *t : Town::Iterate()) {
+		t->grow_scheduled = false;
+		ScheduleTownGrowth(t);
+	}
+}
+
 
 /**
  * Check if a town 'owns' a bridge.
@@ -104,6 +177,8 @@ Town::~Town()
 {
 	if (CleaningPool()) return;
 
+	UnscheduleTownGrowth(this);
+
 	/* Delete town authority window
 	 * and remove from list of sorted towns */
 	CloseWindowById(WC_TOWN_VIEW, this->index);
@@ -813,27 +888,41 @@ static void ChangeTileOwner_Town(TileIndex tile, Owner old_owner, Owner new_owne
 
 static bool GrowTown(Town *t);
 
+/**
+ * Handle a growing town whose grow counter ran out.
+ * @param t The town, which has just been taken from the town growth schedule.
+ */
 static void TownTickHandler(Town *t)
 {
-	if (HasBit(t->flags, TOWN_IS_GROWING)) {
-		int i = (int)t->grow_counter - 1;
-		if (i < 0) {
-			if (GrowTown(t)) {
-				i = t->growth_rate;
-			} else {
-				/* If growth failed wait a bit before retrying */
-				i = std::min<uint16>(t->growth_rate, TOWN_GROWTH_TICKS - 1);
-			}
-		}
-		t->grow_counter = i;
+	uint16 i;
+	if (GrowTown(t)) {
+		i = t->growth_rate;
+	} else {
+		/* If growth failed wait a bit before retrying */
+		i = std::min<uint16>(t->growth_rate, TOWN_GROWTH_TICKS - 1);
 	}
+
+	/* Growing may have rescheduled the town, but the new counter always wins. */
+	UnscheduleTownGrowth(t);
+	t->grow_counter = i;
+	ScheduleTownGrowth(t);
 }
 
 void OnTick_Town()
 {
 	if (_game_mode == GM_EDITOR) return;
 
-	for (Town *t : Town::Iterate()) {
+	_town_growth_tick++;
+
+	/* Only towns whose grow counter runs out in this tick have to do
+	 * something; they are handled in the order of their index. */
+	while (!_town_growth_schedule.empty() && _town_growth_schedule.begin()->first <= _town_growth_tick) {
+		Town *t = Town::Get(_town_growth_schedule.begin()->second);
+		_town_growth_schedule.erase(_town_growth_schedule.begin());
+		t->grow_counter = 0;
+		t->grow_counter_tick = _town_growth_tick;
+		t->grow_scheduled = false;
+
 		TownTickHandler(t);
 	}
 }
@@ -2174,48 +2263,72 @@ static TileIndex FindNearestGoodCoastalTownSpot(TileIndex tile, TownLayout layou
 	return INVALID_TILE;
 }
 
-static Town *CreateRandomTown(uint attempts, uint32 townnameparts, TownSize size, bool city, TownLayout layout)
+/**
+ * Find the tile to place a random town at.
+ * @param tile The random tile.
+ * @param layout The road layout of the town.
+ * @return The tile to place the town at, or \c INVALID_TILE when no town can be placed.
+ */
+static TileIndex FindRandomTownSpot(TileIndex tile, TownLayout layout)
 {
-	assert(_game_mode == GM_EDITOR || _generating_world); // These are the preconditions for CMD_DELETE_TOWN
+	/* Generate a tile index not too close from the edge */
+	tile = AlignTileToGrid(tile, layout);
 
-	if (!Town::CanAllocateItem()) return nullptr;
-
-	do {
-		/* Generate a tile index not too close from the edge */
-		TileIndex tile = AlignTileToGrid(RandomTile(), layout);
+	/* if we tried to place the town on water, slide it over onto
+	 * the nearest likely-looking spot */
+	if (IsTileType(tile, MP_WATER)) {
+		tile = FindNearestGoodCoastalTownSpot(tile, layout);
+		if (tile == INVALID_TILE) return INVALID_TILE;
+	}
 
-		/* if we tried to place the town on water, slide it over onto
-		 * the nearest likely-looking spot */
-		if (IsTileType(tile, MP_WATER)) {
-			tile = FindNearestGoodCoastalTownSpot(tile, layout);
-			if (tile == INVALID_TILE) continue;
-		}
+	/* Make sure town can be placed here */
+	if (TownCanBePlacedHere(tile).Failed()) return INVALID_TILE;
 
-		/* Make sure town can be placed here */
-		if (TownCanBePlacedHere(tile).Failed()) continue;
+	return tile;
+}
 
-		/* Allocate a town struct */
-		Town *t = new Town(tile);
+static Town *CreateRandomTown(uint attempts, uint32 townnameparts, TownSize size, bool city, TownLayout layout)
+{
+	assert(_game_mode == GM_EDITOR || _generating_world); // These are the preconditions for CMD_DELETE_TOWN
 
-		DoCreateTown(t, tile, townnameparts, size, city, layout, false);
+	if (!Town::CanAllocateItem()) return nullptr;
 
-		/* if the population is still 0 at the point, then the
-		 * placement is so bad it couldn't grow at all */
-		if (t->cache.population > 0) return t;
+	/* Finding a spot only reads the map, so the random tiles are checked in parallel.
+	 * A town that could not grow is deleted again, which changes the map. */
+	Town *town = nullptr;
+	TryRandomTiles(attempts, 0,
+		[layout](TileIndex tile, Randomizer random) {
+			return FindRandomTownSpot(tile, layout) != INVALID_TILE;
+		},
+		[&town, townnameparts, size, city, layout](TileIndex tile) {
+			tile = FindRandomTownSpot(tile, layout);
+
+			/* Allocate a town struct */
+			Town *t = new Town(tile);
+
+			DoCreateTown(t, tile, townnameparts, size, city, layout, false);
+
+			/* if the population is still 0 at the point, then the
+			 * placement is so bad it couldn't grow at all */
+			if (t->cache.population > 0) {
+				town = t;
+				return true;
+			}
 
-		Backup<CompanyID> cur_company(_current_company, OWNER_TOWN, FILE_LINE);
-		[[maybe_unused]] CommandCost rc = Command<CMD_DELETE_TOWN>::Do(DC_EXEC, t->index);
-		cur_company.Restore();
-		assert(rc.Succeeded());
+			Backup<CompanyID> cur_company(_current_company, OWNER_TOWN, FILE_LINE);
+			[[maybe_unused]] CommandCost rc = Command<CMD_DELETE_TOWN>::Do(DC_EXEC, t->index);
+			cur_company.Restore();
+			assert(rc.Succeeded());
 
-		/* We already know that we can allocate a single town when
-		 * entering this function. However, we create and delete
-		 * a town which "resets" the allocation checks. As such we
-		 * need to check again when assertions are enabled. */
-		assert(Town::CanAllocateItem());
-	} while (--attempts != 0);
+			/* We already know that we can allocate a single town when
+			 * entering this function. However, we create and delete
+			 * a town which "resets" the allocation checks. As such we
+			 * need to check again when assertions are enabled. */
+			assert(Town::CanAllocateItem());
+			return false;
+		}, true);
 
-	return nullptr;
+	return town;
 }
 
 static const byte _num_initial_towns[4] = {5, 11, 23, 46};  // very low, low, normal, high
@@ -2877,6 +2990,7 @@ CommandCost CmdTownGrowthRate(DoCommandFlag flags, TownID town_id, uint16 growth
 			/* Just clear the flag, UpdateTownGrowth will determine a proper growth rate */
 			ClrBit(t->flags, TOWN_CUSTOM_GROWTH);
 		} else {
+			UnscheduleTownGrowth(t);
 			uint old_rate = t->growth_rate;
 			if (t->grow_counter >= old_rate) {
 				/* This also catches old_rate == 0 */
@@ -3213,7 +3327,9 @@ static CommandCost TownActionFundBuildings(Town *t, DoCommandFlag flags)
 		 * tick-perfect and gives player some time window where they can
 		 * spam funding with the exact same efficiency.
 		 */
+		UnscheduleTownGrowth(t);
 		t->grow_counter = std::min<uint16>(t->grow_counter, 2 * TOWN_GROWTH_TICKS - (t->growth_rate - t->grow_counter) % TOWN_GROWTH_TICKS);
+		ScheduleTownGrowth(t);
 
 		SetWindowDirty(WC_TOWN_VIEW, t->index);
 	}
@@ -3481,49 +3597,55 @@ static void UpdateTownGrowthRate(Town *t)
 	if (HasBit(t->flags, TOWN_CUSTOM_GROWTH)) return;
 	uint old_rate = t->growth_rate;
 	t->growth_rate = GetNormalGrowthRate(t);
+	UnscheduleTownGrowth(t);
 	UpdateTownGrowCounter(t, old_rate);
+	ScheduleTownGrowth(t);
 	SetWindowDirty(WC_TOWN_VIEW, t->index);
 }
 
 /**
- * Updates town growth state (whether it is growing or not).
- * @param t The town to update growth for
+ * Checks whether the conditions for town growth are met.
+ * @param t The town to check.
+ * @return True iff the town should be growing.
  */
-static void UpdateTownGrowth(Town *t)
+static bool CheckTownGrowth(Town *t)
 {
-	UpdateTownGrowthRate(t);
-
-	ClrBit(t->flags, TOWN_IS_GROWING);
-	SetWindowDirty(WC_TOWN_VIEW, t->index);
-
-	if (_settings_game.economy.town_growth_rate == 0 && t->fund_buildings_months == 0) return;
+	if (_settings_game.economy.town_growth_rate == 0 && t->fund_buildings_months == 0) return false;
 
 	if (t->fund_buildings_months == 0) {
 		/* Check if all goals are reached for this town to grow (given we are not funding it) */
 		for (int i = TE_BEGIN; i < TE_END; i++) {
 			switch (t->goal[i]) {
 				case TOWN_GROWTH_WINTER:
-					if (TileHeight(t->xy) >= GetSnowLine() && t->received[i].old_act == 0 && t->cache.population > 90) return;
+					if (TileHeight(t->xy) >= GetSnowLine() && t->received[i].old_act == 0 && t->cache.population > 90) return false;
 					break;
 				case TOWN_GROWTH_DESERT:
-					if (GetTropicZone(t->xy) == TROPICZONE_DESERT && t->received[i].old_act == 0 && t->cache.population > 60) return;
+					if (GetTropicZone(t->xy) == TROPICZONE_DESERT && t->received[i].old_act == 0 && t->cache.population > 60) return false;
 					break;
 				default:
-					if (t->goal[i] > t->received[i].old_act) return;
+					if (t->goal[i] > t->received[i].old_act) return false;
 					break;
 			}
 		}
 	}
 
-	if (HasBit(t->flags, TOWN_CUSTOM_GROWTH)) {
-		if (t->growth_rate != TOWN_GROWTH_RATE_NONE) SetBit(t->flags, TOWN_IS_GROWING);
-		SetWindowDirty(WC_TOWN_VIEW, t->index);
-		return;
-	}
+	if (HasBit(t->flags, TOWN_CUSTOM_GROWTH)) return t->growth_rate != TOWN_GROWTH_RATE_NONE;
 
-	if (t->fund_buildings_months == 0 && CountActiveStations(t) == 0 && !Chance16(1, 12)) return;
+	return t->fund_buildings_months != 0 || CountActiveStations(t) != 0 || Chance16(1, 12);
+}
+
+/**
+ * Updates town growth state (whether it is growing or not).
+ * @param t The town to update growth for
+ */
+static void UpdateTownGrowth(Town *t)
+{
+	UpdateTownGrowthRate(t);
 
-	SetBit(t->flags, TOWN_IS_GROWING);
+	UnscheduleTownGrowth(t);
+	ClrBit(t->flags, TOWN_IS_GROWING);
+	if (CheckTownGrowth(t)) SetBit(t->flags, TOWN_IS_GROWING);
+	ScheduleTownGrowth(t);
 	SetWindowDirty(WC_TOWN_VIEW, t->index);
 }
 
@@ -90,6 +90,7 @@
 #include "framerate_type.h"
 #include "viewport_cmd.h"
 #include "build_confirmation_func.h"
+#include "tile_journal.h"
 
 #include <forward_list>
 #include <map>
@@ -1998,6 +1999,8 @@ void ConstrainAllViewportsZoom()
  */
 void MarkTileDirtyByTile(TileIndex tile, int bridge_level_offset, int tile_height_override)
 {
+	MarkTileChanged(tile);
+
 	Point pt = RemapCoords(TileX(tile) * TILE_SIZE, TileY(tile) * TILE_SIZE, tile_height_override * TILE_HEIGHT);
 	MarkAllViewportsDirty(
 			pt.x - MAX_TILE_EXTENT_LEFT,